@@ -28,6 +28,7 @@ map<string, base::VectorXd> evaluateScene(WbcScenePtr scene, int n_samples){
 
     base::VectorXd time_scene_update(n_samples);
     base::VectorXd time_scene_solve(n_samples);
+    base::VectorXd recovered_samples = base::VectorXd::Zero(n_samples);
     for(int i = 0; i < n_samples; i++){
         for(auto w : scene->getWbcConfig())
             scene->setReference(w.name, randomConstraintReference());
@@ -40,44 +41,41 @@ map<string, base::VectorXd> evaluateScene(WbcScenePtr scene, int n_samples){
         HierarchicalQP qp = scene->update();
         time_scene_update[i] = (double)(base::Time::now()-start).toMicroseconds();
 
-        try{
-            start = base::Time::now();
-            scene->solve(qp);
-            time_scene_solve[i] = (double)(base::Time::now()-start).toMicroseconds();
-        }
-        catch(exception e){
-            cout<<"Exception"<<endl;
-            i--;
-            usleep(0.01*1e6);
-            scene->getSolver()->reset();
-            continue;
-        }
+        // The solvers use recover_last_solution, so that the scene only throws if there is no valid solution at all
+        start = base::Time::now();
+        scene->solve(qp);
+        time_scene_solve[i] = (double)(base::Time::now()-start).toMicroseconds();
+        recovered_samples[i] = scene->getSolverStatus() == solver_recovered;
         usleep(0.01*1e6);
     }
 
     map<string, base::VectorXd> results;
     results["scene_update"] = time_scene_update;
     results["scene_solve"]  = time_scene_solve;
+    results["solver_recovered"] = recovered_samples;
     return results;
 }
 
 void printResults(map<string,base::VectorXd> results){
     cout << "Scene Update     " << results["scene_update"].mean()/1000 << " ms +/- " << stdDev(results["scene_update"]/1000) << endl;
     cout << "Scene Solve      " << results["scene_solve"].mean()/1000 << " ms +/- " << stdDev(results["scene_solve"]/1000) << endl;
+    cout << "Recovered        " << results["solver_recovered"].sum() << " of " << results["solver_recovered"].size() << " samples" << endl;
 }
 
-map<string,base::VectorXd> evaluateVelocitySceneQuadraticCost(RobotModelPtr robot_model, const std::string &root, const std::string &tip, int n_samples){
+map<string,base::VectorXd> evaluateVelocitySceneQuadraticCost(RobotModelPtr robot_model, const std::string &root, const std::string &tip, int n_samples, bool use_box_qp_solver = true){
     QPSolverPtr solver = std::make_shared<QPOASESSolver>();
     (dynamic_pointer_cast<QPOASESSolver>(solver))->setMaxNoWSR(1000);
     qpOASES::Options options;
     options.setToFast();
     options.printLevel = qpOASES::PL_NONE;
     (dynamic_pointer_cast<QPOASESSolver>(solver))->setOptions(options);
+    (dynamic_pointer_cast<QPOASESSolver>(solver))->setRecoveryPolicy(recover_last_solution);
 
     ConstraintConfig cart_constraint("cart_pos_ctrl",0,root,tip,root,1);
     WbcScenePtr scene = std::make_shared<VelocitySceneQuadraticCost>(robot_model, solver);
     if(!scene->configure({cart_constraint}))
         throw std::runtime_error("Failed to configure VelocitySceneQuadraticCost");
+    (dynamic_pointer_cast<VelocitySceneQuadraticCost>(scene))->setUseBoxQPSolver(use_box_qp_solver);
     return evaluateScene(scene, n_samples);
 }
 
@@ -88,6 +86,7 @@ map<string,base::VectorXd> evaluateAccelerationSceneTSID(RobotModelPtr robot_mod
     options.setToFast();
     options.printLevel = qpOASES::PL_NONE;
     (dynamic_pointer_cast<QPOASESSolver>(solver))->setOptions(options);
+    (dynamic_pointer_cast<QPOASESSolver>(solver))->setRecoveryPolicy(recover_last_solution);
 
     ConstraintConfig cart_constraint("cart_pos_ctrl",0,root,tip,root,1);
     WbcScenePtr scene = std::make_shared<AccelerationSceneTSID>(robot_model, solver);
@@ -113,17 +112,21 @@ void runKUKAIiwaBenchmarks(int n_samples){
         throw std::runtime_error("Failed to configure RobotModelHyrodyn");
 
     map<string,base::VectorXd> results_kdl_vel = evaluateVelocitySceneQuadraticCost(robot_model_kdl, root, tip, n_samples);
+    map<string,base::VectorXd> results_kdl_vel_qp = evaluateVelocitySceneQuadraticCost(robot_model_kdl, root, tip, n_samples, false);
     map<string,base::VectorXd> results_hyrodyn_vel = evaluateVelocitySceneQuadraticCost(robot_model_hyrodyn, root, tip, n_samples);
     map<string,base::VectorXd> results_kdl_acc = evaluateAccelerationSceneTSID(robot_model_kdl, root, tip, n_samples);
     map<string,base::VectorXd> results_hyrodyn_acc = evaluateAccelerationSceneTSID(robot_model_hyrodyn, root, tip, n_samples);
 
     toCSV(results_kdl_vel, "results/kuka_iiwa_vel_kdl.csv");
+    toCSV(results_kdl_vel_qp, "results/kuka_iiwa_vel_kdl_qpoases.csv");
     toCSV(results_hyrodyn_vel, "results/kuka_iiwa_vel_hyrodyn.csv");
     toCSV(results_kdl_acc, "results/kuka_iiwa_acc_kdl.csv");
     toCSV(results_hyrodyn_acc, "results/kuka_iiwa_acc_hyrodyn.csv");
 
     cout << " ----------- Results VelocitySceneQuadraticCost (RobotModelKDL) -----------" << endl;
     printResults(results_kdl_vel);
+    cout << " ----------- Results VelocitySceneQuadraticCost (RobotModelKDL, qpOASES instead of projected Newton) -----------" << endl;
+    printResults(results_kdl_vel_qp);
     cout << " ----------- Results VelocitySceneQuadraticCost (RobotModelHyrodyn) -----------" << endl;
     printResults(results_hyrodyn_vel);
     cout << " ----------- Results AccelerationSceneTSID (RobotModelKDL) -----------" << endl;
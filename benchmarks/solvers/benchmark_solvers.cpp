@@ -0,0 +1,213 @@
+#include <core/QuadraticProgram.hpp>
+#include <solvers/hls/HierarchicalLSSolver.hpp>
+#include <solvers/qpoases/QPOasesCascadeSolver.hpp>
+#include <solvers/sns/SNSSolver.hpp>
+#include <robot_models/kdl/RobotModelKDL.hpp>
+#include <scenes/VelocityScene.hpp>
+#include <boost/filesystem.hpp>
+#include <iostream>
+#include "../benchmarks_common.hpp"
+
+using namespace wbc;
+using namespace std;
+
+/** Random hierarchical QP with equality tasks, interpreted in the same way by both solvers*/
+HierarchicalQP randomHierarchicalQP(int nq, const vector<int>& rows_per_prio){
+    HierarchicalQP hqp;
+    hqp.resize(rows_per_prio.size());
+    for(uint prio = 0; prio < rows_per_prio.size(); prio++){
+        QuadraticProgram& qp = hqp[prio];
+        qp.resize(rows_per_prio[prio], nq);
+        qp.A.setRandom();
+        qp.lower_y.setRandom();
+        qp.upper_y = qp.lower_y;
+        qp.Wy.setOnes(qp.nc);
+        qp.lower_x.resize(0);
+        qp.upper_x.resize(0);
+        qp.H.setIdentity();
+        qp.g.setZero();
+    }
+    hqp.Wq.setOnes(nq);
+    return hqp;
+}
+
+/** Small perturbation of the given problem, as it occurs between two consecutive control cycles*/
+void perturb(HierarchicalQP& hqp){
+    for(uint prio = 0; prio < hqp.size(); prio++){
+        QuadraticProgram& qp = hqp[prio];
+        for(int i = 0; i < qp.A.size(); i++)
+            qp.A.data()[i] += whiteNoise(1e-3);
+        for(int i = 0; i < qp.nc; i++)
+            qp.lower_y[i] += whiteNoise(1e-3);
+        qp.upper_y = qp.lower_y;
+    }
+}
+
+map<string, base::VectorXd> evaluateSolvers(int nq, const vector<int>& rows_per_prio, int n_samples){
+
+    HierarchicalLSSolver hls_solver;
+    QPOASESCascadeSolver cascade_solver;
+    cascade_solver.setMaxNoWSR(1000);
+    qpOASES::Options options;
+    options.setToFast();
+    options.printLevel = qpOASES::PL_NONE;
+    cascade_solver.setOptions(options);
+
+    base::VectorXd time_hls(n_samples), time_cascade(n_samples), solution_diff(n_samples);
+    HierarchicalQP hqp = randomHierarchicalQP(nq, rows_per_prio);
+    base::VectorXd hls_output, cascade_output;
+    for(int i = 0; i < n_samples; i++){
+        perturb(hqp);
+
+        base::Time start = base::Time::now();
+        hls_solver.solve(hqp, hls_output);
+        time_hls[i] = (double)(base::Time::now()-start).toMicroseconds();
+
+        start = base::Time::now();
+        cascade_solver.solve(hqp, cascade_output);
+        time_cascade[i] = (double)(base::Time::now()-start).toMicroseconds();
+
+        solution_diff[i] = (hls_output - cascade_output).norm();
+    }
+
+    map<string, base::VectorXd> results;
+    results["hls_solve"]     = time_hls;
+    results["cascade_solve"] = time_cascade;
+    results["solution_diff"] = solution_diff;
+    return results;
+}
+
+void printResults(map<string,base::VectorXd> results){
+    cout << "HLS Solve        " << results["hls_solve"].mean()/1000 << " ms +/- " << stdDev(results["hls_solve"]/1000) << endl;
+    cout << "Cascade Solve    " << results["cascade_solve"].mean()/1000 << " ms +/- " << stdDev(results["cascade_solve"]/1000) << endl;
+    cout << "Solution Diff    " << results["solution_diff"].mean() << " +/- " << stdDev(results["solution_diff"]) << endl;
+}
+
+/** Largest violation of the joint bounds of the given hierarchical QP*/
+double boundViolation(const HierarchicalQP& hqp, const base::VectorXd& solver_output){
+    double violation = 0;
+    for(uint prio = 0; prio < hqp.size(); prio++){
+        const QuadraticProgram& qp = hqp[prio];
+        for(int i = 0; i < qp.lower_x.size(); i++)
+            violation = max(violation, qp.lower_x[i] - solver_output[i]);
+        for(int i = 0; i < qp.upper_x.size(); i++)
+            violation = max(violation, solver_output[i] - qp.upper_x[i]);
+    }
+    return violation;
+}
+
+/** Compare SNSSolver and QPOASESCascadeSolver on a velocity scene with a Cartesian task (priority 0) and a joint velocity task (priority 1), where
+ *  the joint speed limits of the robot are used as joint bounds*/
+map<string, base::VectorXd> evaluateJointLimitSolvers(RobotModelPtr robot_model, const std::string &root, const std::string &tip, int n_samples){
+
+    SNSSolver sns_solver;
+    QPOASESCascadeSolver cascade_solver;
+    cascade_solver.setMaxNoWSR(1000);
+    qpOASES::Options options;
+    options.setToFast();
+    options.printLevel = qpOASES::PL_NONE;
+    cascade_solver.setOptions(options);
+
+    const vector<string> joint_names = robot_model->jointNames();
+    ConstraintConfig cart_constraint("cart_pos_ctrl", 0, root, tip, root, 1);
+    ConstraintConfig jnt_constraint("jnt_vel_ctrl", 1, joint_names, vector<double>(joint_names.size(), 1), 1);
+    VelocityScene scene(robot_model, std::make_shared<SNSSolver>());
+    if(!scene.configure({cart_constraint, jnt_constraint}))
+        throw std::runtime_error("Failed to configure VelocityScene");
+    scene.setUseJointLimits(true);
+
+    base::VectorXd time_sns(n_samples), time_cascade(n_samples), solution_diff(n_samples), violation_sns(n_samples), violation_cascade(n_samples);
+    base::VectorXd sns_output, cascade_output;
+    for(int i = 0; i < n_samples; i++){
+        base::samples::RigidBodyStateSE3 cart_ref;
+        for(int j = 0; j < 3; j++){
+            cart_ref.twist.linear[j] = whiteNoise(0.5);
+            cart_ref.twist.angular[j] = whiteNoise(0.5);
+        }
+        cart_ref.time = base::Time::now();
+        base::samples::Joints jnt_ref;
+        jnt_ref.names = joint_names;
+        jnt_ref.elements.resize(joint_names.size());
+        for(auto &js : jnt_ref.elements)
+            js.speed = whiteNoise(1.0);
+        jnt_ref.time = base::Time::now();
+        scene.setReference(cart_constraint.name, cart_ref);
+        scene.setReference(jnt_constraint.name, jnt_ref);
+
+        robot_model->update(randomJointState(robot_model->independentJointNames(), robot_model->jointLimits()));
+        const HierarchicalQP& hqp = scene.update();
+
+        base::Time start = base::Time::now();
+        sns_solver.solve(hqp, sns_output);
+        time_sns[i] = (double)(base::Time::now()-start).toMicroseconds();
+
+        start = base::Time::now();
+        if(cascade_solver.trySolve(hqp, cascade_output) == solver_failed){
+            cascade_solver.reset();
+            i--;
+            continue;
+        }
+        time_cascade[i] = (double)(base::Time::now()-start).toMicroseconds();
+
+        solution_diff[i] = (sns_output - cascade_output).norm();
+        violation_sns[i] = boundViolation(hqp, sns_output);
+        violation_cascade[i] = boundViolation(hqp, cascade_output);
+    }
+
+    map<string, base::VectorXd> results;
+    results["sns_solve"]         = time_sns;
+    results["cascade_solve"]     = time_cascade;
+    results["solution_diff"]     = solution_diff;
+    results["violation_sns"]     = violation_sns;
+    results["violation_cascade"] = violation_cascade;
+    return results;
+}
+
+void printJointLimitResults(map<string,base::VectorXd> results){
+    cout << "SNS Solve        " << results["sns_solve"].mean()/1000 << " ms +/- " << stdDev(results["sns_solve"]/1000) << endl;
+    cout << "Cascade Solve    " << results["cascade_solve"].mean()/1000 << " ms +/- " << stdDev(results["cascade_solve"]/1000) << endl;
+    cout << "Solution Diff    " << results["solution_diff"].mean() << " +/- " << stdDev(results["solution_diff"]) << endl;
+    cout << "Violation SNS    " << results["violation_sns"].maxCoeff() << " (max)" << endl;
+    cout << "Violation Casc.  " << results["violation_cascade"].maxCoeff() << " (max)" << endl;
+}
+
+void runJointLimitBenchmarks(int n_samples){
+    boost::filesystem::create_directory("results");
+
+    // Robot models of the tutorials
+    vector<vector<string> > robots = {{"kuka_iiwa", "../../../models/kuka/urdf/kuka_iiwa.urdf", "kuka_lbr_l_link_0", "kuka_lbr_l_tcp"},
+                                      {"rh5_single_leg", "../../../models/rh5/urdf/rh5_single_leg.urdf", "RH5_Root_Link", "LLAnkle_FT"}};
+    for(auto r : robots){
+        RobotModelPtr robot_model = std::make_shared<RobotModelKDL>();
+        if(!robot_model->configure(RobotModelConfig(r[1])))
+            throw std::runtime_error("Failed to configure RobotModelKDL");
+        map<string,base::VectorXd> results = evaluateJointLimitSolvers(robot_model, r[2], r[3], n_samples);
+        toCSV(results, "results/" + r[0] + "_joint_limits.csv");
+        cout << "--------------- " << r[0] << " (joint limits) ---------------" << endl;
+        printJointLimitResults(results);
+    }
+}
+
+void runBenchmarks(int n_samples){
+    boost::filesystem::create_directory("results");
+
+    // Joints, rows per priority level. All levels together have less rows than joints, so that both solvers have the same unique solution
+    vector<pair<int,vector<int> > > problems = {{7,  {3,3}},
+                                                {12, {6,3,2}},
+                                                {30, {12,6,6,3}},
+                                                {50, {12,12,12,6,6}}};
+    for(auto p : problems){
+        string name = "nq_" + to_string(p.first) + "_prios_" + to_string(p.second.size());
+        map<string,base::VectorXd> results = evaluateSolvers(p.first, p.second, n_samples);
+        toCSV(results, "results/" + name + ".csv");
+        cout << "--------------- " << name << " ---------------" << endl;
+        printResults(results);
+    }
+}
+
+int main(){
+    srand(time(NULL));
+    int n_samples = 1000;
+    runBenchmarks(n_samples);
+    runJointLimitBenchmarks(n_samples);
+}
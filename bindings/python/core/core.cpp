@@ -139,7 +139,8 @@ BOOST_PYTHON_MODULE(core){
    py::enum_<wbc::ConstraintType>("ConstraintType")
        .value("unset", wbc::ConstraintType::unset)
        .value("cart", wbc::ConstraintType::cart)
-       .value("jnt", wbc::ConstraintType::jnt);
+       .value("jnt", wbc::ConstraintType::jnt)
+       .value("com", wbc::ConstraintType::com);
 
    py::class_<wbc::ConstraintConfig>("ConstraintConfig")
             .def_readwrite("name",       &wbc::ConstraintConfig::name)
@@ -54,6 +54,8 @@ BOOST_PYTHON_MODULE(robot_model_hyrodyn){
             .def("hasJoint",                &wbc_py::RobotModelHyrodyn::hasJoint)
             .def("hasActuatedJoint",        &wbc_py::RobotModelHyrodyn::hasActuatedJoint)
             .def("centerOfMass",            &wbc_py::RobotModelHyrodyn::centerOfMass, py::return_value_policy<py::copy_const_reference>())
+            .def("comJacobian",             &wbc_py::RobotModelHyrodyn::comJacobian, py::return_value_policy<py::copy_const_reference>())
+            .def("centroidalMomentumMatrix",&wbc_py::RobotModelHyrodyn::centroidalMomentumMatrix, py::return_value_policy<py::copy_const_reference>())
             .def("setActiveContacts",       &wbc_py::RobotModelHyrodyn::setActiveContacts)
             .def("getActiveContacts",       &wbc_py::RobotModelHyrodyn::getActiveContacts2)
             .def("noOfJoints",              &wbc_py::RobotModelHyrodyn::noOfJoints)
@@ -54,6 +54,8 @@ BOOST_PYTHON_MODULE(robot_model_kdl){
             .def("hasJoint",                &wbc_py::RobotModelKDL::hasJoint)
             .def("hasActuatedJoint",        &wbc_py::RobotModelKDL::hasActuatedJoint)
             .def("centerOfMass",            &wbc_py::RobotModelKDL::centerOfMass, py::return_value_policy<py::copy_const_reference>())
+            .def("comJacobian",             &wbc_py::RobotModelKDL::comJacobian, py::return_value_policy<py::copy_const_reference>())
+            .def("centroidalMomentumMatrix",&wbc_py::RobotModelKDL::centroidalMomentumMatrix, py::return_value_policy<py::copy_const_reference>())
             .def("setActiveContacts",       &wbc_py::RobotModelKDL::setActiveContacts)
             .def("getActiveContacts",       &wbc_py::RobotModelKDL::getActiveContacts2)
             .def("noOfJoints",              &wbc_py::RobotModelKDL::noOfJoints)
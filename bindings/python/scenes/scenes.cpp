@@ -132,6 +132,8 @@ BOOST_PYTHON_MODULE(scenes){
             .def("getConstraintsStatus",   &wbc_py::VelocityScene::getConstraintsStatus,  py::return_value_policy<py::copy_const_reference>())
             .def("getNConstraintVariablesPerPrio",   &wbc_py::VelocityScene::getNConstraintVariablesPerPrio)
             .def("hasConstraint",   &wbc_py::VelocityScene::hasConstraint)
+            .def("getNSkippedConstraints",   &wbc_py::VelocityScene::getNSkippedConstraints)
+            .def("setCompactQP",   &wbc_py::VelocityScene::setCompactQP)
             .def("updateConstraintsStatus",   &wbc_py::VelocityScene::updateConstraintsStatus2)
             .def("getHierarchicalQP",   &wbc_py::VelocityScene::getHierarchicalQP,  py::return_value_policy<py::copy_const_reference>())
             .def("getSolverOutput",   &wbc_py::VelocityScene::getSolverOutput,  py::return_value_policy<py::copy_const_reference>())
@@ -150,6 +152,8 @@ BOOST_PYTHON_MODULE(scenes){
             .def("getConstraintsStatus",   &wbc_py::VelocitySceneQuadraticCost::getConstraintsStatus,  py::return_value_policy<py::copy_const_reference>())
             .def("getNConstraintVariablesPerPrio",   &wbc_py::VelocitySceneQuadraticCost::getNConstraintVariablesPerPrio)
             .def("hasConstraint",   &wbc_py::VelocitySceneQuadraticCost::hasConstraint)
+            .def("getNSkippedConstraints",   &wbc_py::VelocitySceneQuadraticCost::getNSkippedConstraints)
+            .def("setCompactQP",   &wbc_py::VelocitySceneQuadraticCost::setCompactQP)
             .def("updateConstraintsStatus",   &wbc_py::VelocitySceneQuadraticCost::updateConstraintsStatus2)
             .def("getHierarchicalQP",   &wbc_py::VelocitySceneQuadraticCost::getHierarchicalQP,  py::return_value_policy<py::copy_const_reference>())
             .def("getSolverOutput",   &wbc_py::VelocitySceneQuadraticCost::getSolverOutput,  py::return_value_policy<py::copy_const_reference>())
@@ -168,6 +172,8 @@ BOOST_PYTHON_MODULE(scenes){
             .def("getConstraintsStatus",   &wbc_py::AccelerationSceneTSID::getConstraintsStatus,  py::return_value_policy<py::copy_const_reference>())
             .def("getNConstraintVariablesPerPrio",   &wbc_py::AccelerationSceneTSID::getNConstraintVariablesPerPrio)
             .def("hasConstraint",   &wbc_py::AccelerationSceneTSID::hasConstraint)
+            .def("getNSkippedConstraints",   &wbc_py::AccelerationSceneTSID::getNSkippedConstraints)
+            .def("setCompactQP",   &wbc_py::AccelerationSceneTSID::setCompactQP)
             .def("updateConstraintsStatus",   &wbc_py::AccelerationSceneTSID::updateConstraintsStatus2)
             .def("getHierarchicalQP",   &wbc_py::AccelerationSceneTSID::getHierarchicalQP,  py::return_value_policy<py::copy_const_reference>())
             .def("getSolverOutput",   &wbc_py::AccelerationSceneTSID::getSolverOutput,  py::return_value_policy<py::copy_const_reference>())
@@ -0,0 +1,179 @@
+#include "BatchRobotModel.hpp"
+#include "RobotModelFactory.hpp"
+#include <base-logging/Logging.hpp>
+#include <thread>
+#include <exception>
+
+namespace wbc{
+
+BatchRobotModel::BatchRobotModel(uint n_threads) :
+    n_threads(n_threads),
+    n_floating_base_joints(0),
+    configured(false){
+    if(this->n_threads == 0)
+        this->n_threads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+bool BatchRobotModel::configure(const RobotModelConfig& cfg){
+
+    configured = false;
+    models.clear();
+    joint_states.clear();
+
+    for(uint i = 0; i < n_threads; i++){
+        RobotModelPtr model(RobotModelFactory::createInstance(cfg.type));
+        if(!model->configure(cfg)){
+            LOG_ERROR("BatchRobotModel: Failed to configure robot model instance %i of type %s", i, cfg.type.c_str());
+            return false;
+        }
+        models.push_back(model);
+    }
+
+    joint_names = models[0]->jointNames();
+    n_floating_base_joints = cfg.floating_base ? 6 : 0;
+
+    // The floating base is passed to the model as rigid body state, so the virtual joints are not part of the joint state
+    base::samples::Joints joint_state;
+    joint_state.names = std::vector<std::string>(joint_names.begin() + n_floating_base_joints, joint_names.end());
+    joint_state.elements.resize(joint_state.names.size());
+    joint_states.resize(n_threads, joint_state);
+
+    configured = true;
+    return true;
+}
+
+void BatchRobotModel::checkStates(const base::MatrixXd& states, const std::string& name){
+    if(!configured){
+        LOG_ERROR("BatchRobotModel: You have to call configure() before computing any quantities");
+        throw std::runtime_error("Invalid call to " + name);
+    }
+    if(states.cols() != noOfJoints()){
+        LOG_ERROR("BatchRobotModel: State matrix has %i columns, but the number of robot joints is %i", states.cols(), noOfJoints());
+        throw std::invalid_argument("Invalid state matrix in " + name);
+    }
+}
+
+void BatchRobotModel::rowToRobotState(const base::MatrixXd& q, const base::MatrixXd& qd, uint idx, uint n_floating_base_joints, const base::Time& time,
+                                      base::samples::Joints& joint_state, base::samples::RigidBodyStateSE3& floating_base_state){
+
+    for(uint j = 0; j < joint_state.size(); j++){
+        base::JointState& js = joint_state[j];
+        js.position = q(idx, j + n_floating_base_joints);
+        js.speed = qd.size() == 0 ? 0.0 : qd(idx, j + n_floating_base_joints);
+        js.acceleration = 0;
+    }
+    joint_state.time = time;
+
+    if(n_floating_base_joints > 0){
+        floating_base_state.pose.position = q.row(idx).segment<3>(0).transpose();
+        floating_base_state.pose.orientation = Eigen::AngleAxisd(q(idx,3), Eigen::Vector3d::UnitX()) *
+                                               Eigen::AngleAxisd(q(idx,4), Eigen::Vector3d::UnitY()) *
+                                               Eigen::AngleAxisd(q(idx,5), Eigen::Vector3d::UnitZ());
+        if(qd.size() == 0)
+            floating_base_state.twist.setZero();
+        else{
+            floating_base_state.twist.linear = qd.row(idx).segment<3>(0).transpose();
+            floating_base_state.twist.angular = qd.row(idx).segment<3>(3).transpose();
+        }
+        floating_base_state.acceleration.setZero();
+        floating_base_state.time = time;
+    }
+}
+
+void BatchRobotModel::updateModel(uint model_idx, const base::MatrixXd& q, const base::MatrixXd& qd, uint idx, const base::Time& time){
+
+    base::samples::RigidBodyStateSE3 floating_base_state;
+    rowToRobotState(q, qd, idx, n_floating_base_joints, time, joint_states[model_idx], floating_base_state);
+    models[model_idx]->update(joint_states[model_idx], floating_base_state);
+}
+
+void BatchRobotModel::parallelFor(uint n, const std::function<void(uint, uint)>& f){
+
+    const uint n_chunks = std::min(n_threads, n);
+    if(n_chunks == 0)
+        return;
+    const uint chunk_size = (n + n_chunks - 1) / n_chunks;
+
+    std::vector<std::exception_ptr> errors(n_chunks);
+    auto work = [&](uint model_idx){
+        try{
+            const uint end = std::min(n, (model_idx+1)*chunk_size);
+            for(uint idx = model_idx*chunk_size; idx < end; idx++)
+                f(model_idx, idx);
+        }
+        catch(...){
+            errors[model_idx] = std::current_exception();
+        }
+    };
+
+    // The calling thread processes the first chunk itself
+    std::vector<std::thread> threads;
+    for(uint i = 1; i < n_chunks; i++)
+        threads.push_back(std::thread(work, i));
+    work(0);
+    for(auto& t : threads)
+        t.join();
+
+    for(auto& e : errors){
+        if(e)
+            std::rethrow_exception(e);
+    }
+}
+
+void BatchRobotModel::forwardKinematics(const base::MatrixXd& q, const std::string& root_frame, const std::string& tip_frame, base::MatrixXd& poses){
+
+    checkStates(q, "forwardKinematics()");
+    poses.resize(q.rows(), 7);
+    const base::Time time = base::Time::now();
+    const base::MatrixXd qd;
+    parallelFor(q.rows(), [&](uint model_idx, uint idx){
+        updateModel(model_idx, q, qd, idx, time);
+        const base::Pose& pose = models[model_idx]->rigidBodyState(root_frame, tip_frame).pose;
+        poses.block<1,3>(idx,0) = pose.position.transpose();
+        poses.block<1,4>(idx,3) = pose.orientation.coeffs().transpose();
+    });
+}
+
+void BatchRobotModel::spaceJacobians(const base::MatrixXd& q, const std::string& root_frame, const std::string& tip_frame, base::MatrixXd& jacobians){
+
+    checkStates(q, "spaceJacobians()");
+    const uint nj = noOfJoints();
+    jacobians.resize(6*q.rows(), nj);
+    const base::Time time = base::Time::now();
+    const base::MatrixXd qd;
+    parallelFor(q.rows(), [&](uint model_idx, uint idx){
+        updateModel(model_idx, q, qd, idx, time);
+        jacobians.block(6*idx, 0, 6, nj) = models[model_idx]->spaceJacobian(root_frame, tip_frame);
+    });
+}
+
+void BatchRobotModel::jointSpaceInertiaMatrices(const base::MatrixXd& q, base::MatrixXd& inertia_matrices){
+
+    checkStates(q, "jointSpaceInertiaMatrices()");
+    const uint nj = noOfJoints();
+    inertia_matrices.resize(nj*q.rows(), nj);
+    const base::Time time = base::Time::now();
+    const base::MatrixXd qd;
+    parallelFor(q.rows(), [&](uint model_idx, uint idx){
+        updateModel(model_idx, q, qd, idx, time);
+        inertia_matrices.block(nj*idx, 0, nj, nj) = models[model_idx]->jointSpaceInertiaMatrix();
+    });
+}
+
+void BatchRobotModel::biasForces(const base::MatrixXd& q, const base::MatrixXd& qd, base::MatrixXd& bias_forces){
+
+    checkStates(q, "biasForces()");
+    checkStates(qd, "biasForces()");
+    if(qd.rows() != q.rows()){
+        LOG_ERROR("BatchRobotModel: Number of joint positions (%i) and joint velocities (%i) does not match", q.rows(), qd.rows());
+        throw std::invalid_argument("Invalid state matrix in biasForces()");
+    }
+    bias_forces.resize(q.rows(), noOfJoints());
+    const base::Time time = base::Time::now();
+    parallelFor(q.rows(), [&](uint model_idx, uint idx){
+        updateModel(model_idx, q, qd, idx, time);
+        bias_forces.row(idx) = models[model_idx]->biasForces().transpose();
+    });
+}
+
+}
@@ -0,0 +1,106 @@
+#ifndef BATCH_ROBOT_MODEL_HPP
+#define BATCH_ROBOT_MODEL_HPP
+
+#include "RobotModel.hpp"
+#include <functional>
+
+namespace wbc{
+
+/**
+ * @brief Evaluate kinematics and dynamics of a robot model for many joint configurations at once, e.g. for sampling based planning or
+ *  offline workspace analysis. Internally, one robot model instance (of the configured type) is created per worker thread and the
+ *  configurations are distributed in contiguous chunks among the threads.
+ *
+ *  All state matrices are N x nj, where N is the number of configurations and nj the number of robot joints. Since Eigen matrices are column major,
+ *  this corresponds to a structure-of-arrays layout, i.e. the values of each joint for all configurations are contiguous in memory.
+ *  The order of the columns has to be the same as jointNames(). For floating base robots, the first 6 columns correspond to the virtual floating
+ *  base joints, i.e. position x,y,z and orientation as XYZ Euler angles.
+ */
+class BatchRobotModel{
+protected:
+    std::vector<RobotModelPtr> models;
+    std::vector<base::samples::Joints> joint_states;
+    std::vector<std::string> joint_names;
+    uint n_threads;
+    uint n_floating_base_joints;
+    bool configured;
+
+    /** @brief Update the given model instance with row idx of the state matrices. qd may be empty, in which case zero velocities are used*/
+    void updateModel(uint model_idx, const base::MatrixXd& q, const base::MatrixXd& qd, uint idx, const base::Time& time);
+
+    /** @brief Call f(model_idx, idx) for all configurations idx = 0..n-1, distributed among the available threads*/
+    void parallelFor(uint n, const std::function<void(uint, uint)>& f);
+
+    /** @brief Check size of the state matrix and throw if it does not match the number of robot joints*/
+    void checkStates(const base::MatrixXd& states, const std::string& name);
+
+public:
+    /**
+     * @brief BatchRobotModel
+     * @param n_threads Number of worker threads. If 0, the number of hardware threads will be used.
+     */
+    BatchRobotModel(uint n_threads = 0);
+    virtual ~BatchRobotModel(){}
+
+    /**
+     * @brief Create one robot model instance per thread and configure it. The robot model plugin given by cfg.type has to be registered (loaded).
+     * @param cfg Model configuration. See RobotModelConfig.hpp for details
+     * @return True in case of success, else false
+     */
+    bool configure(const RobotModelConfig& cfg);
+
+    /**
+     * @brief Compute the pose of tip_frame wrt. root_frame for all given configurations
+     * @param q Joint positions, N x nj
+     * @param poses Output, N x 7. Each row is (x, y, z, qx, qy, qz, qw)
+     */
+    void forwardKinematics(const base::MatrixXd& q, const std::string& root_frame, const std::string& tip_frame, base::MatrixXd& poses);
+
+    /**
+     * @brief Compute the space Jacobian of the chain between root_frame and tip_frame for all given configurations
+     * @param q Joint positions, N x nj
+     * @param jacobians Output, 6N x nj. Rows 6i..6i+5 contain the Jacobian for configuration i
+     */
+    void spaceJacobians(const base::MatrixXd& q, const std::string& root_frame, const std::string& tip_frame, base::MatrixXd& jacobians);
+
+    /**
+     * @brief Compute the joint space inertia matrix for all given configurations
+     * @param q Joint positions, N x nj
+     * @param inertia_matrices Output, nj*N x nj. Rows nj*i..nj*(i+1)-1 contain the inertia matrix for configuration i
+     */
+    void jointSpaceInertiaMatrices(const base::MatrixXd& q, base::MatrixXd& inertia_matrices);
+
+    /**
+     * @brief Compute the bias forces (Coriolis, centrifugal and gravity) for all given configurations
+     * @param q Joint positions, N x nj
+     * @param qd Joint velocities, N x nj
+     * @param bias_forces Output, N x nj. Row i contains the bias forces for configuration i
+     */
+    void biasForces(const base::MatrixXd& q, const base::MatrixXd& qd, base::MatrixXd& bias_forces);
+
+    /** @brief Return all joint names, i.e. the column order of the state matrices*/
+    const std::vector<std::string>& jointNames(){return joint_names;}
+
+    /** @brief Return number of joints*/
+    uint noOfJoints(){return joint_names.size();}
+
+    /** @brief Return number of worker threads*/
+    uint noOfThreads(){return n_threads;}
+
+    /**
+     * @brief Convert row idx of the given state matrices to joint state and floating base state, as required by RobotModel::update()
+     * @param q Joint positions, N x nj. For floating base robots, the first 6 columns are the floating base position and XYZ Euler angles
+     * @param qd Joint velocities, N x nj. May be empty, in which case zero velocities are used
+     * @param idx Row index
+     * @param n_floating_base_joints 6 for floating base robots, 0 otherwise
+     * @param time Time stamp
+     * @param joint_state Output. Names and size have to be set already, excluding the virtual floating base joints
+     * @param floating_base_state Output. Not modified if n_floating_base_joints is 0
+     */
+    static void rowToRobotState(const base::MatrixXd& q, const base::MatrixXd& qd, uint idx, uint n_floating_base_joints, const base::Time& time,
+                                base::samples::Joints& joint_state, base::samples::RigidBodyStateSE3& floating_base_state);
+};
+
+}
+
+#endif // BATCH_ROBOT_MODEL_HPP
@@ -0,0 +1,102 @@
+#include "BatchSceneEngine.hpp"
+#include "BatchRobotModel.hpp"
+#include <base-logging/Logging.hpp>
+
+namespace wbc{
+
+BatchSceneEngine::BatchSceneEngine(uint n_threads) :
+    n_joints(0),
+    n_floating_base_joints(0),
+    pool(n_threads),
+    throughput(0),
+    total_solve_time(0),
+    n_solves(0){
+}
+
+void BatchSceneEngine::addInstance(WbcScenePtr scene){
+
+    if(!scene || !scene->getRobotModel()){
+        LOG_ERROR("BatchSceneEngine: Scene and robot model must not be null");
+        throw std::invalid_argument("Invalid scene");
+    }
+    if(scene->getWbcConfig().empty()){
+        LOG_ERROR("BatchSceneEngine: Scene has not been configured. Call configure() before adding it to the engine");
+        throw std::invalid_argument("Invalid scene");
+    }
+
+    RobotModelPtr robot_model = scene->getRobotModel();
+    std::vector<int> n_vars = WbcScene::getNConstraintVariablesPerPrio(scene->getWbcConfig());
+    uint n_fb_joints = robot_model->getRobotModelConfig().floating_base ? 6 : 0;
+
+    if(scenes.empty()){
+        n_joints = robot_model->noOfJoints();
+        n_vars_per_prio = n_vars;
+        n_floating_base_joints = n_fb_joints;
+    }
+    else if(robot_model->noOfJoints() != n_joints || n_vars != n_vars_per_prio || n_fb_joints != n_floating_base_joints){
+        LOG_ERROR("BatchSceneEngine: Structure of instance %i does not match the structure of the previous instances", scenes.size());
+        throw std::invalid_argument("Invalid scene");
+    }
+
+    // The floating base is passed to the model as rigid body state, so the virtual joints are not part of the joint state
+    const std::vector<std::string>& joint_names = robot_model->jointNames();
+    base::samples::Joints joint_state;
+    joint_state.names = std::vector<std::string>(joint_names.begin() + n_floating_base_joints, joint_names.end());
+    joint_state.elements.resize(joint_state.names.size());
+
+    scenes.push_back(scene);
+    joint_states.push_back(joint_state);
+    floating_base_states.push_back(robot_model->floatingBaseState());
+    outputs.push_back(base::commands::Joints());
+}
+
+void BatchSceneEngine::clear(){
+    scenes.clear();
+    joint_states.clear();
+    floating_base_states.clear();
+    outputs.clear();
+    n_vars_per_prio.clear();
+    n_joints = n_floating_base_joints = 0;
+}
+
+WbcScenePtr BatchSceneEngine::getScene(uint i){
+    if(i >= scenes.size()){
+        LOG_ERROR("BatchSceneEngine: Instance index %i is out of range. Number of instances is %i", i, scenes.size());
+        throw std::invalid_argument("Invalid instance index");
+    }
+    return scenes[i];
+}
+
+const base::commands::Joints& BatchSceneEngine::getOutput(uint i){
+    if(i >= outputs.size()){
+        LOG_ERROR("BatchSceneEngine: Instance index %i is out of range. Number of instances is %i", i, outputs.size());
+        throw std::invalid_argument("Invalid instance index");
+    }
+    return outputs[i];
+}
+
+void BatchSceneEngine::step(const base::MatrixXd& q, const base::MatrixXd& qd, const base::Time& time){
+
+    if(q.rows() != scenes.size() || q.cols() != n_joints){
+        LOG_ERROR("BatchSceneEngine: Joint position matrix is %i x %i, but should be %i x %i", q.rows(), q.cols(), scenes.size(), n_joints);
+        throw std::invalid_argument("Invalid joint position matrix");
+    }
+    if(qd.size() != 0 && (qd.rows() != q.rows() || qd.cols() != q.cols())){
+        LOG_ERROR("BatchSceneEngine: Joint velocity matrix is %i x %i, but should be %i x %i", qd.rows(), qd.cols(), q.rows(), q.cols());
+        throw std::invalid_argument("Invalid joint velocity matrix");
+    }
+
+    base::Time start = base::Time::now();
+    pool.parallelFor(scenes.size(), [&](uint i){
+        BatchRobotModel::rowToRobotState(q, qd, i, n_floating_base_joints, time, joint_states[i], floating_base_states[i]);
+        scenes[i]->getRobotModel()->update(joint_states[i], floating_base_states[i]);
+        outputs[i] = scenes[i]->solve(scenes[i]->update());
+    });
+    double dt = (base::Time::now() - start).toSeconds();
+
+    throughput = dt > 0 ? scenes.size() / dt : 0;
+    total_solve_time += dt;
+    n_solves += scenes.size();
+}
+
+}
@@ -0,0 +1,85 @@
+#ifndef BATCH_SCENE_ENGINE_HPP
+#define BATCH_SCENE_ENGINE_HPP
+
+#include "Scene.hpp"
+#include "ThreadPool.hpp"
+
+namespace wbc{
+
+/**
+ * @brief Steps many structurally identical WBC instances (scene, robot model and solver), e.g. for fleets of robots, parallel simulation or
+ *  sampling based controller evaluation. All instances must have the same number of joints and the same constraint configuration sizes.
+ *  In each call of step(), robot model update, scene update and solve are executed for all instances in parallel on a work stealing thread pool.
+ *
+ *  Input states are given as contiguous N x nj matrices, with the same layout as in BatchRobotModel, i.e. for floating base robots the first 6 columns
+ *  correspond to the virtual floating base joints (position x,y,z and orientation as XYZ Euler angles). The solver outputs of all instances are
+ *  stored in one contiguous array.
+ */
+class BatchSceneEngine{
+protected:
+    std::vector<WbcScenePtr> scenes;
+    std::vector<base::samples::Joints> joint_states;
+    std::vector<base::samples::RigidBodyStateSE3> floating_base_states;
+    std::vector<base::commands::Joints> outputs;
+    std::vector<int> n_vars_per_prio;
+    uint n_joints;
+    uint n_floating_base_joints;
+    ThreadPool pool;
+
+    double throughput;
+    double total_solve_time;
+    unsigned long n_solves;
+
+public:
+    /**
+     * @brief BatchSceneEngine
+     * @param n_threads Number of worker threads. If 0, the number of hardware threads will be used.
+     */
+    BatchSceneEngine(uint n_threads = 0);
+    virtual ~BatchSceneEngine(){}
+
+    /**
+     * @brief Add a configured scene. The scene's robot model has to be configured as well. Throws if the structure of the scene
+     *  (number of joints, constraint sizes per priority) does not match the structure of the previously added scenes.
+     */
+    void addInstance(WbcScenePtr scene);
+
+    /** @brief Remove all instances*/
+    void clear();
+
+    /** @brief Return number of instances*/
+    uint size() const {return scenes.size();}
+
+    /** @brief Return scene of instance i*/
+    WbcScenePtr getScene(uint i);
+
+    /**
+     * @brief Update robot models and scenes and solve all QPs in parallel
+     * @param q Joint positions, N x nj, where N = size(). Row i is the state of instance i. Column order is RobotModel::jointNames()
+     * @param qd Joint velocities, N x nj. May be empty, in which case zero velocities are used
+     * @param time Time stamp of the given states
+     */
+    void step(const base::MatrixXd& q, const base::MatrixXd& qd, const base::Time& time = base::Time::now());
+
+    /** @brief Return the solver output of instance i from the last call of step()*/
+    const base::commands::Joints& getOutput(uint i);
+
+    /** @brief Return the solver outputs of all instances from the last call of step()*/
+    const std::vector<base::commands::Joints>& getOutputs(){return outputs;}
+
+    /** @brief Return the throughput of the last call of step() in solves (control cycles) per second*/
+    double getThroughput() const {return throughput;}
+
+    /** @brief Return the average throughput of all calls of step() in solves per second*/
+    double getAverageThroughput() const {return total_solve_time > 0 ? n_solves / total_solve_time : 0;}
+
+    /** @brief Return the total number of solves since construction*/
+    unsigned long getNoOfSolves() const {return n_solves;}
+
+    /** @brief Return the underlying thread pool*/
+    const ThreadPool& getThreadPool() const {return pool;}
+};
+
+}
+
+#endif // BATCH_SCENE_ENGINE_HPP
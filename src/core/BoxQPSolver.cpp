@@ -0,0 +1,157 @@
+#include "BoxQPSolver.hpp"
+#include "Profiler.hpp"
+#include <base-logging/Logging.hpp>
+#include <limits>
+
+namespace wbc{
+
+BoxQPSolver::BoxQPSolver() :
+    max_iter(20),
+    tolerance(1e-9),
+    n_iter(0),
+    factorization_valid(false){
+}
+
+bool BoxQPSolver::solve(const base::MatrixXd& H, const base::VectorXd& g, const base::VectorXd& lower_x, const base::VectorXd& upper_x, base::VectorXd& solution){
+
+    WBC_PROFILE_SCOPE("BoxQPSolver::solve");
+
+    const int n = g.size();
+    if(H.rows() != n || H.cols() != n || (lower_x.size() != 0 && lower_x.size() != n) || (upper_x.size() != 0 && upper_x.size() != n)){
+        LOG_ERROR("BoxQPSolver: Invalid problem size. H is %i x %i, g: %i, lower bound: %i, upper bound: %i",
+                  H.rows(), H.cols(), g.size(), lower_x.size(), upper_x.size());
+        throw std::invalid_argument("Invalid problem size");
+    }
+
+    const double inf = std::numeric_limits<double>::infinity();
+    for(int i = 0; i < lower_x.size() && i < upper_x.size(); i++){
+        if(lower_x(i) > upper_x(i)){
+            LOG_ERROR("BoxQPSolver: Lower bound %f of variable %i is larger than upper bound %f", lower_x(i), i, upper_x(i));
+            throw std::invalid_argument("Invalid bounds");
+        }
+    }
+
+    if(x.size() != n){
+        x.setZero(n);
+        x_new.resize(n);
+        grad.resize(n);
+        step.resize(n);
+        grad_free.resize(n);
+        step_free.resize(n);
+        H_free.resize(n,n);
+        free_idx.reserve(n);
+        is_free.assign(n, true);
+        is_free_factorized.assign(n, true);
+    }
+
+    // Initial guess: Solution of the previous call, projected onto the bounds
+    for(int i = 0; i < n; i++){
+        const double lb = lower_x.size() == 0 ? -inf : lower_x(i);
+        const double ub = upper_x.size() == 0 ? inf : upper_x(i);
+        x(i) = std::min(std::max(x(i), lb), ub);
+    }
+
+    // H may have changed since the last call, so the first iteration always requires a new factorization
+    factorization_valid = false;
+    bool converged = false, full_newton_step = false;
+    const double abs_tolerance = tolerance*(1 + g.norm());
+    n_iter = 0;
+    while(n_iter < max_iter){
+
+        grad.noalias() = H*x;
+        grad += g;
+
+        // Clamp all variables that are at a bound and whose gradient points outwards
+        free_idx.clear();
+        for(int i = 0; i < n; i++){
+            const bool at_lower = lower_x.size() != 0 && x(i) <= lower_x(i);
+            const bool at_upper = upper_x.size() != 0 && x(i) >= upper_x(i);
+            is_free[i] = !((at_lower && grad(i) > 0) || (at_upper && grad(i) < 0));
+            if(is_free[i])
+                free_idx.push_back(i);
+        }
+        const int nf = free_idx.size();
+        for(int k = 0; k < nf; k++)
+            grad_free(k) = grad(free_idx[k]);
+
+        // KKT conditions: The projected gradient vanishes. The threshold is relative to the gradient vector g, since the rounding error of the gradient scales
+        // with the magnitude of the problem. Additionally, a full Newton step that leaves the set of free variables unchanged solves the problem up to rounding errors
+        if(grad_free.head(nf).norm() <= abs_tolerance || (full_newton_step && is_free == is_free_factorized)){
+            converged = true;
+            break;
+        }
+        n_iter++;
+
+        // Newton step on the free variables. Refactorize only if the set of free variables changed
+        if(!factorization_valid || is_free != is_free_factorized){
+            WBC_PROFILE_SCOPE("BoxQPSolver::factorize");
+            for(int k = 0; k < nf; k++){
+                for(int l = 0; l < nf; l++)
+                    H_free(k,l) = H(free_idx[k], free_idx[l]);
+            }
+            ldlt.compute(H_free.topLeftCorner(nf,nf));
+            if(ldlt.info() != Eigen::Success)
+                break;
+            is_free_factorized = is_free;
+            factorization_valid = true;
+        }
+        step_free.head(nf) = -ldlt.solve(grad_free.head(nf));
+        step.setZero();
+        for(int k = 0; k < nf; k++)
+            step(free_idx[k]) = step_free(k);
+
+        // Projected line search with Armijo condition
+        const double f = cost(H, g, x);
+        double alpha = 1;
+        bool accepted = false, projected = false;
+        while(alpha > 1e-10){
+            x_new = x + alpha*step;
+            projected = false;
+            for(int i = 0; i < n; i++){
+                if(lower_x.size() != 0 && x_new(i) < lower_x(i)){
+                    x_new(i) = lower_x(i);
+                    projected = true;
+                }
+                if(upper_x.size() != 0 && x_new(i) > upper_x(i)){
+                    x_new(i) = upper_x(i);
+                    projected = true;
+                }
+            }
+            if(cost(H, g, x_new) <= f + 1e-4*grad.dot(x_new - x)){
+                accepted = true;
+                break;
+            }
+            alpha *= 0.5;
+        }
+        if(!accepted)
+            break;
+        full_newton_step = alpha == 1 && !projected;
+        x = x_new;
+    }
+
+    solution = x;
+    return converged;
+}
+
+void BoxQPSolver::setMaxIterations(const uint n){
+    if(n == 0){
+        LOG_ERROR("BoxQPSolver: Max. number of iterations has to be > 0");
+        throw std::invalid_argument("Invalid max. number of iterations");
+    }
+    max_iter = n;
+}
+
+void BoxQPSolver::setTolerance(const double tol){
+    if(tol <= 0){
+        LOG_ERROR("BoxQPSolver: Tolerance has to be > 0, but is %f", tol);
+        throw std::invalid_argument("Invalid tolerance");
+    }
+    tolerance = tol;
+}
+
+void BoxQPSolver::reset(){
+    x.resize(0);
+    factorization_valid = false;
+}
+
+}
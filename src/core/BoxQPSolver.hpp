@@ -0,0 +1,77 @@
+#ifndef BOX_QP_SOLVER_HPP
+#define BOX_QP_SOLVER_HPP
+
+#include <base/Eigen.hpp>
+#include <Eigen/Cholesky>
+#include <vector>
+
+namespace wbc{
+
+/**
+ * @brief Solves box constrained QPs of the form
+ *  \f[
+ *        \begin{array}{ccc}
+ *        min(\mathbf{x}) & \frac{1}{2}\mathbf{x}^T\mathbf{H}\mathbf{x}+\mathbf{x}^T\mathbf{g} & \\
+ *             & & \\
+ *        s.t. & lb(\mathbf{x}) \leq \mathbf{x} \leq ub(\mathbf{x})& \\
+ *        \end{array}
+ *  \f]
+ *  with positive definite Hessian, using a projected Newton method (D.P. Bertsekas, “Projected Newton Methods for Optimization Problems with Simple Constraints”,
+ *  SIAM Journal on Control and Optimization, Vol. 20, No. 2, pp. 221 - 246, 1982). In each iteration, the variables at a bound whose gradient points outwards are clamped,
+ *  a Newton step is computed on the free variables using an LDLT factorization of the corresponding block of H, and a projected line search is performed.
+ *
+ *  The solution of the previous call is used as initial guess, so that the active bounds carry over from one call to the next. Thus, if the active bounds do not change
+ *  between two control cycles, typically a single factorization per call is required. All buffers are allocated on the first call and reused afterwards.
+ */
+class BoxQPSolver{
+protected:
+    base::MatrixXd H_free;
+    base::VectorXd x, x_new, grad, step, grad_free, step_free;
+    std::vector<int> free_idx;
+    std::vector<bool> is_free, is_free_factorized;
+    Eigen::LDLT<base::MatrixXd> ldlt;
+    uint max_iter;
+    double tolerance;
+    uint n_iter;
+    bool factorization_valid;
+
+    double cost(const base::MatrixXd& H, const base::VectorXd& g, const base::VectorXd& x_in) const {return 0.5*x_in.dot(H*x_in) + x_in.dot(g);}
+
+public:
+    BoxQPSolver();
+
+    /**
+     * @brief Solve the given box constrained QP
+     * @param H Hessian, n x n. Has to be symmetric positive definite
+     * @param g Gradient vector, size n
+     * @param lower_x Lower bound, size n or 0 (no lower bound)
+     * @param upper_x Upper bound, size n or 0 (no upper bound)
+     * @param solution Output: Solution vector, size n
+     * @return True, if the norm of the projected gradient is below tolerance*(1+||g||) or a full Newton step did not change the set of free variables,
+     *  after at most getMaxIterations() iterations. False otherwise.
+     *  The solution is within the bounds in any case. Throws if the input sizes do not match or lower_x > upper_x.
+     */
+    bool solve(const base::MatrixXd& H, const base::VectorXd& g, const base::VectorXd& lower_x, const base::VectorXd& upper_x, base::VectorXd& solution);
+
+    /** @brief Set the maximum number of Newton iterations per call to solve(). Has to be > 0. Default is 20*/
+    void setMaxIterations(const uint n);
+
+    /** @brief Return the maximum number of Newton iterations*/
+    uint getMaxIterations(){return max_iter;}
+
+    /** @brief Set the relative convergence threshold. The solver converges if the norm of the projected gradient is below tolerance*(1+||g||). Has to be > 0. Default is 1e-9*/
+    void setTolerance(const double tol);
+
+    /** @brief Return the convergence threshold*/
+    double getTolerance(){return tolerance;}
+
+    /** @brief Return the number of Newton iterations in the last call to solve()*/
+    uint noOfIterations(){return n_iter;}
+
+    /** @brief Discard the initial guess and the set of free variables*/
+    void reset();
+};
+
+}
+
+#endif // BOX_QP_SOLVER_HPP
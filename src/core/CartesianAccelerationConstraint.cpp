@@ -23,19 +23,15 @@ CartesianAccelerationConstraint::CartesianAccelerationConstraint(ConstraintConfi
 CartesianAccelerationConstraint::~CartesianAccelerationConstraint(){
 }
 
-void CartesianAccelerationConstraint::setReference(const base::samples::RigidBodyStateSE3& ref){
+void CartesianAccelerationConstraint::referenceToVector(const base::samples::RigidBodyStateSE3& ref, base::VectorXd& y) const{
 
     if(!ref.hasValidAcceleration()){
         LOG_ERROR("Constraint %s has invalid linear and/or angular acceleration", config.name.c_str())
         throw std::invalid_argument("Invalid constraint reference value");
     }
 
-    if(ref.time.isNull())
-        this->time = base::Time::now();
-    else
-        this->time = ref.time;
-    this->y_ref.segment(0,3) = ref.acceleration.linear;
-    this->y_ref.segment(3,3) = ref.acceleration.angular;
+    y.segment(0,3) = ref.acceleration.linear;
+    y.segment(3,3) = ref.acceleration.angular;
 }
 
 } // namespace wbc
@@ -18,10 +18,11 @@ public:
     virtual ~CartesianAccelerationConstraint();
 
     /**
-     * @brief Update the Cartesian reference input for this constraint.
+     * @brief Convert the Cartesian reference input to the reference vector of this constraint. Throws if the input is invalid
      * @param ref Reference input for this constraint. Only the acceleration part is relevant (Must have a valid linear and angular acceleration!)
+     * @param y Output: Reference vector. Has to have the correct size already
      */
-    virtual void setReference(const base::samples::RigidBodyStateSE3& ref);
+    virtual void referenceToVector(const base::samples::RigidBodyStateSE3& ref, base::VectorXd& y) const;
 };
 
 } // namespace wbc
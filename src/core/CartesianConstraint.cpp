@@ -12,4 +12,20 @@ CartesianConstraint::~CartesianConstraint(){
 
 }
 
+void CartesianConstraint::setReference(const base::samples::RigidBodyStateSE3& ref){
+    referenceToVector(ref, y_ref);
+    if(ref.time.isNull())
+        this->time = base::Time::now();
+    else
+        this->time = ref.time;
+    changes |= reference_changed;
+}
+
+void CartesianConstraint::publishReference(const base::samples::RigidBodyStateSE3& ref){
+    ReferenceInput& input = reference_buffer.writeBuffer();
+    referenceToVector(ref, input.y_ref);
+    input.time = ref.time.isNull() ? base::Time::now() : ref.time;
+    reference_buffer.publish();
+}
+
 } //namespace wbc
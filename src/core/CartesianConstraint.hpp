@@ -15,10 +15,21 @@ public:
     CartesianConstraint(const ConstraintConfig& _config, uint n_robot_joints);
     virtual ~CartesianConstraint();
 
+    /**
+     * @brief Convert the Cartesian reference input to the reference vector of this constraint. Throws if the input is invalid
+     */
+    virtual void referenceToVector(const base::samples::RigidBodyStateSE3& ref, base::VectorXd& y) const = 0;
+
     /**
      * @brief Update the Cartesian reference input for this constraint.
      */
-    virtual void setReference(const base::samples::RigidBodyStateSE3& ref) = 0;
+    void setReference(const base::samples::RigidBodyStateSE3& ref);
+
+    /**
+     * @brief Publish the Cartesian reference input to the control thread. Wait-free, can be called from any (single) producer thread. The input is validated
+     *  and converted on the calling thread. Throws if the input is invalid.
+     */
+    void publishReference(const base::samples::RigidBodyStateSE3& ref);
 };
 
 } //namespace wbc
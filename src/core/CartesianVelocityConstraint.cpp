@@ -11,19 +11,15 @@ CartesianVelocityConstraint::CartesianVelocityConstraint(ConstraintConfig config
 CartesianVelocityConstraint::~CartesianVelocityConstraint(){
 }
 
-void CartesianVelocityConstraint::setReference(const base::samples::RigidBodyStateSE3& ref){
+void CartesianVelocityConstraint::referenceToVector(const base::samples::RigidBodyStateSE3& ref, base::VectorXd& y) const{
 
     if(!ref.hasValidTwist()){
         LOG_ERROR("Constraint %s has invalid velocity and/or angular velocity", config.name.c_str())
         throw std::invalid_argument("Invalid constraint reference value");
     }
 
-    if(ref.time.isNull())
-        this->time = base::Time::now();
-    else
-        this->time = ref.time;
-    this->y_ref.segment(0,3) = ref.twist.linear;
-    this->y_ref.segment(3,3) = ref.twist.angular;
+    y.segment(0,3) = ref.twist.linear;
+    y.segment(3,3) = ref.twist.angular;
 }
 
 } // namespace wbc
@@ -14,10 +14,11 @@ public:
     virtual ~CartesianVelocityConstraint();
 
     /**
-     * @brief Update the Cartesian reference input for this constraint.
+     * @brief Convert the Cartesian reference input to the reference vector of this constraint. Throws if the input is invalid
      * @param ref Reference input for this constraint. Only the velocity part is relevant (Must have a valid linear and angular velocity!)
+     * @param y Output: Reference vector. Has to have the correct size already
      */
-    virtual void setReference(const base::samples::RigidBodyStateSE3& ref);
+    virtual void referenceToVector(const base::samples::RigidBodyStateSE3& ref, base::VectorXd& y) const;
 };
 
 typedef std::shared_ptr<CartesianVelocityConstraint> CartesianVelocityConstraintPtr;
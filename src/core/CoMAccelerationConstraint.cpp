@@ -0,0 +1,25 @@
+#include "CoMAccelerationConstraint.hpp"
+#include <base-logging/Logging.hpp>
+#include <base/samples/RigidBodyStateSE3.hpp>
+#include <base/Eigen.hpp>
+
+namespace wbc{
+
+CoMAccelerationConstraint::CoMAccelerationConstraint(ConstraintConfig config, uint n_robot_joints)
+    : CartesianConstraint(config, n_robot_joints){
+}
+
+CoMAccelerationConstraint::~CoMAccelerationConstraint(){
+}
+
+void CoMAccelerationConstraint::referenceToVector(const base::samples::RigidBodyStateSE3& ref, base::VectorXd& y) const{
+
+    if(!base::isnotnan(ref.acceleration.linear)){
+        LOG_ERROR("Constraint %s has invalid linear acceleration", config.name.c_str())
+        throw std::invalid_argument("Invalid constraint reference value");
+    }
+
+    y = ref.acceleration.linear;
+}
+
+} // namespace wbc
@@ -0,0 +1,28 @@
+#ifndef COMACCELERATIONCONSTRAINT_HPP
+#define COMACCELERATIONCONSTRAINT_HPP
+
+#include "CartesianConstraint.hpp"
+
+namespace wbc{
+
+/**
+ * @brief Implementation of a center of mass acceleration constraint. The reference is expressed in the base frame of the robot model.
+ */
+class CoMAccelerationConstraint : public CartesianConstraint{
+public:
+    CoMAccelerationConstraint(ConstraintConfig config, uint n_robot_joints);
+    virtual ~CoMAccelerationConstraint();
+
+    /**
+     * @brief Convert the CoM reference input to the reference vector of this constraint. Throws if the input is invalid
+     * @param ref Reference input for this constraint. Only the linear acceleration is relevant (Must be valid!)
+     * @param y Output: Reference vector. Has to have the correct size already
+     */
+    virtual void referenceToVector(const base::samples::RigidBodyStateSE3& ref, base::VectorXd& y) const;
+};
+
+typedef std::shared_ptr<CoMAccelerationConstraint> CoMAccelerationConstraintPtr;
+
+} // namespace wbc
+
+#endif
@@ -0,0 +1,25 @@
+#include "CoMVelocityConstraint.hpp"
+#include <base-logging/Logging.hpp>
+#include <base/samples/RigidBodyStateSE3.hpp>
+#include <base/Eigen.hpp>
+
+namespace wbc{
+
+CoMVelocityConstraint::CoMVelocityConstraint(ConstraintConfig config, uint n_robot_joints)
+    : CartesianConstraint(config, n_robot_joints){
+}
+
+CoMVelocityConstraint::~CoMVelocityConstraint(){
+}
+
+void CoMVelocityConstraint::referenceToVector(const base::samples::RigidBodyStateSE3& ref, base::VectorXd& y) const{
+
+    if(!base::isnotnan(ref.twist.linear)){
+        LOG_ERROR("Constraint %s has invalid linear velocity", config.name.c_str())
+        throw std::invalid_argument("Invalid constraint reference value");
+    }
+
+    y = ref.twist.linear;
+}
+
+} // namespace wbc
@@ -4,7 +4,8 @@
 
 namespace wbc{
 
-Constraint::Constraint(){
+Constraint::Constraint() :
+    changes(all_changed){
 
 }
 
@@ -43,15 +44,39 @@ void Constraint::reset(){
     // Reset timeout and time. Like this, constraints can get activated only after they received a reference value
     timeout = 1;
     time.microseconds = 0;
+    changes = all_changed;
+
+    // Preallocate the input buffers, so that publishing does not allocate memory
+    ReferenceInput ref_input;
+    ref_input.y_ref.setZero(no_variables);
+    reference_buffer.init(ref_input);
+    weights_buffer.init(weights);
+    activation_buffer.init(activation);
 }
 
 void Constraint::checkTimeout(){
+    const int prev_timeout = timeout;
     timeout = (int)time.isNull(); // If there has never been a reference value, set the constraint to timeout
     if(config.timeout > 0)
         timeout = (int)(base::Time::now() - time).toSeconds() > config.timeout;
+    if(timeout != prev_timeout)
+        changes |= timeout_changed;
 }
 
-void Constraint::setWeights(const base::VectorXd& weights){
+void Constraint::setReferenceVector(const base::VectorXd& ref, const base::Time& time){
+    if(config.nVariables() != ref.size()){
+        LOG_ERROR("Constraint %s: Size of reference input is %i, but should be %i", config.name.c_str(), ref.size(), config.nVariables());
+        throw std::invalid_argument("Invalid constraint reference input");
+    }
+    if(time.isNull())
+        this->time = base::Time::now();
+    else
+        this->time = time;
+    changes |= reference_changed;
+    y_ref = ref;
+}
+
+void Constraint::validateWeights(const base::VectorXd& weights) const{
     if(config.nVariables() != weights.size()){
         LOG_ERROR("Constraint %s: Size of weight vector should be %i but is %i", config.name.c_str(), config.nVariables(), weights.size())
         throw std::invalid_argument("Invalid constraint weights");
@@ -62,16 +87,70 @@ void Constraint::setWeights(const base::VectorXd& weights){
             LOG_ERROR("Constraint %s: Weight values should be > 0, but weight %i is %f", config.name.c_str(), i, weights(i));
             throw std::invalid_argument("Invalid constraint weights");
         }
+}
 
+void Constraint::setWeights(const base::VectorXd& weights){
+    validateWeights(weights);
+    if(weights != this->weights)
+        changes |= weights_changed;
     this->weights = weights;
 }
 
-void Constraint::setActivation(const double activation){
+void Constraint::validateActivation(const double activation) const{
     if(activation < 0 || activation > 1){
         LOG_ERROR("Constraint %s: Activation has to be between 0 and 1 but is %f", config.name.c_str(), activation);
         throw std::invalid_argument("Invalid constraint activation");
     }
+}
+
+void Constraint::setActivation(const double activation){
+    validateActivation(activation);
+    if(activation != this->activation)
+        changes |= activation_changed;
     this->activation = activation;
 }
 
+void Constraint::publishReferenceVector(const base::VectorXd& ref, const base::Time& time){
+    if(config.nVariables() != ref.size()){
+        LOG_ERROR("Constraint %s: Size of reference input is %i, but should be %i", config.name.c_str(), ref.size(), config.nVariables());
+        throw std::invalid_argument("Invalid constraint reference input");
+    }
+    ReferenceInput& input = reference_buffer.writeBuffer();
+    input.y_ref = ref;
+    input.time = time.isNull() ? base::Time::now() : time;
+    reference_buffer.publish();
+}
+
+void Constraint::publishWeights(const base::VectorXd& weights){
+    validateWeights(weights);
+    weights_buffer.writeBuffer() = weights;
+    weights_buffer.publish();
+}
+
+void Constraint::publishActivation(const double activation){
+    validateActivation(activation);
+    activation_buffer.writeBuffer() = activation;
+    activation_buffer.publish();
+}
+
+void Constraint::fetchInputs(){
+    // Values have been validated by the producer already
+    if(reference_buffer.fetch()){
+        const ReferenceInput& input = reference_buffer.readBuffer();
+        time = input.time;
+        y_ref = input.y_ref;
+        changes |= reference_changed;
+    }
+    if(weights_buffer.fetch()){
+        if(weights_buffer.readBuffer() != weights)
+            changes |= weights_changed;
+        weights = weights_buffer.readBuffer();
+    }
+    if(activation_buffer.fetch()){
+        if(activation_buffer.readBuffer() != activation)
+            changes |= activation_changed;
+        activation = activation_buffer.readBuffer();
+    }
+}
+
 }// namespace wbc
@@ -2,6 +2,7 @@
 #define CONSTRAINT_HPP
 
 #include "ConstraintConfig.hpp"
+#include "TripleBuffer.hpp"
 #include <base/Eigen.hpp>
 #include <base/Time.hpp>
 #include <base/NamedVector.hpp>
@@ -9,10 +10,38 @@
 
 namespace wbc{
 
+/** Flags describing which properties of a constraint changed since the last scene update. Used by the scenes to recompute only the affected parts of the QP*/
+enum ConstraintChange{
+    reference_changed  = 1,
+    weights_changed    = 2,
+    activation_changed = 4,
+    timeout_changed    = 8,
+    all_changed        = reference_changed | weights_changed | activation_changed | timeout_changed
+};
+
 /**
  * @brief Abstract class to represent a generic constraint for a WBC optimization problem.
+ *
+ *  Reference, weights and activation can either be set directly (setReferenceVector(), setWeights(), setActivation()), which is only safe from
+ *  the thread that calls the scene's update(), or asynchronously from another thread via publishReferenceVector(), publishWeights() and publishActivation().
+ *  Published values are passed to the control thread via wait-free triple buffers and applied in fetchInputs(). Each input may have only a single
+ *  producer thread.
  */
 class Constraint{
+protected:
+    struct ReferenceInput{
+        base::VectorXd y_ref;
+        base::Time time;
+    };
+    TripleBuffer<ReferenceInput> reference_buffer;
+    TripleBuffer<base::VectorXd> weights_buffer;
+    TripleBuffer<double> activation_buffer;
+
+    /** Throw if the given weight vector is invalid*/
+    void validateWeights(const base::VectorXd& weights) const;
+    /** Throw if the given activation is invalid*/
+    void validateActivation(const double activation) const;
+
 public:
 
     /** @brief Default constructor */
@@ -34,6 +63,13 @@ public:
      */
     void checkTimeout();
 
+    /**
+     * @brief Set the reference input for this constraint.
+     * @param ref Reference vector. Size has to be same as number of constraint variables
+     * @param time Time stamp of the reference. If null, the current time will be used
+     */
+    void setReferenceVector(const base::VectorXd& ref, const base::Time& time);
+
     /**
      * @brief Set constraint weights.
      * @param weights Weight vector. Size has to be same as number of constraint variables and all entries have to be >= 0
@@ -46,6 +82,36 @@ public:
      */
     void setActivation(const double activation);
 
+    /**
+     * @brief Publish a reference vector to the control thread. Wait-free, can be called from any (single) producer thread. See setReferenceVector() for details.
+     */
+    void publishReferenceVector(const base::VectorXd& ref, const base::Time& time);
+
+    /**
+     * @brief Publish constraint weights to the control thread. Wait-free, can be called from any (single) producer thread. Throws if the weights are invalid.
+     */
+    void publishWeights(const base::VectorXd& weights);
+
+    /**
+     * @brief Publish a constraint activation to the control thread. Wait-free, can be called from any (single) producer thread. Throws if the activation is invalid.
+     */
+    void publishActivation(const double activation);
+
+    /**
+     * @brief Apply the latest published reference, weights and activation, if any. To be called from the control thread, e.g. at the beginning of the scene update
+     */
+    void fetchInputs();
+
+    /**
+     * @brief Reset all change flags. Called by the scenes after the constraint has been processed in update()
+     */
+    void clearChanges(){changes = 0;}
+
+    /**
+     * @brief Return true if any of the given change flags is set. See ConstraintChange for possible values
+     */
+    bool hasChanged(int flags = all_changed) const {return (changes & flags) != 0;}
+
     /** Last time the constraint reference values was updated.*/
     base::Time time;
 
@@ -76,6 +142,9 @@ public:
      *  config.timeout time, this value will be set to zero*/
     int timeout;
 
+    /** Bitmask of ConstraintChange flags, describing what changed since the last call of clearChanges()*/
+    int changes;
+
     /** Constraint matrix */
     base::MatrixXd A;
 
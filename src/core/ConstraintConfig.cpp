@@ -81,8 +81,13 @@ void ConstraintConfig::validate() const{
                 LOG_ERROR("Constraint %s: Name of joint %i is empty", name.c_str(), i);
                 throw std::invalid_argument("Invalid constraint config");}
     }
+    else if(type == com){
+        if(weights.size() != 3){
+            LOG_ERROR("Constraint %s: Size of weight vector should be 3, but is %i", name.c_str(), weights.size());
+            throw std::invalid_argument("Invalid constraint config");}
+    }
     else{
-        LOG_ERROR("Constraint %s: Invalid constraint type. Allowed types are 'jnt' and 'cart'", name.c_str());
+        LOG_ERROR("Constraint %s: Invalid constraint type. Allowed types are 'jnt', 'cart' and 'com'", name.c_str());
         throw std::invalid_argument("Invalid constraint config");}
 
     for(size_t i = 0; i < weights.size(); i++)
@@ -94,6 +99,8 @@ void ConstraintConfig::validate() const{
 unsigned int ConstraintConfig::nVariables() const{
     if(type == cart)
         return 6;
+    else if(type == com)
+        return 3;
     else
         return joint_names.size();
 }
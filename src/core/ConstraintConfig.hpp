@@ -8,15 +8,18 @@
 namespace wbc{
 
 /**
- * Constraint Type. Two types of constraints are possible:
+ * Constraint Type. Three types of constraints are possible:
  *  - Cartesian constraints: The motion between two coordinate frames (root, tip) will be constrained. This can be used for operational space control, e.g.
  *                           Cartesian force/position control, obstacle avoidance, ...
  *  - Joint constraints: The motion for the given joints will be constrained. This can be used for joint space
  *                       control, e.g. avoiding the joint limits, maintaining a certain elbow position, joint position control, ...
+ *  - CoM constraints: The motion of the robot's center of mass will be constrained. The reference is expressed in the base frame of the
+ *                     robot model. This can be used e.g. for balancing tasks
  */
 enum ConstraintType{unset = -1,
                     jnt = 0,
-                    cart = 1};
+                    cart = 1,
+                    com = 2};
 
 /**
  * @brief Defines a constraint in the whole body control problem. Valid Configurations are e.g.
@@ -34,6 +37,12 @@ enum ConstraintType{unset = -1,
  *          joint_names = ["J_1", "J_2", "J_3"]
  *          activation = 1
  *          timeout = 3.0
+ *
+ *        - name = "com_position_control"
+ *          priority = 0
+ *          constraint_type = com
+ *          weights = [1,1,1]
+ *          activation = 1
  */
 class ConstraintConfig{
 
@@ -60,7 +69,7 @@ public:
     /** Unique identifier of the constraint. Must not be empty*/
     std::string name;
 
-    /** Constraint type, can be one of 'jnt' (joint space) or 'cart' (Cartesian) */
+    /** Constraint type, can be one of 'jnt' (joint space), 'cart' (Cartesian) or 'com' (center of mass) */
     ConstraintType type;
 
     /** Priority of this constraint. Must be >= 0! 0 corresponds to the highest priority. */
@@ -70,7 +79,7 @@ public:
      *  Can be used to balance contributions of the constraint variables.
      *  A value of 0 means that the reference of the corresponding constraint variable will be ignored while computing the solution.
      *  Vector Size has to be same as number of constraint variables. e.g. number of joint names in case of joint space constraint,
-        and 6 in case of a Cartesian Constraint */
+        6 in case of a Cartesian Constraint and 3 in case of a CoM constraint */
     std::vector<double> weights;
 
     /** Initial activation for this constraint. Has to be within 0 and 1. Can be used to enable(1)/disable(0) the whole constraint,
@@ -0,0 +1,96 @@
+#include "HessianAssembler.hpp"
+#include "Profiler.hpp"
+#include <base-logging/Logging.hpp>
+
+namespace wbc{
+
+HessianAssembler::HessianAssembler(){
+}
+
+void HessianAssembler::reset(uint nj){
+    H.setZero(nj,nj);
+    g.setZero(nj);
+    nz_cols.reserve(nj);
+}
+
+void HessianAssembler::addConstraint(const base::MatrixXd& A,
+                                     const base::VectorXd& row_weights,
+                                     const base::VectorXd& col_weights,
+                                     const base::VectorXd& y,
+                                     base::MatrixXd& Aw){
+    WBC_PROFILE_SCOPE("HessianAssembler::addConstraint");
+
+    const int nj = H.rows();
+    if(A.cols() != nj || row_weights.size() != A.rows() || col_weights.size() != nj || y.size() != A.rows()){
+        LOG_ERROR("HessianAssembler: Invalid constraint size. A is %i x %i, row weights: %i, col weights: %i, y: %i, number of joints: %i",
+                  A.rows(), A.cols(), row_weights.size(), col_weights.size(), y.size(), nj);
+        throw std::invalid_argument("Invalid constraint size");
+    }
+
+    Aw.setZero(A.rows(), nj);
+
+    // Only columns with non-zero entries contribute, e.g. the joints of the kinematic chain for a Cartesian constraint
+    nz_cols.clear();
+    for(int j = 0; j < nj; j++){
+        if(col_weights(j) != 0 && !A.col(j).isZero(0))
+            nz_cols.push_back(j);
+    }
+    if(nz_cols.empty() || row_weights.isZero(0))
+        return;
+
+    const int nc = nz_cols.size();
+    Aw_compact.resize(A.rows(), nc);
+    for(int c = 0; c < nc; c++)
+        Aw_compact.col(c) = row_weights.cwiseProduct(A.col(nz_cols[c])) * col_weights(nz_cols[c]);
+
+    if(nc == nj){
+        H.selfadjointView<Eigen::Lower>().rankUpdate(Aw_compact.transpose());
+        g.noalias() -= Aw_compact.transpose()*y;
+        Aw = Aw_compact;
+        return;
+    }
+
+    H_compact.setZero(nc,nc);
+    H_compact.selfadjointView<Eigen::Lower>().rankUpdate(Aw_compact.transpose());
+
+    // nz_cols is sorted, so the lower triangle of H_compact maps to the lower triangle of H
+    for(int c = 0; c < nc; c++){
+        const int j = nz_cols[c];
+        for(int r = c; r < nc; r++)
+            H(nz_cols[r], j) += H_compact(r,c);
+        g(j) -= Aw_compact.col(c).dot(y);
+        Aw.col(j) = Aw_compact.col(c);
+    }
+}
+
+void HessianAssembler::addSelector(const std::vector<int>& joint_idx,
+                                   const base::VectorXd& row_weights,
+                                   const base::VectorXd& col_weights,
+                                   const base::VectorXd& y,
+                                   base::MatrixXd& Aw){
+
+    const int nj = H.rows();
+    if(row_weights.size() != (int)joint_idx.size() || col_weights.size() != nj || y.size() != (int)joint_idx.size()){
+        LOG_ERROR("HessianAssembler: Invalid constraint size. Number of joints in constraint: %i, row weights: %i, col weights: %i, y: %i, number of joints: %i",
+                  joint_idx.size(), row_weights.size(), col_weights.size(), y.size(), nj);
+        throw std::invalid_argument("Invalid constraint size");
+    }
+
+    Aw.setZero(joint_idx.size(), nj);
+    for(uint k = 0; k < joint_idx.size(); k++){
+        const int j = joint_idx[k];
+        const double aw = row_weights(k) * col_weights(j);
+        Aw(k,j) = aw;
+        H(j,j) += aw*aw;
+        g(j) -= aw*y(k);
+    }
+}
+
+void HessianAssembler::get(base::MatrixXd& H_out, base::VectorXd& g_out) const{
+    WBC_PROFILE_SCOPE("HessianAssembler::get");
+    const int nj = H.rows();
+    H_out.block(0,0,nj,nj) = H.selfadjointView<Eigen::Lower>();
+    g_out.segment(0,nj) = g;
+}
+
+}
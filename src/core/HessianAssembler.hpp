@@ -0,0 +1,73 @@
+#ifndef HESSIAN_ASSEMBLER_HPP
+#define HESSIAN_ASSEMBLER_HPP
+
+#include <base/Eigen.hpp>
+#include <vector>
+
+namespace wbc{
+
+/**
+ * @brief Accumulates the Hessian H = sum_i Aw_i^T*Aw_i and gradient g = -sum_i Aw_i^T*y_i of a weighted least squares cost, where Aw_i = diag(w_i)*A_i*diag(w_q)
+ *  is the weighted constraint matrix of the i-th constraint, w_i are the constraint (row) weights and w_q the joint (column) weights.
+ *  Instead of forming dense nj x nj products, the assembler
+ *    - only updates the lower triangle of H using symmetric rank-k updates,
+ *    - restricts the update to the non-zero columns of A_i (e.g. the joints of a kinematic chain),
+ *    - adds joint space selector constraints (A_i has a single 1 per row) directly to the diagonal.
+ */
+class HessianAssembler{
+protected:
+    base::MatrixXd H;
+    base::VectorXd g;
+    base::MatrixXd Aw_compact, H_compact;
+    std::vector<int> nz_cols;
+
+public:
+    HessianAssembler();
+
+    /** @brief Set H and g to zero and resize them to nj x nj and nj respectively, where nj is the number of joints*/
+    void reset(uint nj);
+
+    /**
+     * @brief Add a constraint with arbitrary constraint matrix.
+     * @param A Constraint matrix, m x nj
+     * @param row_weights Constraint weights, size m. Already multiplied with activation, if required
+     * @param col_weights Joint weights, size nj
+     * @param y Reference value of the constraint, size m
+     * @param Aw Output: Weighted constraint matrix, m x nj.
+     */
+    void addConstraint(const base::MatrixXd& A,
+                       const base::VectorXd& row_weights,
+                       const base::VectorXd& col_weights,
+                       const base::VectorXd& y,
+                       base::MatrixXd& Aw);
+
+    /**
+     * @brief Add a joint space constraint, i.e. a constraint whose matrix has exactly one entry 1 per row.
+     * @param joint_idx Column index of the non-zero entry for each row, size m
+     * @param row_weights Constraint weights, size m. Already multiplied with activation, if required
+     * @param col_weights Joint weights, size nj
+     * @param y Reference value of the constraint, size m
+     * @param Aw Output: Weighted constraint matrix, m x nj.
+     */
+    void addSelector(const std::vector<int>& joint_idx,
+                     const base::VectorXd& row_weights,
+                     const base::VectorXd& col_weights,
+                     const base::VectorXd& y,
+                     base::MatrixXd& Aw);
+
+    /** @brief Add the given value to the diagonal of H, e.g. for regularization*/
+    void addDiagonal(double value){H.diagonal().array() += value;}
+
+    /** @brief Copy the full (symmetric) Hessian to H_out and gradient to g_out. Only the top left nj x nj block of H_out and the first nj entries of g_out will be written*/
+    void get(base::MatrixXd& H_out, base::VectorXd& g_out) const;
+
+    /** @brief Return the Hessian. Note: Only the lower triangle is valid*/
+    const base::MatrixXd& hessianLower() const {return H;}
+
+    /** @brief Return the gradient*/
+    const base::VectorXd& gradient() const {return g;}
+};
+
+}
+
+#endif // HESSIAN_ASSEMBLER_HPP
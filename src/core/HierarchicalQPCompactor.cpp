@@ -0,0 +1,101 @@
+#include "HierarchicalQPCompactor.hpp"
+#include "Profiler.hpp"
+#include <base-logging/Logging.hpp>
+
+namespace wbc{
+
+HierarchicalQPCompactor::HierarchicalQPCompactor(){
+}
+
+const HierarchicalQP& HierarchicalQPCompactor::compact(const HierarchicalQP& hqp){
+    WBC_PROFILE_SCOPE("HierarchicalQPCompactor::compact");
+
+    compact_hqp.resize(hqp.size());
+    row_map.resize(hqp.size());
+    inverse_row_map.resize(hqp.size());
+
+    for(uint prio = 0; prio < hqp.size(); prio++){
+        const QuadraticProgram& qp = hqp[prio];
+        QuadraticProgram& cqp = compact_hqp[prio];
+
+        if(qp.A.rows() != qp.nc || (qp.Wy.size() != 0 && qp.Wy.size() != qp.nc)){
+            LOG_ERROR("HierarchicalQPCompactor: Invalid QP on priority %i. nc is %i, but A has %i rows and Wy has size %i", prio, qp.nc, qp.A.rows(), qp.Wy.size());
+            throw std::invalid_argument("Invalid quadratic program");
+        }
+
+        // A row is active if its weight is non-zero. If no weights are given, all rows are active
+        std::vector<int>& rows = row_map[prio];
+        std::vector<int>& inv_rows = inverse_row_map[prio];
+        rows.clear();
+        inv_rows.assign(qp.nc, -1);
+        for(int i = 0; i < qp.nc; i++){
+            if(qp.Wy.size() == 0 || qp.Wy(i) != 0){
+                inv_rows[i] = rows.size();
+                rows.push_back(i);
+            }
+        }
+
+        const uint nc = rows.size();
+        cqp.resizeIfRequired(nc, qp.nq);
+        for(uint k = 0; k < nc; k++)
+            cqp.A.row(k) = qp.A.row(rows[k]);
+
+        if(qp.lower_y.size() == qp.nc){
+            for(uint k = 0; k < nc; k++)
+                cqp.lower_y(k) = qp.lower_y(rows[k]);
+        }
+        else
+            cqp.lower_y.resize(0);
+        if(qp.upper_y.size() == qp.nc){
+            for(uint k = 0; k < nc; k++)
+                cqp.upper_y(k) = qp.upper_y(rows[k]);
+        }
+        else
+            cqp.upper_y.resize(0);
+        if(qp.Wy.size() == qp.nc){
+            for(uint k = 0; k < nc; k++)
+                cqp.Wy(k) = qp.Wy(rows[k]);
+        }
+        else
+            cqp.Wy.resize(0);
+
+        // Cost function and joint space bounds are not affected
+        cqp.H = qp.H;
+        cqp.g = qp.g;
+        cqp.lower_x = qp.lower_x;
+        cqp.upper_x = qp.upper_x;
+    }
+    compact_hqp.Wq = hqp.Wq;
+    compact_hqp.time = hqp.time;
+
+    return compact_hqp;
+}
+
+const std::vector<int>& HierarchicalQPCompactor::rowMap(uint prio) const{
+    if(prio >= row_map.size()){
+        LOG_ERROR("HierarchicalQPCompactor: Invalid priority %i, number of priorities is %i", prio, row_map.size());
+        throw std::invalid_argument("Invalid priority");
+    }
+    return row_map[prio];
+}
+
+bool HierarchicalQPCompactor::isActiveRow(uint prio, uint row) const{
+    if(prio >= inverse_row_map.size() || row >= inverse_row_map[prio].size()){
+        LOG_ERROR("HierarchicalQPCompactor: Invalid row %i on priority %i", row, prio);
+        throw std::invalid_argument("Invalid row index");
+    }
+    return inverse_row_map[prio][row] >= 0;
+}
+
+void HierarchicalQPCompactor::expand(uint prio, const base::VectorXd& compact_vector, base::VectorXd& full_vector) const{
+    const std::vector<int>& rows = rowMap(prio);
+    if(compact_vector.size() != (int)rows.size()){
+        LOG_ERROR("HierarchicalQPCompactor: Vector has size %i, but number of active rows on priority %i is %i", compact_vector.size(), prio, rows.size());
+        throw std::invalid_argument("Invalid vector size");
+    }
+    full_vector.setZero(inverse_row_map[prio].size());
+    for(uint k = 0; k < rows.size(); k++)
+        full_vector(rows[k]) = compact_vector(k);
+}
+
+}
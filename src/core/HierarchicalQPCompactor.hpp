@@ -0,0 +1,54 @@
+#ifndef HIERARCHICAL_QP_COMPACTOR_HPP
+#define HIERARCHICAL_QP_COMPACTOR_HPP
+
+#include "QuadraticProgram.hpp"
+
+namespace wbc{
+
+/**
+ * @brief Builds a packed copy of a hierarchical QP that contains only the active constraint rows, i.e. the rows with non-zero constraint weight Wy.
+ *  Rows of deactivated or timed-out constraints are dropped, so that the solver effort scales with the number of active constraints rather than
+ *  with the number of configured constraints. The mapping between rows of the packed QP and rows of the original QP is kept and can be used to map
+ *  per-row quantities back to the original layout.
+ *
+ *  Priorities are never removed, even if all rows of a priority are inactive. In that case the corresponding QP has zero rows.
+ */
+class HierarchicalQPCompactor{
+protected:
+    HierarchicalQP compact_hqp;
+    std::vector< std::vector<int> > row_map;          /** For each priority: Row index in the original QP for each row of the packed QP*/
+    std::vector< std::vector<int> > inverse_row_map;  /** For each priority: Row index in the packed QP for each row of the original QP, -1 if the row has been dropped*/
+
+public:
+    HierarchicalQPCompactor();
+
+    /**
+     * @brief Build the packed QP from the given hierarchical QP. The memory of the packed QP is only reallocated if the number of active rows changes
+     * @return The packed hierarchical QP. Reference stays valid until the next call of compact()
+     */
+    const HierarchicalQP& compact(const HierarchicalQP& hqp);
+
+    /** @brief Return the packed QP of the last call to compact()*/
+    const HierarchicalQP& compactQP() const {return compact_hqp;}
+
+    /** @brief For the given priority, return the row index in the original QP for each row of the packed QP*/
+    const std::vector<int>& rowMap(uint prio) const;
+
+    /** @brief Return true if the given row of the original QP is part of the packed QP*/
+    bool isActiveRow(uint prio, uint row) const;
+
+    /** @brief Number of active rows of the given priority*/
+    uint nActiveRows(uint prio) const {return rowMap(prio).size();}
+
+    /**
+     * @brief Scatter a per-row vector of the packed QP, e.g. the Lagrange multipliers, to the row layout of the original QP. Entries of dropped rows are set to zero.
+     * @param prio Priority
+     * @param compact_vector Vector with one entry per row of the packed QP
+     * @param full_vector Output: Vector with one entry per row of the original QP
+     */
+    void expand(uint prio, const base::VectorXd& compact_vector, base::VectorXd& full_vector) const;
+};
+
+}
+
+#endif // HIERARCHICAL_QP_COMPACTOR_HPP
@@ -12,18 +12,13 @@ JointAccelerationConstraint::~JointAccelerationConstraint(){
 
 }
 
-void JointAccelerationConstraint::setReference(const base::commands::Joints& ref){
+void JointAccelerationConstraint::referenceToVector(const base::commands::Joints& ref, base::VectorXd& y) const{
 
     if(ref.size() != config.nVariables()){
         LOG_ERROR("Constraint %s: Size of reference input is %i, but should be %i", config.name.c_str(), ref.size(), config.nVariables());
         throw std::invalid_argument("Invalid constraint reference input");
     }
 
-    if(ref.time.isNull())
-        this->time = base::Time::now();
-    else
-        this->time = ref.time;
-
     for(size_t i = 0; i < ref.size(); i++){
         uint idx;
         try{
@@ -39,7 +34,7 @@ void JointAccelerationConstraint::setReference(const base::commands::Joints& ref
             throw std::invalid_argument("Invalid constraint reference input");
         }
 
-        this->y_ref(i) = ref[idx].acceleration;
+        y(i) = ref[idx].acceleration;
     }
 }
 } // namespace wbc
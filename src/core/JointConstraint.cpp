@@ -1,4 +1,5 @@
 #include "JointConstraint.hpp"
+#include <base-logging/Logging.hpp>
 
 namespace wbc {
 
@@ -11,4 +12,31 @@ JointConstraint::~JointConstraint(){
 
 }
 
+void JointConstraint::setReference(const base::commands::Joints& ref){
+    referenceToVector(ref, y_ref);
+    if(ref.time.isNull())
+        this->time = base::Time::now();
+    else
+        this->time = ref.time;
+    changes |= reference_changed;
+}
+
+void JointConstraint::publishReference(const base::commands::Joints& ref){
+    ReferenceInput& input = reference_buffer.writeBuffer();
+    referenceToVector(ref, input.y_ref);
+    input.time = ref.time.isNull() ? base::Time::now() : ref.time;
+    reference_buffer.publish();
+}
+
+void JointConstraint::setJointIndices(const std::vector<int>& idx){
+    if(idx.size() != config.joint_names.size()){
+        LOG_ERROR("Constraint %s: Number of joint indices is %i, but constraint has %i joints", config.name.c_str(), idx.size(), config.joint_names.size());
+        throw std::invalid_argument("Invalid joint indices");
+    }
+    joint_idx = idx;
+    A.setZero();
+    for(uint k = 0; k < joint_idx.size(); k++)
+        A(k,joint_idx[k]) = 1.0;
+}
+
 } //namespace wbc
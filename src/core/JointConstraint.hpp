@@ -13,11 +13,30 @@ public:
     JointConstraint(const ConstraintConfig& _config, uint n_robot_joints);
     virtual ~JointConstraint();
 
+    /**
+     * @brief Convert the Joint reference input to the reference vector of this constraint. Throws if the input is invalid
+     */
+    virtual void referenceToVector(const base::commands::Joints& ref, base::VectorXd& y) const = 0;
+
     /**
      * @brief Update the Joint reference input for this constraint.
      */
-    virtual void setReference(const base::commands::Joints& ref) = 0;
+    void setReference(const base::commands::Joints& ref);
+
+    /**
+     * @brief Publish the Joint reference input to the control thread. Wait-free, can be called from any (single) producer thread. The input is validated
+     *  and converted on the calling thread. Throws if the input is invalid.
+     */
+    void publishReference(const base::commands::Joints& ref);
+
+    /**
+     * @brief Set the index of each constraint joint in the joint order of the robot model and initialize the constraint matrix accordingly.
+     *  Called by the scene in configure(), so that the joint names do not have to be resolved in each update. Throws if the size does not match the number of constraint joints
+     */
+    void setJointIndices(const std::vector<int>& idx);
 
+    /** Index of each constraint joint in the joint order of the robot model. The constraint matrix is a selection matrix, i.e. A(k,joint_idx[k]) = 1 and all other entries are zero*/
+    std::vector<int> joint_idx;
 };
 
 } //namespace wbc
@@ -13,11 +13,12 @@ public:
     virtual ~JointVelocityConstraint();
 
     /**
-     * @brief Update the Joint reference input for this constraint.
+     * @brief Convert the Joint reference input to the reference vector of this constraint. Throws if the input is invalid
      * @param ref Joint reference input. Vector size has ot be same number of constraint variables. Joint Names have to match the constraint joint names.
      * Each entry has to have a valid velocity. All other entries will be ignored.
+     * @param y Output: Reference vector. Has to have the correct size already
      */
-    virtual void setReference(const base::commands::Joints& ref);
+    virtual void referenceToVector(const base::commands::Joints& ref, base::VectorXd& y) const;
 };
 
 typedef std::shared_ptr<JointVelocityConstraint> JointVelocityConstraintPtr;
@@ -0,0 +1,125 @@
+#include "PipelinedExecutor.hpp"
+#include <base-logging/Logging.hpp>
+
+namespace wbc{
+
+PipelinedExecutor::PipelinedExecutor(WbcScenePtr scene, uint latency) :
+    scene(scene),
+    latency(0),
+    assemble_idx(0),
+    has_output(false),
+    job_pending(false),
+    job_done(false),
+    stop_requested(false){
+
+    if(!scene){
+        LOG_ERROR("PipelinedExecutor: Scene must not be null");
+        throw std::invalid_argument("Invalid scene");
+    }
+    setLatency(latency);
+}
+
+PipelinedExecutor::~PipelinedExecutor(){
+    stopSolverThread();
+}
+
+void PipelinedExecutor::setLatency(uint _latency){
+    if(_latency > 1){
+        LOG_ERROR("PipelinedExecutor: Latency has to be 0 or 1, but is %i", _latency);
+        throw std::invalid_argument("Invalid latency");
+    }
+    stopSolverThread();
+    latency = _latency;
+    has_output = false;
+    if(latency == 1)
+        startSolverThread();
+}
+
+void PipelinedExecutor::startSolverThread(){
+    stop_requested = false;
+    job_pending = job_done = false;
+    solver_exception = nullptr;
+    solver_thread = std::thread(&PipelinedExecutor::solverLoop, this);
+}
+
+void PipelinedExecutor::stopSolverThread(){
+    if(!solver_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+    }
+    cond.notify_all();
+    solver_thread.join();
+    job_pending = job_done = false;
+}
+
+void PipelinedExecutor::solverLoop(){
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+        cond.wait(lock, [this]{return stop_requested || (job_pending && !job_done);});
+        if(stop_requested)
+            return;
+
+        // The QP buffer that is not assembled is owned by the solver thread until job_done is set
+        const HierarchicalQP& qp = hqp[1-assemble_idx];
+        lock.unlock();
+        try{
+            solver_result = scene->solve(qp);
+        }
+        catch(...){
+            solver_exception = std::current_exception();
+        }
+        lock.lock();
+        job_done = true;
+        cond.notify_all();
+    }
+}
+
+void PipelinedExecutor::wait(){
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this]{return !job_pending || job_done;});
+}
+
+void PipelinedExecutor::collectResult(){
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this]{return !job_pending || job_done;});
+    if(!job_pending)
+        return;
+    job_pending = job_done = false;
+    if(solver_exception){
+        std::exception_ptr e = solver_exception;
+        solver_exception = nullptr;
+        has_output = false;
+        std::rethrow_exception(e);
+    }
+    output = solver_result;
+    has_output = true;
+}
+
+const base::commands::Joints& PipelinedExecutor::step(const base::samples::Joints& joint_state,
+                                                      const base::samples::RigidBodyStateSE3& floating_base_state){
+
+    // Assemble the QP for the given state. With latency 1, this runs concurrently to the solver thread
+    scene->getRobotModel()->update(joint_state, floating_base_state);
+    hqp[assemble_idx] = scene->update();
+
+    if(latency == 0){
+        output = scene->solve(hqp[assemble_idx]);
+        has_output = true;
+        return output;
+    }
+
+    // Wait for the solution of the previous cycle and hand the new QP to the solver thread
+    collectResult();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assemble_idx = 1-assemble_idx;
+        job_pending = true;
+        job_done = false;
+    }
+    cond.notify_all();
+    return output;
+}
+
+}
@@ -0,0 +1,86 @@
+#ifndef PIPELINED_EXECUTOR_HPP
+#define PIPELINED_EXECUTOR_HPP
+
+#include "Scene.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace wbc{
+
+/**
+ * @brief Executes the WBC control cycle (robot model update, scene update, solve) for a given scene, optionally pipelined across two control cycles.
+ *
+ *  - Latency 0: All steps are executed serially on the calling thread. step() returns the solution for the given robot state.
+ *  - Latency 1: The QP is solved on a separate solver thread. step() updates robot model and scene with the given state k, waits for the solution of the
+ *               QP of cycle k-1, hands the QP of cycle k to the solver thread and returns the solution of cycle k-1. Thus, while the solver thread works on
+ *               the QP of cycle k, the calling thread can already acquire the robot state of cycle k+1. The output is delayed by one control cycle.
+ *               In the first cycle, no solution is available and hasOutput() returns false.
+ *
+ *  Note: With latency 1, the scene must not be accessed from other threads while the executor is running, except for the asynchronous input
+ *  methods (WbcScene::publishReference() etc.). Call wait() before calling e.g. WbcScene::updateConstraintsStatus() or before changing the
+ *  configuration of the robot model, e.g. the active contacts.
+ */
+class PipelinedExecutor{
+protected:
+    WbcScenePtr scene;
+    uint latency;
+
+    HierarchicalQP hqp[2];          /** Double buffered QP: One is assembled while the other one is solved*/
+    uint assemble_idx;
+    base::commands::Joints output;
+    bool has_output;
+
+    std::thread solver_thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool job_pending;                 /** A QP has been handed to the solver thread*/
+    bool job_done;                    /** The solver thread finished the pending QP*/
+    bool stop_requested;
+    std::exception_ptr solver_exception;
+    base::commands::Joints solver_result;
+
+    void solverLoop();
+    void startSolverThread();
+    void stopSolverThread();
+    /** Block until the pending QP has been solved, copy the result to the output and rethrow solver exceptions*/
+    void collectResult();
+
+public:
+    /**
+     * @brief PipelinedExecutor
+     * @param scene Configured WBC scene
+     * @param latency Output latency in control cycles. Has to be 0 (serial execution) or 1 (pipelined execution)
+     */
+    PipelinedExecutor(WbcScenePtr scene, uint latency = 1);
+    ~PipelinedExecutor();
+
+    /**
+     * @brief Change the output latency. Waits for a pending solution, which is discarded
+     * @param latency Has to be 0 or 1
+     */
+    void setLatency(uint latency);
+
+    /** @brief Return the output latency in control cycles*/
+    uint getLatency() const {return latency;}
+
+    /**
+     * @brief Execute one control cycle
+     * @param joint_state Current joint state, passed to RobotModel::update()
+     * @param floating_base_state Current floating base state, passed to RobotModel::update()
+     * @return Solver output. With latency 1, this is the solution of the previous cycle. Check hasOutput() before using it.
+     */
+    const base::commands::Joints& step(const base::samples::Joints& joint_state,
+                                       const base::samples::RigidBodyStateSE3& floating_base_state = base::samples::RigidBodyStateSE3());
+
+    /** @brief True if step() returned a valid solver output, i.e. false in the first cycle if the latency is 1*/
+    bool hasOutput() const {return has_output;}
+
+    /** @brief Block until the solver thread is idle. The solution of a pending QP will be returned by the next call of step(). Not required for latency 0*/
+    void wait();
+};
+
+}
+
+#endif // PIPELINED_EXECUTOR_HPP
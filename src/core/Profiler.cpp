@@ -0,0 +1,161 @@
+#include "Profiler.hpp"
+#include <base-logging/Logging.hpp>
+#include <fstream>
+#include <cstring>
+#include <iomanip>
+#include <algorithm>
+
+namespace wbc{
+
+static uint32_t currentThreadId(){
+    static std::atomic<uint32_t> next_id(0);
+    thread_local uint32_t id = next_id++;
+    return id;
+}
+
+static void writeJSONString(std::ostream& out, const char* str){
+    out << '"';
+    for(const char* c = str; *c; c++){
+        if(*c == '"' || *c == '\\')
+            out << '\\' << *c;
+        else if((unsigned char)*c < 0x20)
+            out << ' ';
+        else
+            out << *c;
+    }
+    out << '"';
+}
+
+double ProfilerHistogram::quantileNs(double q) const{
+    if(count == 0)
+        return 0;
+    uint64_t n = 0;
+    for(uint i = 0; i < n_buckets; i++){
+        n += buckets[i];
+        if(n >= q*count)
+            return std::min((double)max_ns, (double)(uint64_t(1) << (i+1)));
+    }
+    return max_ns;
+}
+
+Profiler::Profiler(size_t capacity) :
+    slots(new Slot[capacity]),
+    capacity(capacity),
+    write_index(0),
+    enabled(true),
+    t0(std::chrono::steady_clock::now()){
+
+    if(capacity == 0){
+        LOG_ERROR("Profiler: Capacity must be > 0");
+        throw std::invalid_argument("Invalid profiler capacity");
+    }
+    clear();
+}
+
+Profiler& Profiler::instance(){
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::record(const char* name, const char* detail, uint64_t start_ns, uint64_t duration_ns){
+    const uint64_t idx = write_index.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[idx % capacity];
+
+    // Seqlock: Mark the slot as being written, so that readers can detect and drop torn events
+    slot.sequence.store(2*idx+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event.name = name;
+    if(detail){
+        strncpy(slot.event.detail, detail, sizeof(slot.event.detail)-1);
+        slot.event.detail[sizeof(slot.event.detail)-1] = 0;
+    }
+    else
+        slot.event.detail[0] = 0;
+    slot.event.start_ns = start_ns;
+    slot.event.duration_ns = duration_ns;
+    slot.event.thread_id = currentThreadId();
+    slot.sequence.store(2*(idx+1), std::memory_order_release);
+}
+
+void Profiler::clear(){
+    for(size_t i = 0; i < capacity; i++)
+        slots[i].sequence.store(0);
+    write_index = 0;
+}
+
+std::vector<ProfilerEvent> Profiler::getEvents() const{
+    const uint64_t end = write_index.load(std::memory_order_acquire);
+    const uint64_t begin = end > capacity ? end - capacity : 0;
+
+    std::vector<ProfilerEvent> events;
+    events.reserve(end-begin);
+    for(uint64_t idx = begin; idx < end; idx++){
+        const Slot& slot = slots[idx % capacity];
+        const uint64_t seq_before = slot.sequence.load(std::memory_order_acquire);
+        ProfilerEvent event = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t seq_after = slot.sequence.load(std::memory_order_relaxed);
+        if(seq_before == 2*(idx+1) && seq_after == seq_before)
+            events.push_back(event);
+    }
+    return events;
+}
+
+void Profiler::writeChromeTrace(std::ostream& out) const{
+    std::vector<ProfilerEvent> events = getEvents();
+    out << "{\"traceEvents\":[";
+    out << std::fixed << std::setprecision(3);
+    for(size_t i = 0; i < events.size(); i++){
+        const ProfilerEvent& e = events[i];
+        out << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+        writeJSONString(out, e.name);
+        out << ",\"cat\":\"wbc\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread_id
+            << ",\"ts\":" << e.start_ns/1000.0 << ",\"dur\":" << e.duration_ns/1000.0;
+        if(e.detail[0]){
+            out << ",\"args\":{\"detail\":";
+            writeJSONString(out, e.detail);
+            out << "}";
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
+}
+
+void Profiler::writeChromeTrace(const std::string& filename) const{
+    std::ofstream file(filename.c_str());
+    if(!file.is_open()){
+        LOG_ERROR("Profiler: Unable to open file %s", filename.c_str());
+        throw std::runtime_error("Invalid file name");
+    }
+    writeChromeTrace(file);
+}
+
+std::map<std::string, ProfilerHistogram> Profiler::histograms() const{
+    std::map<std::string, ProfilerHistogram> result;
+    for(const ProfilerEvent& e : getEvents()){
+        ProfilerHistogram& h = result[e.name];
+        h.count++;
+        h.total_ns += e.duration_ns;
+        h.min_ns = std::min(h.min_ns, e.duration_ns);
+        h.max_ns = std::max(h.max_ns, e.duration_ns);
+        uint bucket = 0;
+        while(bucket < ProfilerHistogram::n_buckets-1 && (e.duration_ns >> (bucket+1)) > 0)
+            bucket++;
+        h.buckets[bucket]++;
+    }
+    return result;
+}
+
+void Profiler::printSummary(std::ostream& out) const{
+    out << std::left << std::setw(48) << "Stage" << std::right << std::setw(10) << "Count" << std::setw(12) << "Mean [us]"
+        << std::setw(12) << "Min [us]" << std::setw(12) << "Median [us]" << std::setw(12) << "99% [us]" << std::setw(12) << "Max [us]" << std::endl;
+    out << std::fixed << std::setprecision(2);
+    for(const auto& it : histograms()){
+        const ProfilerHistogram& h = it.second;
+        out << std::left << std::setw(48) << it.first << std::right << std::setw(10) << h.count << std::setw(12) << h.meanNs()/1000.0
+            << std::setw(12) << h.min_ns/1000.0 << std::setw(12) << h.quantileNs(0.5)/1000.0 << std::setw(12) << h.quantileNs(0.99)/1000.0
+            << std::setw(12) << h.max_ns/1000.0 << std::endl;
+    }
+}
+
+}
@@ -0,0 +1,140 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace wbc{
+
+/** @brief A single timed section, as recorded by ScopedTimer*/
+struct ProfilerEvent{
+    const char* name;     /** Name of the stage. Has to be a string literal (static lifetime)*/
+    char detail[32];      /** Optional detail, e.g. a constraint name. Truncated to 31 characters*/
+    uint64_t start_ns;    /** Start time in ns since the construction of the profiler*/
+    uint64_t duration_ns; /** Duration in ns*/
+    uint32_t thread_id;   /** Id of the recording thread*/
+};
+
+/** @brief Aggregated timing statistics of one stage*/
+struct ProfilerHistogram{
+    ProfilerHistogram() : count(0), total_ns(0), min_ns(UINT64_MAX), max_ns(0), buckets(n_buckets,0){}
+
+    /** Bucket i counts all durations in [2^i, 2^(i+1)) ns*/
+    static const uint n_buckets = 40;
+
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    std::vector<uint64_t> buckets;
+
+    double meanNs() const {return count > 0 ? (double)total_ns / count : 0.0;}
+
+    /** Approximate quantile (0..1) in ns, i.e. the upper edge of the bucket containing the quantile*/
+    double quantileNs(double q) const;
+};
+
+/**
+ * @brief Collects timing events from all threads in a lock-free ring buffer of fixed size. If the buffer is full, the oldest events are overwritten.
+ *  Events are recorded with the scoped timer macros WBC_PROFILE_SCOPE() and WBC_PROFILE_SCOPE_DETAIL(), which compile to nothing unless the
+ *  library is built with WBC_ENABLE_PROFILING (cmake option ENABLE_PROFILING). The recorded events can be dumped as Chrome trace JSON (open with
+ *  chrome://tracing or https://ui.perfetto.dev) or aggregated to per-stage histograms.
+ *
+ *  Recording is wait-free. Reading (getEvents(), writeChromeTrace(), histograms()) is safe while other threads record, but events that are being
+ *  overwritten during the read are dropped.
+ */
+class Profiler{
+protected:
+    struct Slot{
+        std::atomic<uint64_t> sequence; /** Odd while the slot is written, 2*(index+1) when it contains the event with the given index*/
+        ProfilerEvent event;
+    };
+    std::unique_ptr<Slot[]> slots;
+    size_t capacity;
+    std::atomic<uint64_t> write_index;
+    std::atomic<bool> enabled;
+    std::chrono::steady_clock::time_point t0;
+
+public:
+    /**
+     * @brief Profiler
+     * @param capacity Maximum number of events kept in the ring buffer
+     */
+    Profiler(size_t capacity = 65536);
+
+    /** @brief Global profiler instance, used by the profiling macros*/
+    static Profiler& instance();
+
+    /** @brief Enable/disable recording at runtime. Enabled by default*/
+    void setEnabled(bool enable){enabled = enable;}
+
+    /** @brief Return true if events are currently recorded*/
+    bool isEnabled() const {return enabled;}
+
+    /** @brief Return current time in ns since the construction of the profiler*/
+    uint64_t now() const {return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();}
+
+    /** @brief Record an event. name has to be a string literal, detail may be null*/
+    void record(const char* name, const char* detail, uint64_t start_ns, uint64_t duration_ns);
+
+    /** @brief Discard all recorded events*/
+    void clear();
+
+    /** @brief Return the size of the ring buffer*/
+    size_t getCapacity() const {return capacity;}
+
+    /** @brief Return the total number of events recorded since the last clear(), including overwritten ones*/
+    uint64_t noOfRecordedEvents() const {return write_index;}
+
+    /** @brief Return all events that are currently in the ring buffer, oldest first*/
+    std::vector<ProfilerEvent> getEvents() const;
+
+    /** @brief Write all events in the ring buffer in Chrome trace event format (JSON)*/
+    void writeChromeTrace(std::ostream& out) const;
+
+    /** @brief Write all events in the ring buffer in Chrome trace event format to the given file. Throws if the file cannot be opened*/
+    void writeChromeTrace(const std::string& filename) const;
+
+    /** @brief Aggregate all events in the ring buffer per stage name*/
+    std::map<std::string, ProfilerHistogram> histograms() const;
+
+    /** @brief Print count, mean, min, median, 99% quantile and max duration of each stage*/
+    void printSummary(std::ostream& out) const;
+};
+
+/** @brief Measures the time between its construction and destruction and records it in the global profiler*/
+class ScopedTimer{
+    const char* name;
+    const char* detail;
+    uint64_t start_ns;
+public:
+    ScopedTimer(const char* name, const char* detail = 0) : name(name), detail(detail), start_ns(Profiler::instance().now()){}
+    ~ScopedTimer(){
+        Profiler& profiler = Profiler::instance();
+        if(profiler.isEnabled())
+            profiler.record(name, detail, start_ns, profiler.now() - start_ns);
+    }
+};
+
+}
+
+#define WBC_PROFILE_CONCAT_IMPL(a,b) a##b
+#define WBC_PROFILE_CONCAT(a,b) WBC_PROFILE_CONCAT_IMPL(a,b)
+
+#ifdef WBC_ENABLE_PROFILING
+/** Time the enclosing scope. name has to be a string literal*/
+#define WBC_PROFILE_SCOPE(name) wbc::ScopedTimer WBC_PROFILE_CONCAT(wbc_scoped_timer_, __LINE__)(name)
+/** Time the enclosing scope with additional detail, e.g. a constraint name. name has to be a string literal, detail a C string*/
+#define WBC_PROFILE_SCOPE_DETAIL(name, detail) wbc::ScopedTimer WBC_PROFILE_CONCAT(wbc_scoped_timer_, __LINE__)(name, detail)
+#else
+#define WBC_PROFILE_SCOPE(name)
+#define WBC_PROFILE_SCOPE_DETAIL(name, detail)
+#endif
+
+#endif // PROFILER_HPP
@@ -0,0 +1,22 @@
+#include "QPSolver.hpp"
+#include <base-logging/Logging.hpp>
+
+namespace wbc{
+
+SolverStatus QPSolver::trySolve(const HierarchicalQP& hierarchical_qp, base::VectorXd &solver_output){
+    failure_reason.clear();
+    try{
+        solve(hierarchical_qp, solver_output);
+    }
+    catch(std::invalid_argument &e){
+        throw;
+    }
+    catch(std::exception &e){
+        failure_reason = e.what();
+        LOG_ERROR("QPSolver::trySolve: %s", e.what());
+        return solver_failed;
+    }
+    return time_budget_exceeded ? solver_timeout : solver_success;
+}
+
+}
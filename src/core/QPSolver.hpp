@@ -4,16 +4,28 @@
 #include <vector>
 #include <base/Eigen.hpp>
 #include <memory>
+#include <stdexcept>
+#include <string>
 
 namespace wbc{
 
 class HierarchicalQP;
 
+/** Result of QPSolver::trySolve()*/
+enum SolverStatus{solver_success,   /** The QP has been solved*/
+                  solver_recovered, /** The QP could not be solved, the output has been computed by the recovery strategy of the solver*/
+                  solver_failed,    /** The QP could not be solved and the output is invalid*/
+                  solver_timeout    /** The time budget expired, the output is the best iterate found so far (see QPSolver::setMaxSolveTime())*/
+                 };
+
 class QPSolver{
 protected:
     bool configured;
+    double max_solve_time;
+    bool time_budget_exceeded;
+    std::string failure_reason;
 public:
-    QPSolver() : configured(false){}
+    QPSolver() : configured(false), max_solve_time(0), time_budget_exceeded(false){}
     virtual ~QPSolver(){}
     /**
      * @brief solve Solve the given quadratic program
@@ -23,6 +35,29 @@ public:
      */
     virtual void solve(const HierarchicalQP& hierarchical_qp, base::VectorXd &solver_output) = 0;
 
+    /**
+     * @brief trySolve Variant of solve() for the control path, which reports numerical failures via the return value instead of throwing. Solvers may override this
+     *  to recover from failures. The default implementation calls solve(). If solve() throws, the error is logged, stored (see getFailureReason()) and solver_failed
+     *  is returned. Invalid input, i.e. std::invalid_argument, e.g. wrong problem dimensions, is not a solver failure and is propagated to the caller.
+     */
+    virtual SolverStatus trySolve(const HierarchicalQP& hierarchical_qp, base::VectorXd &solver_output);
+
+    /** @brief Return the reason of the failure, if the last call to trySolve() returned solver_failed. Empty otherwise*/
+    const std::string& getFailureReason(){return failure_reason;}
+
+    /**
+     * @brief Set a wall-clock time budget in seconds for each call to solve(). If the budget expires, the solver stops and returns the best iterate found so far,
+     *  see timeBudgetExceeded() for details. The budget is checked at the granularity of the solver, e.g. per priority level or working set change, so that it may be slightly exceeded.
+     *  A value <= 0 means no budget. Default is 0.
+     */
+    void setMaxSolveTime(const double t){max_solve_time = t;}
+
+    /** @brief Return the time budget for each call to solve() in seconds*/
+    double getMaxSolveTime(){return max_solve_time;}
+
+    /** @brief Return true if the time budget expired in the last call to solve(). In this case, the solver output is only an approximate solution*/
+    bool timeBudgetExceeded(){return time_budget_exceeded;}
+
     /** @brief reset Enforces reconfiguration at next call to solve() */
     void reset(){configured=false;}
 };
@@ -3,6 +3,11 @@
 
 namespace wbc {
 
+QuadraticProgram::QuadraticProgram() :
+    nc(0),
+    nq(0){
+}
+
 void QuadraticProgram::resize(const uint _nc, const uint _nq){
     nc = _nc;
     nq = _nq;
@@ -28,6 +33,13 @@ void QuadraticProgram::resize(const uint _nc, const uint _nq){
     Wy.setOnes(nc);
 }
 
+bool QuadraticProgram::resizeIfRequired(const uint _nc, const uint _nq){
+    if(nc == (int)_nc && nq == (int)_nq && A.rows() == (int)_nc && A.cols() == (int)_nq)
+        return false;
+    resize(_nc, _nq);
+    return true;
+}
+
 void QuadraticProgram::print() const{
     std::cout<<"-- Quadratic Program --"<<std::endl;
     std::cout<<"Size "<<nc<<" X "<<nq<<std::endl;
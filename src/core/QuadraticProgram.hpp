@@ -34,8 +34,12 @@ public:
     int nc;                 /** Number of constraints for this prio*/
     int nq;                 /** Number of all joints (actuated + unactuated)*/
 
+    QuadraticProgram();
+
     /** Initialize all variables with NaN */
     void resize(const uint nc, const uint nq);
+    /** Call resize() only if the size of the QP differs from the given size. Returns true if the QP has been resized, in which case all variables are NaN*/
+    bool resizeIfRequired(const uint nc, const uint nq);
     /** Print content to console*/
     void print() const;
 
@@ -11,7 +11,8 @@ std::vector<std::string> operator+(std::vector<std::string> a, std::vector<std::
 }
 
 RobotModel::RobotModel() :
-    gravity(base::Vector3d(0,0,-9.81)){
+    gravity(base::Vector3d(0,0,-9.81)),
+    state_revision(0){
 }
 
 void RobotModel::updateFloatingBase(const base::samples::RigidBodyStateSE3& rbs,
@@ -55,12 +56,23 @@ void RobotModel::updateFloatingBase(const base::samples::RigidBodyStateSE3& rbs,
         joint_state.time = rbs.time;
 }
 
+bool RobotModel::hasStructuralChanges(const RobotModelConfig& cfg) const{
+    return cfg.file != robot_model_config.file ||
+           cfg.submechanism_file != robot_model_config.submechanism_file ||
+           cfg.type != robot_model_config.type ||
+           cfg.joint_names != robot_model_config.joint_names ||
+           cfg.floating_base != robot_model_config.floating_base ||
+           cfg.world_frame_id != robot_model_config.world_frame_id ||
+           cfg.joint_blacklist != robot_model_config.joint_blacklist;
+}
+
 void RobotModel::setActiveContacts(const ActiveContacts &contacts){
     for(auto name : contacts.names){
         if(contacts[name] != 0 && contacts[name] != 1)
             throw std::runtime_error("RobotModel::setActiveContacts: Contact value has to been 0 or 1");
     }
     active_contacts = contacts;
+    state_revision++;
 }
 
 } // namespace wbc
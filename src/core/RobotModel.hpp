@@ -24,12 +24,18 @@ protected:
                             const std::vector<std::string> &floating_base_virtual_joint_names,
                             base::samples::Joints& joint_state);
 
+    /** @brief Return true if the given configuration differs from the current one in a way that affects the structure of the model, i.e.,
+     *  model file, submechanism file, model type, joint names, joint blacklist or floating base settings. Changes in actuated joints and contact points
+     *  are not considered structural.*/
+    bool hasStructuralChanges(const RobotModelConfig& cfg) const;
+
     std::vector<std::string> contact_points;
     ActiveContacts active_contacts;
     base::Vector3d gravity;
     base::samples::RigidBodyStateSE3 floating_base_state;
     base::samples::Wrenches contact_wrenches;
     RobotModelConfig robot_model_config;
+    unsigned long state_revision;
 
 public:
     RobotModel();
@@ -42,6 +48,15 @@ public:
      */
     virtual bool configure(const RobotModelConfig& cfg) = 0;
 
+    /**
+     * @brief Change the configuration of an already configured model. Implementations should only update the parts that differ from the current configuration
+     *  and keep the parsed model, kinematic chains and preallocated buffers whenever the model structure is not affected, e.g. if only the contact points or the actuated joints change.
+     *  The default implementation performs a full configure().
+     * @param cfg New model configuration. See RobotModelConfig.hpp for details
+     * @return True in case of success, else false
+     */
+    virtual bool reconfigure(const RobotModelConfig& cfg){return configure(cfg);}
+
     /**
      * @brief Update the robot configuration
      * @param joint_state The joint_state vector. Has to contain all robot joints that are configured in the model.
@@ -129,6 +144,17 @@ public:
     /** @brief Compute and return center of mass expressed in base frame*/
     virtual const base::samples::RigidBodyStateSE3& centerOfMass() = 0;
 
+    /** @brief Compute and return the CoM Jacobian, which is 3 x nj, where nj is the number of joints of the system. Reference frame is the base frame of the robot.
+      * The order of the columns will be the same as the configured joint order of the robot*/
+    virtual const base::MatrixXd& comJacobian() = 0;
+
+    /** @brief Compute and return the CoM acceleration bias, i.e. the term Jcom_dot*qdot, expressed in base frame*/
+    virtual const base::Vector3d& comAccelerationBias() = 0;
+
+    /** @brief Compute and return the centroidal momentum matrix A_G, which is 6 x nj, where nj is the number of joints of the system. A_G maps the joint velocities to
+      * the spatial momentum of the robot about its CoM, expressed in base frame. First three rows correspond to linear, last three rows to angular momentum*/
+    virtual const base::MatrixXd& centroidalMomentumMatrix() = 0;
+
     /** @brief Provide information about which link is currently in contact with the environment*/
     void setActiveContacts(const ActiveContacts &contacts);
 
@@ -142,7 +168,7 @@ public:
     uint noOfActuatedJoints(){return actuatedJointNames().size();}
 
     /** @brief Set the current gravity vector*/
-    void setGravityVector(const base::Vector3d& g){gravity=g;}
+    void setGravityVector(const base::Vector3d& g){gravity=g;state_revision++;}
 
     /** @brief Get current status of floating base*/
     const base::samples::RigidBodyStateSE3& floatingBaseState(){return floating_base_state;}
@@ -156,6 +182,10 @@ public:
     /** @brief Get current robot model config*/
     const RobotModelConfig& getRobotModelConfig(){return robot_model_config;}
 
+    /** @brief Return the state revision of the model. The revision is incremented whenever a quantity that depends on the robot state might have changed, i.e.
+     *  on every call to update(), configure(), setActiveContacts() or setGravityVector(). Can be used to detect if cached kinematic or dynamic quantities are still valid*/
+    unsigned long stateRevision() const {return state_revision;}
+
 };
 typedef std::shared_ptr<RobotModel> RobotModelPtr;
 
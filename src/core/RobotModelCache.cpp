@@ -0,0 +1,164 @@
+#include "RobotModelCache.hpp"
+#include <base-logging/Logging.hpp>
+
+namespace wbc{
+
+RobotModelCache::RobotModelCache(RobotModelPtr robot_model) :
+    revision(0),
+    initialized(false),
+    n_hits(0),
+    n_misses(0){
+    setRobotModel(robot_model);
+}
+
+void RobotModelCache::setRobotModel(RobotModelPtr model){
+    robot_model = model;
+    chains.clear();
+    chain_handles.clear();
+    invalidate();
+}
+
+void RobotModelCache::invalidate(){
+    for(auto &c : chains)
+        std::fill(c.valid, c.valid + n_chain_quantities, false);
+    std::fill(robot_valid, robot_valid + n_robot_quantities, false);
+    initialized = false;
+}
+
+void RobotModelCache::checkRevision(){
+    if(!robot_model){
+        LOG_ERROR("RobotModelCache: Robot model has not been set");
+        throw std::runtime_error("Invalid robot model");
+    }
+    const unsigned long current_revision = robot_model->stateRevision();
+    if(!initialized || current_revision != revision){
+        invalidate();
+        revision = current_revision;
+        initialized = true;
+    }
+}
+
+uint RobotModelCache::chainHandle(const std::string &root_frame, const std::string &tip_frame){
+    const std::pair<std::string,std::string> key(root_frame, tip_frame);
+    auto it = chain_handles.find(key);
+    if(it != chain_handles.end())
+        return it->second;
+
+    ChainEntry entry;
+    entry.root = root_frame;
+    entry.tip = tip_frame;
+    std::fill(entry.valid, entry.valid + n_chain_quantities, false);
+    chains.push_back(entry);
+    chain_handles[key] = chains.size()-1;
+    return chains.size()-1;
+}
+
+RobotModelCache::ChainEntry& RobotModelCache::chain(uint handle){
+    if(handle >= chains.size()){
+        LOG_ERROR("RobotModelCache: Invalid chain handle %i. Number of chains is %i", handle, chains.size());
+        throw std::invalid_argument("Invalid chain handle");
+    }
+    checkRevision();
+    return chains[handle];
+}
+
+const base::samples::RigidBodyStateSE3& RobotModelCache::rigidBodyState(uint handle){
+    ChainEntry& c = chain(handle);
+    if(!isCached(c.valid[rigid_body_state])){
+        c.rigid_body_state = robot_model->rigidBodyState(c.root, c.tip);
+        c.valid[rigid_body_state] = true;
+    }
+    return c.rigid_body_state;
+}
+
+const base::MatrixXd& RobotModelCache::spaceJacobian(uint handle){
+    ChainEntry& c = chain(handle);
+    if(!isCached(c.valid[space_jacobian])){
+        c.space_jacobian = robot_model->spaceJacobian(c.root, c.tip);
+        c.valid[space_jacobian] = true;
+    }
+    return c.space_jacobian;
+}
+
+const base::MatrixXd& RobotModelCache::bodyJacobian(uint handle){
+    ChainEntry& c = chain(handle);
+    if(!isCached(c.valid[body_jacobian])){
+        c.body_jacobian = robot_model->bodyJacobian(c.root, c.tip);
+        c.valid[body_jacobian] = true;
+    }
+    return c.body_jacobian;
+}
+
+const base::MatrixXd& RobotModelCache::jacobianDot(uint handle){
+    ChainEntry& c = chain(handle);
+    if(!isCached(c.valid[jacobian_dot])){
+        c.jacobian_dot = robot_model->jacobianDot(c.root, c.tip);
+        c.valid[jacobian_dot] = true;
+    }
+    return c.jacobian_dot;
+}
+
+const base::Acceleration& RobotModelCache::spatialAccelerationBias(uint handle){
+    ChainEntry& c = chain(handle);
+    if(!isCached(c.valid[spatial_acceleration_bias])){
+        c.spatial_acceleration_bias = robot_model->spatialAccelerationBias(c.root, c.tip);
+        c.valid[spatial_acceleration_bias] = true;
+    }
+    return c.spatial_acceleration_bias;
+}
+
+const base::samples::Joints& RobotModelCache::jointState(){
+    checkRevision();
+    if(!isCached(robot_valid[joint_state])){
+        joint_state_all = robot_model->jointState(robot_model->jointNames());
+        robot_valid[joint_state] = true;
+    }
+    return joint_state_all;
+}
+
+const base::MatrixXd& RobotModelCache::jointSpaceInertiaMatrix(){
+    checkRevision();
+    if(!isCached(robot_valid[joint_space_inertia_matrix])){
+        inertia_matrix = robot_model->jointSpaceInertiaMatrix();
+        robot_valid[joint_space_inertia_matrix] = true;
+    }
+    return inertia_matrix;
+}
+
+const base::VectorXd& RobotModelCache::biasForces(){
+    checkRevision();
+    if(!isCached(robot_valid[bias_forces])){
+        bias_force_vector = robot_model->biasForces();
+        robot_valid[bias_forces] = true;
+    }
+    return bias_force_vector;
+}
+
+const base::samples::RigidBodyStateSE3& RobotModelCache::centerOfMass(){
+    checkRevision();
+    if(!isCached(robot_valid[center_of_mass])){
+        com = robot_model->centerOfMass();
+        robot_valid[center_of_mass] = true;
+    }
+    return com;
+}
+
+const base::MatrixXd& RobotModelCache::comJacobian(){
+    checkRevision();
+    if(!isCached(robot_valid[com_jacobian])){
+        com_jac = robot_model->comJacobian();
+        robot_valid[com_jacobian] = true;
+    }
+    return com_jac;
+}
+
+const base::Vector3d& RobotModelCache::comAccelerationBias(){
+    checkRevision();
+    if(!isCached(robot_valid[com_acceleration_bias])){
+        com_acc_bias = robot_model->comAccelerationBias();
+        robot_valid[com_acceleration_bias] = true;
+    }
+    return com_acc_bias;
+}
+
+}
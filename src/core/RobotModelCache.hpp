@@ -0,0 +1,125 @@
+#ifndef ROBOT_MODEL_CACHE_HPP
+#define ROBOT_MODEL_CACHE_HPP
+
+#include "RobotModel.hpp"
+#include <map>
+#include <deque>
+
+namespace wbc{
+
+/**
+ * @brief Memoizes the kinematic and dynamic quantities of a robot model within one control cycle. Each quantity is computed by the robot model only on
+ *  the first request after a change of the robot state. Subsequent requests, e.g. the same Jacobian requested in update() and updateConstraintsStatus()
+ *  or by several constraints and contacts, return the cached value. All cached values are invalidated as soon as the state revision of the robot model
+ *  changes, i.e. on every call to RobotModel::update(), setActiveContacts() etc.
+ *
+ *  Kinematic chains are identified by handles, which can be obtained once via chainHandle() to avoid the lookup of root and tip frame in each request.
+ */
+class RobotModelCache{
+protected:
+    enum ChainQuantity{rigid_body_state, space_jacobian, body_jacobian, jacobian_dot, spatial_acceleration_bias, n_chain_quantities};
+    enum RobotQuantity{joint_state, joint_space_inertia_matrix, bias_forces, center_of_mass, com_jacobian, com_acceleration_bias, n_robot_quantities};
+
+    struct ChainEntry{
+        std::string root, tip;
+        base::samples::RigidBodyStateSE3 rigid_body_state;
+        base::MatrixXd space_jacobian, body_jacobian, jacobian_dot;
+        base::Acceleration spatial_acceleration_bias;
+        bool valid[n_chain_quantities];
+    };
+
+    RobotModelPtr robot_model;
+    std::deque<ChainEntry> chains; /** deque, so that references to cached values stay valid if new chains are added*/
+    std::map<std::pair<std::string,std::string>, uint> chain_handles;
+    unsigned long revision;
+    bool initialized;
+
+    base::samples::Joints joint_state_all;
+    base::MatrixXd inertia_matrix, com_jac;
+    base::VectorXd bias_force_vector;
+    base::samples::RigidBodyStateSE3 com;
+    base::Vector3d com_acc_bias;
+    bool robot_valid[n_robot_quantities];
+
+    unsigned long n_hits, n_misses;
+
+    /** Invalidate all cached values if the robot state changed since the last request*/
+    void checkRevision();
+
+    /** Return true and count a hit if the given cache entry is valid, otherwise count a miss and return false*/
+    bool isCached(bool valid){
+        if(valid)
+            n_hits++;
+        else
+            n_misses++;
+        return valid;
+    }
+
+    ChainEntry& chain(uint handle);
+
+public:
+    RobotModelCache(RobotModelPtr robot_model = RobotModelPtr());
+
+    /** @brief Set the robot model whose quantities are cached. Clears all cached values and chain handles*/
+    void setRobotModel(RobotModelPtr model);
+
+    /** @brief Return the handle of the kinematic chain between root_frame and tip_frame. Handles stay valid until setRobotModel() is called*/
+    uint chainHandle(const std::string &root_frame, const std::string &tip_frame);
+
+    /** @brief Invalidate all cached values, independent of the state revision of the robot model*/
+    void invalidate();
+
+    /** @brief Cached version of RobotModel::rigidBodyState()*/
+    const base::samples::RigidBodyStateSE3& rigidBodyState(uint handle);
+    const base::samples::RigidBodyStateSE3& rigidBodyState(const std::string &root_frame, const std::string &tip_frame){return rigidBodyState(chainHandle(root_frame, tip_frame));}
+
+    /** @brief Cached version of RobotModel::spaceJacobian()*/
+    const base::MatrixXd& spaceJacobian(uint handle);
+    const base::MatrixXd& spaceJacobian(const std::string &root_frame, const std::string &tip_frame){return spaceJacobian(chainHandle(root_frame, tip_frame));}
+
+    /** @brief Cached version of RobotModel::bodyJacobian()*/
+    const base::MatrixXd& bodyJacobian(uint handle);
+    const base::MatrixXd& bodyJacobian(const std::string &root_frame, const std::string &tip_frame){return bodyJacobian(chainHandle(root_frame, tip_frame));}
+
+    /** @brief Cached version of RobotModel::jacobianDot()*/
+    const base::MatrixXd& jacobianDot(uint handle);
+    const base::MatrixXd& jacobianDot(const std::string &root_frame, const std::string &tip_frame){return jacobianDot(chainHandle(root_frame, tip_frame));}
+
+    /** @brief Cached version of RobotModel::spatialAccelerationBias()*/
+    const base::Acceleration& spatialAccelerationBias(uint handle);
+    const base::Acceleration& spatialAccelerationBias(const std::string &root_frame, const std::string &tip_frame){return spatialAccelerationBias(chainHandle(root_frame, tip_frame));}
+
+    /** @brief Cached version of RobotModel::jointState() for all joints, in the order of RobotModel::jointNames()*/
+    const base::samples::Joints& jointState();
+
+    /** @brief Cached version of RobotModel::jointSpaceInertiaMatrix()*/
+    const base::MatrixXd& jointSpaceInertiaMatrix();
+
+    /** @brief Cached version of RobotModel::biasForces()*/
+    const base::VectorXd& biasForces();
+
+    /** @brief Cached version of RobotModel::centerOfMass()*/
+    const base::samples::RigidBodyStateSE3& centerOfMass();
+
+    /** @brief Cached version of RobotModel::comJacobian()*/
+    const base::MatrixXd& comJacobian();
+
+    /** @brief Cached version of RobotModel::comAccelerationBias()*/
+    const base::Vector3d& comAccelerationBias();
+
+    /** @brief Number of requests that have been served from the cache*/
+    unsigned long noOfHits() const {return n_hits;}
+
+    /** @brief Number of requests that required a computation by the robot model*/
+    unsigned long noOfMisses() const {return n_misses;}
+
+    /** @brief Ratio of cache hits to all requests. 0 if nothing has been requested yet*/
+    double hitRate() const {return n_hits + n_misses > 0 ? (double)n_hits / (n_hits + n_misses) : 0.0;}
+
+    /** @brief Reset hit and miss counters*/
+    void resetCounters(){n_hits = n_misses = 0;}
+};
+
+}
+
+#endif // ROBOT_MODEL_CACHE_HPP
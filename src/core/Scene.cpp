@@ -8,7 +8,13 @@ namespace wbc{
 WbcScene::WbcScene(RobotModelPtr robot_model, QPSolverPtr solver) :
     robot_model(robot_model),
     solver(solver),
-    configured(false){
+    configured(false),
+    solver_status(solver_success),
+    robot_model_revision(0),
+    full_update_required(true),
+    n_skipped_constraints(0),
+    compact_qp(false),
+    model_cache(robot_model){
 }
 
 WbcScene::~WbcScene(){
@@ -72,6 +78,7 @@ bool WbcScene::configure(const std::vector<ConstraintConfig> &config){
     std::fill(actuated_joint_weights.elements.begin(), actuated_joint_weights.elements.end(), 1);
 
     wbc_config = config;
+    full_update_required = true;
 
     // Check WBC config
     for(auto cfg : wbc_config){
@@ -92,13 +99,31 @@ bool WbcScene::configure(const std::vector<ConstraintConfig> &config){
         }
     }
 
+    // Joint space constraints are selection matrices. Resolve their joint indices once here instead of in each update
+    for(uint prio = 0; prio < constraints.size(); prio++){
+        for(uint i = 0; i < constraints[prio].size(); i++){
+            ConstraintPtr constraint = constraints[prio][i];
+            if(constraint->config.type != jnt)
+                continue;
+            std::vector<int> joint_idx;
+            for(const std::string& name : constraint->config.joint_names){
+                if(!robot_model->hasJoint(name)){
+                    LOG_ERROR("Constraint %s contains joint %s, but this joint is not in the robot model", constraint->config.name.c_str(), name.c_str());
+                    return false;
+                }
+                joint_idx.push_back(robot_model->jointIndex(name));
+            }
+            std::static_pointer_cast<JointConstraint>(constraint)->setJointIndices(joint_idx);
+        }
+    }
+
     return true;
 }
 
 void WbcScene::setReference(const std::string& constraint_name, const base::samples::Joints& ref){
     ConstraintPtr c = getConstraint(constraint_name);
-    if(c->config.type == cart)
-        throw std::runtime_error("Constraint '" + c->config.name + "' has type cart, but you are trying to set a joint space reference");
+    if(c->config.type != jnt)
+        throw std::runtime_error("Constraint '" + c->config.name + "' is not a joint space constraint, but you are trying to set a joint space reference");
     std::static_pointer_cast<JointConstraint>(c)->setReference(ref);
 }
 
@@ -117,6 +142,35 @@ void WbcScene::setTaskActivation(const std::string& constraint_name, const doubl
     getConstraint(constraint_name)->setActivation(activation);
 }
 
+void WbcScene::publishReference(const std::string& constraint_name, const base::samples::Joints& ref){
+    ConstraintPtr c = getConstraint(constraint_name);
+    if(c->config.type != jnt)
+        throw std::runtime_error("Constraint '" + c->config.name + "' is not a joint space constraint, but you are trying to publish a joint space reference");
+    std::static_pointer_cast<JointConstraint>(c)->publishReference(ref);
+}
+
+void WbcScene::publishReference(const std::string& constraint_name, const base::samples::RigidBodyStateSE3& ref){
+    ConstraintPtr c = getConstraint(constraint_name);
+    if(c->config.type == jnt)
+        throw std::runtime_error("Constraint '" + c->config.name + "' has type jnt, but you are trying to publish a cartesian reference");
+    std::static_pointer_cast<CartesianConstraint>(c)->publishReference(ref);
+}
+
+void WbcScene::publishTaskWeights(const std::string& constraint_name, const base::VectorXd &weights){
+    getConstraint(constraint_name)->publishWeights(weights);
+}
+
+void WbcScene::publishTaskActivation(const std::string& constraint_name, const double activation){
+    getConstraint(constraint_name)->publishActivation(activation);
+}
+
+void WbcScene::fetchInputs(){
+    for(auto &prio : constraints){
+        for(auto &c : prio)
+            c->fetchInputs();
+    }
+}
+
 ConstraintPtr WbcScene::getConstraint(const std::string& name){
 
     for(size_t i = 0; i < constraints.size(); i++){
@@ -199,6 +253,40 @@ void WbcScene::setJointWeights(const JointWeights &weights){
 
     for(auto n : actuated_joint_weights.names)
         actuated_joint_weights[n] = joint_weights[n];
+    full_update_required = true;
+}
+
+bool WbcScene::robotModelChanged(){
+    const unsigned long revision = robot_model->stateRevision();
+    const bool changed = full_update_required || revision != robot_model_revision;
+    robot_model_revision = revision;
+    return changed;
+}
+
+bool WbcScene::constraintNeedsUpdate(const ConstraintPtr constraint, bool robot_model_changed) const{
+    if(full_update_required || constraint->hasChanged())
+        return true;
+    // Joint space constraints and inactive constraints do not depend on the robot state
+    return constraint->config.type != jnt && !isInactive(constraint) && robot_model_changed;
+}
+
+void WbcScene::skipConstraint(const ConstraintPtr constraint){
+    // If the activation value is zero, also set reference to zero. Activation is usually used to switch between different
+    // task phases and we don't want to store the "old" reference value, in case we switch on the constraint again
+    if(constraint->activation == 0){
+        constraint->y_ref.setZero();
+        constraint->y_ref_root.setZero();
+    }
+    constraint->Aw.setZero();
+    n_skipped_constraints++;
+}
+
+void WbcScene::clearChanges(){
+    for(auto &prio : constraints){
+        for(auto &c : prio)
+            c->clearChanges();
+    }
+    full_update_required = false;
 }
 
 } // namespace wbc
@@ -5,6 +5,8 @@
 #include "QuadraticProgram.hpp"
 #include "RobotModel.hpp"
 #include "QPSolver.hpp"
+#include "HierarchicalQPCompactor.hpp"
+#include "RobotModelCache.hpp"
 
 namespace wbc{
 
@@ -21,8 +23,15 @@ protected:
     std::vector<int> n_constraint_variables_per_prio;
     bool configured;
     base::commands::Joints solver_output_joints;
+    SolverStatus solver_status;
     JointWeights joint_weights, actuated_joint_weights;
     std::vector<ConstraintConfig> wbc_config;
+    unsigned long robot_model_revision;
+    bool full_update_required;
+    uint n_skipped_constraints;
+    bool compact_qp;
+    HierarchicalQPCompactor compactor;
+    RobotModelCache model_cache;
 
     /**
      * brief Create a constraint and add it to the WBC scene
@@ -34,6 +43,42 @@ protected:
      */
     void clearConstraints();
 
+    /**
+     * @brief Apply the reference values, weights and activations that have been published asynchronously to the constraints. To be called at the beginning of update()
+     */
+    void fetchInputs();
+
+    /**
+     * @brief Return true if the state of the robot model changed since the last call of this method, i.e. if all robot state dependent quantities have to be recomputed
+     */
+    bool robotModelChanged();
+
+    /**
+     * @brief Return true if the contribution of the given constraint to the QP has to be recomputed, i.e. if its reference, weights, activation or timeout changed,
+     *  a full update is required or, for Cartesian and CoM constraints, if the robot state changed.
+     */
+    bool constraintNeedsUpdate(const ConstraintPtr constraint, bool robot_model_changed) const;
+
+    /**
+     * @brief Reset the change flags of all constraints. To be called at the end of update()
+     */
+    void clearChanges();
+
+    /**
+     * @brief Return true if the constraint does not contribute to the QP, i.e. if its activation is zero or if it is in timeout. Call checkTimeout() on the constraint before.
+     */
+    static bool isInactive(const ConstraintPtr constraint){return constraint->activation == 0 || constraint->timeout;}
+
+    /**
+     * @brief Mark the given inactive constraint as skipped in the current cycle. Sets the reference (if the activation is zero) and the weighted constraint matrix to zero
+     */
+    void skipConstraint(const ConstraintPtr constraint);
+
+    /**
+     * @brief Return the QP that is passed to the solver. If QP compaction is enabled, this is the given QP without the rows of inactive constraints, otherwise the given QP itself
+     */
+    const HierarchicalQP& solverInput(const HierarchicalQP& hqp){return compact_qp ? compactor.compact(hqp) : hqp;}
+
 public:
     WbcScene(RobotModelPtr robot_model, QPSolverPtr solver);
     ~WbcScene();
@@ -81,6 +126,35 @@ public:
      * @param activation Activation value. Has to be in interval [0.0,1.0]
      */
     void setTaskActivation(const std::string& constraint_name, const double activation);
+    /**
+     * @brief Publish reference input for a joint space constraint. In contrast to setReference(), this method can be called from any thread while the
+     *  control thread is running update(). It does not block, the value will be applied with the next call of update(). Only one producer thread per constraint is allowed.
+     * @param constraint_name Name of the constraint
+     * @param ref Joint space reference values
+     */
+    void publishReference(const std::string& constraint_name, const base::samples::Joints& ref);
+
+    /**
+     * @brief Publish reference input for a Cartesian space constraint. See publishReference() for joint space constraints for details.
+     * @param constraint_name Name of the constraint
+     * @param ref Cartesian space reference values
+     */
+    void publishReference(const std::string& constraint_name, const base::samples::RigidBodyStateSE3& ref);
+
+    /**
+     * @brief Publish task weights for a constraint. Can be called from any thread, see publishReference() for details.
+     * @param constraint_name Name of the constraint
+     * @param weights Weight vector. Size has to be same as number of constraint variables
+     */
+    void publishTaskWeights(const std::string& constraint_name, const base::VectorXd &weights);
+
+    /**
+     * @brief Publish task activation for a constraint. Can be called from any thread, see publishReference() for details.
+     * @param constraint_name Name of the constraint
+     * @param activation Activation value. Has to be in interval [0.0,1.0]
+     */
+    void publishTaskActivation(const std::string& constraint_name, const double activation);
+
     /**
      * @brief Return a Particular constraint. Throw if the constraint does not exist
      */
@@ -121,6 +195,12 @@ public:
      */
     const base::commands::Joints& getSolverOutput(){return solver_output_joints;}
 
+    /**
+     * @brief Return the status of the last call to solve(). The scenes solve via QPSolver::trySolve(), so that the recovery strategy of the solver is applied on failure.
+     *  solve() throws only if the solver could neither solve the QP nor recover.
+     */
+    SolverStatus getSolverStatus(){return solver_status;}
+
     /**
      * @brief set Joint weights by given name
      */
@@ -141,12 +221,44 @@ public:
      */
     RobotModelPtr getRobotModel(){return robot_model;}
 
+    /**
+     * @brief Return the cache of kinematic and dynamic quantities that is used by the scene. Quantities requested via the cache are computed only once per robot state,
+     *  e.g. if they are required by several constraints or by both update() and updateConstraintsStatus(). See RobotModelCache for details.
+     */
+    RobotModelCache& getRobotModelCache(){return model_cache;}
+
     /**
      * @brief Return the current solver
      */
     QPSolverPtr getSolver(){return solver;}
 
     std::vector<ConstraintConfig> getWbcConfig(){return wbc_config;}
+
+    /**
+     * @brief Number of constraints that have been skipped in the last call of update(), because they were deactivated or in timeout
+     */
+    uint getNSkippedConstraints() const {return n_skipped_constraints;}
+
+    /**
+     * @brief Enable/disable QP compaction. If enabled, the rows of inactive constraints (zero activation or timeout) are removed from the QP before it is passed
+     *  to the solver, so that the solver effort depends on the number of active constraints only. Disabled by default.
+     */
+    void setCompactQP(bool enable){compact_qp = enable;}
+
+    /**
+     * @brief Return true if QP compaction is enabled
+     */
+    bool getCompactQP() const {return compact_qp;}
+
+    /**
+     * @brief Return the QP compactor, e.g. to map rows of the last compacted QP back to the constraints of the scene
+     */
+    const HierarchicalQPCompactor& getQPCompactor() const {return compactor;}
+
+    /**
+     * @brief Enforce a complete rebuild of the QP on the next call of update()
+     */
+    void requireFullUpdate(){full_update_required = true;}
 };
 
 typedef std::shared_ptr<WbcScene> WbcScenePtr;
@@ -0,0 +1,128 @@
+#include "ThreadPool.hpp"
+
+namespace wbc{
+
+ThreadPool::ThreadPool(uint n_threads) :
+    job(0),
+    generation(0),
+    stop(false),
+    n_busy(0),
+    n_acknowledged(0),
+    n_remaining(0),
+    n_stolen(0){
+
+    if(n_threads == 0)
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    for(uint i = 0; i < n_threads; i++)
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    for(uint i = 0; i < n_threads; i++)
+        threads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    start_cond.notify_all();
+    for(auto& t : threads)
+        t.join();
+}
+
+bool ThreadPool::popTask(uint worker_idx, uint& task){
+    {
+        Worker& own = *workers[worker_idx];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if(!own.tasks.empty()){
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    // Steal from the back of the other queues, starting with the next worker
+    for(uint i = 1; i < workers.size(); i++){
+        Worker& victim = *workers[(worker_idx + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!victim.tasks.empty()){
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            n_stolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(uint worker_idx){
+    unsigned long last_generation = 0;
+    while(true){
+        const std::function<void(uint)>* f;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cond.wait(lock, [&]{return stop || generation != last_generation;});
+            if(stop)
+                return;
+            last_generation = generation;
+            f = job;
+            n_busy++;
+            n_acknowledged++;
+        }
+
+        uint task;
+        while(popTask(worker_idx, task)){
+            try{
+                (*f)(task);
+            }
+            catch(...){
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!error)
+                    error = std::current_exception();
+            }
+            if(--n_remaining == 0){
+                std::lock_guard<std::mutex> lock(mutex);
+                done_cond.notify_all();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            n_busy--;
+        }
+        done_cond.notify_all();
+    }
+}
+
+void ThreadPool::parallelFor(uint n, const std::function<void(uint)>& f){
+
+    if(n == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    job = &f;
+    error = nullptr;
+    n_remaining = n;
+
+    // Distribute the tasks in contiguous blocks among the workers
+    const uint n_workers = workers.size();
+    for(uint w = 0; w < n_workers; w++){
+        const uint begin = (uint)((unsigned long)n * w / n_workers);
+        const uint end = (uint)((unsigned long)n * (w+1) / n_workers);
+        std::lock_guard<std::mutex> worker_lock(workers[w]->mutex);
+        for(uint i = begin; i < end; i++)
+            workers[w]->tasks.push_back(i);
+    }
+    n_acknowledged = 0;
+    generation++;
+    start_cond.notify_all();
+
+    // Wait also for all workers to pick up this generation and to become idle again. Otherwise, a worker that wakes up late could read the job
+    // of this call after it has been reset, or pick up tasks of the next call with the job of this call
+    done_cond.wait(lock, [&]{return n_remaining == 0 && n_busy == 0 && n_acknowledged == n_workers;});
+    job = 0;
+    if(error){
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+}
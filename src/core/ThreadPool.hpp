@@ -0,0 +1,69 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <exception>
+
+namespace wbc{
+
+/**
+ * @brief Fixed size pool of persistent worker threads with work stealing. The tasks of a parallelFor() call are distributed in contiguous blocks
+ *  among the workers. Each worker processes its own block front to back and, once it is done, steals tasks from the back of the other workers' queues.
+ *  Like this, tasks with different run times (e.g. QPs that need a different number of solver iterations) are balanced automatically, while
+ *  tasks that are processed by their original worker keep a contiguous memory access pattern.
+ */
+class ThreadPool{
+protected:
+    struct Worker{
+        std::deque<uint> tasks;
+        std::mutex mutex;
+    };
+    std::vector< std::unique_ptr<Worker> > workers;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable start_cond, done_cond;
+    const std::function<void(uint)>* job;
+    unsigned long generation;
+    bool stop;
+    uint n_busy;                         /** Number of workers that are currently processing tasks*/
+    uint n_acknowledged;                 /** Number of workers that have picked up the job of the current generation*/
+    std::atomic<uint> n_remaining;
+    std::atomic<unsigned long> n_stolen;
+    std::exception_ptr error;
+
+    /** Pop next task from the own queue or steal one from another worker. Return false if there are no tasks left*/
+    bool popTask(uint worker_idx, uint& task);
+    void workerLoop(uint worker_idx);
+
+public:
+    /**
+     * @brief ThreadPool
+     * @param n_threads Number of worker threads. If 0, the number of hardware threads will be used.
+     */
+    ThreadPool(uint n_threads = 0);
+    ~ThreadPool();
+
+    /**
+     * @brief Call f(i) for all i = 0..n-1 on the worker threads and block until all calls returned. If one or more calls throw, the first exception
+     *  is rethrown on the calling thread after all tasks are finished. Must not be called concurrently or recursively from within f.
+     */
+    void parallelFor(uint n, const std::function<void(uint)>& f);
+
+    /** @brief Return number of worker threads*/
+    uint noOfThreads() const {return threads.size();}
+
+    /** @brief Return the total number of tasks that have been executed by another worker than the one they were initially assigned to*/
+    unsigned long noOfStolenTasks() const {return n_stolen;}
+};
+
+}
+
+#endif // THREAD_POOL_HPP
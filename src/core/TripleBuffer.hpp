@@ -0,0 +1,63 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace wbc{
+
+/**
+ * @brief Wait-free single producer / single consumer triple buffer. The producer writes into its private write buffer and publishes it,
+ *  the consumer fetches the latest published buffer. Neither side ever blocks: The producer may publish at any rate, intermediate values that have
+ *  not been fetched are overwritten. Three instances of T are kept, so that producer and consumer never access the same instance at the same time.
+ *
+ *  Usage (producer): buffer.writeBuffer() = value; buffer.publish();
+ *  Usage (consumer): if(buffer.fetch()) use(buffer.readBuffer());
+ *
+ *  Note: T should be preallocated via init(), e.g. for dynamic size Eigen vectors, so that writing into the buffer does not allocate memory.
+ */
+template<typename T> class TripleBuffer{
+protected:
+    static const uint8_t index_mask = 3;
+    static const uint8_t new_data_flag = 4;
+
+    T buffers[3];
+    std::atomic<uint8_t> middle; /** Index of the buffer that is exchanged between producer and consumer and new data flag*/
+    uint8_t back;                /** Index of the producer's buffer*/
+    uint8_t front;               /** Index of the consumer's buffer*/
+
+public:
+    TripleBuffer() : middle(1), back(0), front(2){}
+
+    /** @brief Initialize all buffers with the given value and discard published data. Not thread safe, call only if no producer or consumer is active*/
+    void init(const T& value){
+        for(int i = 0; i < 3; i++)
+            buffers[i] = value;
+        middle.store(1);
+        back = 0;
+        front = 2;
+    }
+
+    /** @brief Producer: Return the buffer to write into. Only valid until the next call of publish()*/
+    T& writeBuffer(){return buffers[back];}
+
+    /** @brief Producer: Make the content of the write buffer available to the consumer*/
+    void publish(){
+        back = middle.exchange(back | new_data_flag, std::memory_order_acq_rel) & index_mask;
+    }
+
+    /** @brief Consumer: Make the latest published data available in readBuffer(). Return false if nothing has been published since the last call*/
+    bool fetch(){
+        if(!(middle.load(std::memory_order_acquire) & new_data_flag))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+        return true;
+    }
+
+    /** @brief Consumer: Return the data of the last successful call to fetch()*/
+    const T& readBuffer() const {return buffers[front];}
+};
+
+}
+
+#endif // TRIPLE_BUFFER_HPP
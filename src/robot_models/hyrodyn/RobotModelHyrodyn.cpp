@@ -2,12 +2,25 @@
 #include <base-logging/Logging.hpp>
 #include <urdf_parser/urdf_parser.h>
 #include <tools/URDFTools.hpp>
+#include "../../core/Profiler.hpp"
 
 namespace wbc{
 
+namespace{
+base::Matrix3d skewSymmetric(const base::Vector3d& v){
+    base::Matrix3d m;
+    m <<     0, -v(2),  v(1),
+          v(2),     0, -v(0),
+         -v(1),  v(0),     0;
+    return m;
+}
+}
+
 RobotModelRegistry<RobotModelHyrodyn> RobotModelHyrodyn::reg("hyrodyn");
 
-RobotModelHyrodyn::RobotModelHyrodyn(){
+RobotModelHyrodyn::RobotModelHyrodyn() :
+    com_is_up_to_date(false),
+    total_mass(0){
 }
 
 RobotModelHyrodyn::~RobotModelHyrodyn(){
@@ -23,6 +36,10 @@ void RobotModelHyrodyn::clear(){
     joint_names_floating_base.clear();
     joint_names.clear();
     hyrodyn = hyrodyn::RobotModel_HyRoDyn();
+    com_is_up_to_date = false;
+    link_inertias.clear();
+    total_mass = 0;
+    joint_state_idx.clear();
 }
 
 bool RobotModelHyrodyn::configure(const RobotModelConfig& cfg){
@@ -117,7 +134,42 @@ bool RobotModelHyrodyn::configure(const RobotModelConfig& cfg){
 
     jacobian.resize(6,noOfJoints());
     jacobian.setConstant(std::numeric_limits<double>::quiet_NaN());
+    com_jacobian.resize(3,noOfJoints());
+    link_com_jacobian.resize(3,noOfJoints());
+    centroidal_momentum_matrix.resize(6,noOfJoints());
     base_frame =  robot_urdf->getRoot()->name;
+
+    // Inertial properties of all links for the CoM computations, including the root link
+    for(const auto& l : robot_urdf->links_){
+        const urdf::LinkSharedPtr& link = l.second;
+        if(!link->inertial || link->inertial->mass <= 0)
+            continue;
+        const urdf::Inertial& inertial = *link->inertial;
+        LinkInertia link_inertia;
+        link_inertia.name = link->name;
+        link_inertia.is_root = link->name == base_frame;
+        link_inertia.mass = inertial.mass;
+        link_inertia.cog = base::Vector3d(inertial.origin.position.x, inertial.origin.position.y, inertial.origin.position.z);
+        double x, y, z, w;
+        inertial.origin.rotation.getQuaternion(x, y, z, w);
+        const base::Matrix3d inertia_rot = base::Quaterniond(w, x, y, z).toRotationMatrix();
+        base::Matrix3d inertia;
+        inertia << inertial.ixx, inertial.ixy, inertial.ixz,
+                   inertial.ixy, inertial.iyy, inertial.iyz,
+                   inertial.ixz, inertial.iyz, inertial.izz;
+        link_inertia.inertia = inertia_rot * inertia * inertia_rot.transpose();
+        link_inertias.push_back(link_inertia);
+        total_mass += inertial.mass;
+    }
+    joint_state_idx.clear();
+    for(const auto& n : joint_names){
+        uint idx = std::find(joint_state.names.begin(), joint_state.names.end(), n) - joint_state.names.begin();
+        if(idx >= joint_state.names.size()){
+            LOG_ERROR("RobotModelHyrodyn: Joint %s is not part of the spanning tree of the hyrodyn model", n.c_str());
+            return false;
+        }
+        joint_state_idx.push_back(idx);
+    }
     active_contacts = cfg.contact_points;
     joint_space_inertia_mat.resize(noOfJoints(), noOfJoints());
     bias_forces.resize(noOfJoints());
@@ -151,12 +203,42 @@ bool RobotModelHyrodyn::configure(const RobotModelConfig& cfg){
                          << "  Max. Eff: " << joint_limits[n].max.effort   << std::endl;
     LOG_DEBUG("------------------------------------------------------------");
 
+    state_revision++;
+
+    return true;
+}
+
+bool RobotModelHyrodyn::reconfigure(const RobotModelConfig& cfg){
+
+    // Structural changes, e.g. a different URDF/submechanism file or blacklisted joints, require reloading the hyrodyn model
+    if(!robot_urdf || hasStructuralChanges(cfg))
+        return configure(cfg);
+
+    if(cfg.actuated_joint_names != robot_model_config.actuated_joint_names)
+        LOG_WARN("Configured actuated joint names will be ignored! The Hyrodyn based model will get the actuated joint names from submechanism file");
+
+    for(auto c : cfg.contact_points.names){
+        if(!hasLink(c)){
+            LOG_ERROR("Contact point %s is not a valid link in the robot model", c.c_str());
+            return false;
+        }
+    }
+    active_contacts = cfg.contact_points;
+
+    // Keep the current floating base state, the one in cfg is only the initial state
+    base::RigidBodyStateSE3 initial_floating_base_state = robot_model_config.floating_base_state;
+    robot_model_config = cfg;
+    robot_model_config.floating_base_state = initial_floating_base_state;
+    state_revision++;
+
     return true;
 }
 
 void RobotModelHyrodyn::update(const base::samples::Joints& joint_state_in,
                                const base::samples::RigidBodyStateSE3& _floating_base_state){
 
+    WBC_PROFILE_SCOPE("RobotModelHyrodyn::update");
+
     if(joint_state_in.elements.size() != joint_state_in.names.size()){
         LOG_ERROR_S << "Size of names and size of elements in joint state do not match"<<std::endl;
         throw std::runtime_error("Invalid joint state");
@@ -204,6 +286,8 @@ void RobotModelHyrodyn::update(const base::samples::Joints& joint_state_in,
         //joint_state[name].effort = hyrodyn.Tau_spanningtree[i]; // It seems Tau_spanningtree is currently not being computed by hyrodyn
     }
     joint_state.time = joint_state_in.time;
+    com_is_up_to_date = false;
+    state_revision++;
 }
 
 const base::samples::Joints& RobotModelHyrodyn::jointState(const std::vector<std::string> &joint_names){
@@ -416,6 +500,100 @@ const base::samples::RigidBodyStateSE3& RobotModelHyrodyn::centerOfMass(){
     return com_rbs;
 }
 
+void RobotModelHyrodyn::updateCenterOfMass(){
+
+    WBC_PROFILE_SCOPE("RobotModelHyrodyn::updateCenterOfMass");
+
+    if(total_mass <= 0){
+        LOG_ERROR("RobotModelHyrodyn: Total mass of the robot model is %f. Cannot compute center of mass", total_mass);
+        throw std::runtime_error("Invalid robot model mass");
+    }
+
+    // The hyrodyn model does not provide the CoM Jacobian, so sum up the mass weighted Jacobians of all link CoMs. The angular momentum
+    // is first computed about the base frame origin and shifted to the overall CoM afterwards
+    base::Vector3d com_moment = base::Vector3d::Zero();
+    com_jacobian.setZero();
+    centroidal_momentum_matrix.setZero();
+    const uint nj = noOfJoints();
+    for(const LinkInertia& link : link_inertias){
+
+        // The root link is the base frame, so its CoM is fixed and it does not contribute to the Jacobians. In case of a floating base, the root
+        // is the world frame and the floating base link is a regular link, whose Jacobian includes the floating base joints
+        if(link.is_root){
+            com_moment += link.mass * link.cog;
+            continue;
+        }
+
+        hyrodyn.calculate_forward_kinematics(link.name);
+        const base::Matrix3d link_rot = base::Quaterniond(hyrodyn.pose[6],hyrodyn.pose[3],hyrodyn.pose[4],hyrodyn.pose[5]).toRotationMatrix();
+        const base::Vector3d cog_offset = link_rot * link.cog;
+        const base::Vector3d cog = hyrodyn.pose.segment(0,3) + cog_offset;
+
+        // Reference point of the space Jacobian is the link origin: v_cog = v_link - cog_offset x w. Hyrodyn Jacobians are ordered (angular,linear)
+        if(hyrodyn.floating_base_robot){
+            hyrodyn.calculate_space_jacobian_actuation_space_including_floatingbase(link.name);
+            link_com_jacobian.noalias() = hyrodyn.Jsufb.block(3,0,3,nj);
+            link_com_jacobian.noalias() -= skewSymmetric(cog_offset) * hyrodyn.Jsufb.block(0,0,3,nj);
+            centroidal_momentum_matrix.bottomRows(3).noalias() += (link_rot * link.inertia * link_rot.transpose()) * hyrodyn.Jsufb.block(0,0,3,nj);
+        }
+        else{
+            hyrodyn.calculate_space_jacobian_actuation_space(link.name);
+            link_com_jacobian.noalias() = hyrodyn.Jsu.block(3,0,3,nj);
+            link_com_jacobian.noalias() -= skewSymmetric(cog_offset) * hyrodyn.Jsu.block(0,0,3,nj);
+            centroidal_momentum_matrix.bottomRows(3).noalias() += (link_rot * link.inertia * link_rot.transpose()) * hyrodyn.Jsu.block(0,0,3,nj);
+        }
+
+        com_jacobian += link.mass * link_com_jacobian;
+        centroidal_momentum_matrix.bottomRows(3).noalias() += (link.mass * skewSymmetric(cog)) * link_com_jacobian;
+        com_moment += link.mass * cog;
+    }
+
+    centroidal_momentum_matrix.topRows(3) = com_jacobian;
+    centroidal_momentum_matrix.bottomRows(3).noalias() -= skewSymmetric(com_moment / total_mass) * com_jacobian;
+    com_jacobian /= total_mass;
+
+    // Jcom_dot*qdot = com_acc - Jcom*qdotdot
+    hyrodyn.calculate_com_properties();
+    com_acc_bias = hyrodyn.com_acc;
+    for(uint i = 0; i < nj; i++)
+        com_acc_bias -= com_jacobian.col(i) * joint_state[joint_state_idx[i]].acceleration;
+
+    com_is_up_to_date = true;
+}
+
+const base::MatrixXd& RobotModelHyrodyn::comJacobian(){
+    if(joint_state.time.isNull()){
+        LOG_ERROR("RobotModelHyrodyn: You have to call update() with appropriately timestamped joint data at least once before requesting kinematic information!");
+        throw std::runtime_error(" Invalid call to comJacobian()");
+    }
+
+    if(!com_is_up_to_date)
+        updateCenterOfMass();
+    return com_jacobian;
+}
+
+const base::Vector3d& RobotModelHyrodyn::comAccelerationBias(){
+    if(joint_state.time.isNull()){
+        LOG_ERROR("RobotModelHyrodyn: You have to call update() with appropriately timestamped joint data at least once before requesting kinematic information!");
+        throw std::runtime_error(" Invalid call to comAccelerationBias()");
+    }
+
+    if(!com_is_up_to_date)
+        updateCenterOfMass();
+    return com_acc_bias;
+}
+
+const base::MatrixXd& RobotModelHyrodyn::centroidalMomentumMatrix(){
+    if(joint_state.time.isNull()){
+        LOG_ERROR("RobotModelHyrodyn: You have to call update() with appropriately timestamped joint data at least once before requesting kinematic information!");
+        throw std::runtime_error(" Invalid call to centroidalMomentumMatrix()");
+    }
+
+    if(!com_is_up_to_date)
+        updateCenterOfMass();
+    return centroidal_momentum_matrix;
+}
+
 void RobotModelHyrodyn::computeInverseDynamics(base::commands::Joints &solver_output){
     if(joint_state.time.isNull()){
         LOG_ERROR("RobotModelKDL: You have to call update() with appropriately timestamped joint data at least once before requesting kinematic information!");
@@ -31,9 +31,31 @@ protected:
     urdf::ModelInterfaceSharedPtr robot_urdf;
     base::samples::RigidBodyStateSE3 com_rbs;
     base::MatrixXd jacobian;
+    base::MatrixXd com_jacobian;
+    base::Vector3d com_acc_bias;
+    base::MatrixXd centroidal_momentum_matrix;
     hyrodyn::RobotModel_HyRoDyn hyrodyn;
 
+    bool com_is_up_to_date;
+
+    /** Inertial properties of a link with non-zero mass, extracted from the URDF once in configure()*/
+    struct LinkInertia{
+        std::string name;           /** Link name*/
+        bool is_root;               /** True for the root link of the model, which does not move with respect to the base frame*/
+        double mass;                /** Link mass*/
+        base::Vector3d cog;         /** Center of gravity in link coordinates*/
+        base::Matrix3d inertia;     /** Rotational inertia about the center of gravity in link coordinates*/
+    };
+    std::vector<LinkInertia> link_inertias;
+    double total_mass;
+    base::MatrixXd link_com_jacobian;
+    std::vector<uint> joint_state_idx;  /** Index of each entry of jointNames() in the spanning tree joint state*/
+
     void clear();
+
+    /** Compute CoM Jacobian, CoM acceleration bias and centroidal momentum matrix by summing up the contributions of all links. Uses the hyrodyn
+     *  model directly and preallocated buffers, so that no string lookups or allocations are required*/
+    void updateCenterOfMass();
 public:
     RobotModelHyrodyn();
     virtual ~RobotModelHyrodyn();
@@ -50,6 +72,14 @@ public:
      */
     virtual bool configure(const RobotModelConfig& cfg);
 
+    /**
+     * @brief Change the configuration of an already configured model. If only the contact points differ from the current configuration, the hyrodyn model
+     *  will not be reloaded. Any other change (e.g. URDF/submechanism file, joint blacklist or floating base) requires a full configure().
+     * @param cfg New model configuration. See RobotModelConfig.hpp for details
+     * @return True in case of success, else false
+     */
+    virtual bool reconfigure(const RobotModelConfig& cfg);
+
     /**
      * @brief Update the robot model. The joint state has to contain all joints that are relevant in the model. This means: All joints that are ever required
      *  when requesting rigid body states, Jacobians or joint states. Note that
@@ -142,6 +172,17 @@ public:
     /** @brief Return Current center of gravity in expressed base frame*/
     virtual const base::samples::RigidBodyStateSE3& centerOfMass();
 
+    /** @brief Compute and return the CoM Jacobian, which is 3 x nj, where nj is the number of joints of the system. Reference frame is the base frame of the robot.
+      * The order of the columns will be the same as the configured joint order of the robot*/
+    virtual const base::MatrixXd& comJacobian();
+
+    /** @brief Compute and return the CoM acceleration bias, i.e. the term Jcom_dot*qdot, expressed in base frame*/
+    virtual const base::Vector3d& comAccelerationBias();
+
+    /** @brief Compute and return the centroidal momentum matrix A_G, which is 6 x nj, where nj is the number of joints of the system. A_G maps the joint velocities to
+      * the spatial momentum of the robot about its CoM, expressed in base frame. First three rows correspond to linear, last three rows to angular momentum*/
+    virtual const base::MatrixXd& centroidalMomentumMatrix();
+
     /** @brief Return pointer to the internal hyrodyn model*/
     hyrodyn::RobotModel_HyRoDyn *hyrodynHandle(){return &hyrodyn;}
 
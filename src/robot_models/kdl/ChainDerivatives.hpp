@@ -0,0 +1,71 @@
+#ifndef CHAIN_DERIVATIVES_HPP
+#define CHAIN_DERIVATIVES_HPP
+
+#include "FixedSizeChain.hpp"
+#include <unsupported/Eigen/AutoDiff>
+
+namespace wbc{
+
+/**
+ * @brief Analytic partial derivatives of the inverse dynamics of a FixedSizeChain, i.e. dtau/dq and dtau/dqd. The derivatives are computed with forward mode
+ *  automatic differentiation: The chain is instantiated with an Eigen::AutoDiffScalar that carries the derivatives wrt. all joint positions and velocities, so
+ *  that a single pass of the recursive Newton-Euler algorithm yields both derivative matrices. This replaces finite differencing, which would require 2*NJ
+ *  additional model evaluations.
+ */
+template<int NJ> class ChainDerivatives{
+public:
+    typedef Eigen::Matrix<double,NJ,1> JointVector;
+    typedef Eigen::Matrix<double,NJ,NJ> JointMatrix;
+    typedef Eigen::AutoDiffScalar< Eigen::Matrix<double,2*NJ,1> > ADScalar;
+    typedef FixedSizeChain<NJ,ADScalar> ADChain;
+
+protected:
+    ADChain ad_chain;
+    typename ADChain::JointVector q_ad, qd_ad, qdd_ad;
+    JointVector tau;
+    JointMatrix dtau_dq, dtau_dqd;
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    ChainDerivatives(const FixedSizeChain<NJ>& chain) : ad_chain(chain){
+        tau.setZero();
+        dtau_dq.setZero();
+        dtau_dqd.setZero();
+    }
+
+    /**
+     * @brief Compute inverse dynamics and its partial derivatives wrt. joint positions and velocities
+     * @param q Joint positions, in the order of the joints in the chain
+     * @param qd Joint velocities
+     * @param qdd Joint accelerations
+     */
+    void update(const JointVector& q, const JointVector& qd, const JointVector& qdd){
+        for(int i = 0; i < NJ; i++){
+            q_ad(i) = ADScalar(q(i), 2*NJ, i);
+            qd_ad(i) = ADScalar(qd(i), 2*NJ, NJ+i);
+            qdd_ad(i) = ADScalar(qdd(i), Eigen::Matrix<double,2*NJ,1>::Zero());
+        }
+        ad_chain.update(q_ad, qd_ad, qdd_ad);
+        const typename ADChain::JointVector& tau_ad = ad_chain.inverseDynamics();
+        for(int i = 0; i < NJ; i++){
+            tau(i) = tau_ad(i).value();
+            dtau_dq.row(i) = tau_ad(i).derivatives().template segment<NJ>(0).transpose();
+            dtau_dqd.row(i) = tau_ad(i).derivatives().template segment<NJ>(NJ).transpose();
+        }
+    }
+
+    /** Set gravity vector in root coordinates of the chain*/
+    void setGravity(const Eigen::Vector3d& g){ad_chain.setGravity(g);}
+
+    /** Joint torques/forces of the last update() call*/
+    const JointVector& inverseDynamics() const {return tau;}
+    /** Partial derivative of the joint torques wrt. the joint positions, NJ x NJ*/
+    const JointMatrix& inverseDynamicsDerivativeQ() const {return dtau_dq;}
+    /** Partial derivative of the joint torques wrt. the joint velocities, NJ x NJ*/
+    const JointMatrix& inverseDynamicsDerivativeQd() const {return dtau_dqd;}
+};
+
+}
+
+#endif // CHAIN_DERIVATIVES_HPP
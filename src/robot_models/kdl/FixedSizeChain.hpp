@@ -0,0 +1,335 @@
+#ifndef FIXED_SIZE_CHAIN_HPP
+#define FIXED_SIZE_CHAIN_HPP
+
+#include <kdl/chain.hpp>
+#include <Eigen/Geometry>
+#include <stdexcept>
+
+namespace wbc{
+
+/**
+ * @brief Kinematic chain with a number of joints NJ that is known at compile time. All quantities are fixed-size Eigen types,
+ *  so that kinematics and dynamics can be computed without any heap allocation and the recursion over the joints can be completely unrolled by the compiler.
+ *  The chain is built once from a KDL::Chain. Fixed segments are folded into the constant transforms and inertias of the neighbouring joints.
+ *  Conventions are the same as in KinematicChainKDL: Poses are given in root coordinates, Jacobian, twist and acceleration are
+ *  expressed in root coordinates with reference point tip (hybrid representation).
+ *
+ *  All joint dependent computations are templated on the scalar type, so that the chain can be instantiated with e.g. automatic differentiation
+ *  scalars (see ChainDerivatives.hpp). The constant model parameters are always stored as double.
+ */
+template<int NJ, typename Scalar = double> class FixedSizeChain{
+    template<int, typename> friend class FixedSizeChain;
+
+public:
+    typedef Eigen::Matrix<Scalar,NJ,1> JointVector;
+    typedef Eigen::Matrix<Scalar,6,NJ> Jacobian;
+    typedef Eigen::Matrix<Scalar,6,1> SpatialVector;
+    typedef Eigen::Matrix<Scalar,3,1> Vector3;
+    typedef Eigen::Matrix<Scalar,3,3> Matrix3;
+    typedef Eigen::Transform<Scalar,3,Eigen::Isometry> Pose;
+
+protected:
+    /** Constant description of a single joint. The pose of the joint segment is Screw(q) * post, where Screw(q) is a rotation about (resp. translation along)
+     *  the axis through point, both expressed in the frame of the previous joint segment. The inertia of the body moved by the joint (including all rigidly attached
+     *  fixed segments) is given by mass, center of mass and rotational inertia about the origin, all expressed in the tip frame of the joint segment*/
+    struct JointData{
+        Eigen::Vector3d axis;
+        Eigen::Vector3d point;
+        Eigen::Isometry3d post;
+        bool prismatic;
+        double mass;
+        Eigen::Vector3d com;
+        Eigen::Matrix3d inertia;
+    };
+
+    JointData joints[NJ];
+    Eigen::Isometry3d tip_offset;           /** Fixed transform from the last joint segment to the tip of the chain*/
+    std::vector<std::string> joint_names;
+    Eigen::Vector3d gravity;
+
+    Pose pose_tip;
+    Pose body_pose[NJ];                     /** Pose of each body (tip frame of the joint segment) in root coordinates*/
+    Vector3 axis_world[NJ];                 /** Joint axes in root coordinates*/
+    Vector3 point_world[NJ];                /** Points on the joint axes in root coordinates*/
+    JointVector qd_cur, qdd_cur;
+    Jacobian jac, jac_dot;
+    Jacobian jac_derivatives[NJ];
+    SpatialVector twist_tip, acc_tip;
+    JointVector tau;
+
+    static Eigen::Isometry3d toIsometry(const KDL::Frame& f){
+        Eigen::Isometry3d iso = Eigen::Isometry3d::Identity();
+        for(int i = 0; i < 3; i++){
+            iso.translation()(i) = f.p(i);
+            for(int j = 0; j < 3; j++)
+                iso.linear()(i,j) = f.M(i,j);
+        }
+        return iso;
+    }
+
+    static Eigen::Vector3d toVector(const KDL::Vector& v){
+        return Eigen::Vector3d(v(0), v(1), v(2));
+    }
+
+    static bool isPrismatic(const KDL::Joint& jnt){
+        return jnt.getType() == KDL::Joint::TransAxis || jnt.getType() == KDL::Joint::TransX ||
+               jnt.getType() == KDL::Joint::TransY || jnt.getType() == KDL::Joint::TransZ;
+    }
+
+    /** Derivative of the Jacobian wrt. the motion of the links, given the twist of each link (reference point tip). Used for both the time derivative and the partial derivatives*/
+    template<typename LinkTwists>
+    void jacobianChange(const LinkTwists& link_twist, const Vector3& tip_vel, Jacobian& d_jac) const{
+        const Vector3 p_tip = pose_tip.translation();
+        for(int k = 0; k < NJ; k++){
+            const Vector3 omega = link_twist[k].template segment<3>(3);
+            const Vector3 axis_dot = omega.cross(axis_world[k]);
+            if(joints[k].prismatic){
+                d_jac.template block<3,1>(0,k) = axis_dot;
+                d_jac.template block<3,1>(3,k).setZero();
+            }
+            else{
+                const Vector3 point_vel = link_twist[k].template segment<3>(0) + omega.cross(point_world[k] - p_tip);
+                d_jac.template block<3,1>(0,k) = axis_dot.cross(p_tip - point_world[k]) + axis_world[k].cross(tip_vel - point_vel);
+                d_jac.template block<3,1>(3,k) = axis_dot;
+            }
+        }
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    /**
+     * @brief Build the fixed size chain. Throws if the number of (non-fixed) joints in the chain is not NJ
+     * @param chain The KDL chain
+     * @param gravity Gravity vector in root coordinates of the chain, only used for the inverse dynamics
+     */
+    FixedSizeChain(const KDL::Chain& chain, const Eigen::Vector3d& gravity = Eigen::Vector3d(0,0,-9.81)) : gravity(gravity){
+        if(chain.getNrOfJoints() != NJ)
+            throw std::invalid_argument("FixedSizeChain: Chain has " + std::to_string(chain.getNrOfJoints()) +
+                                        " joints, but fixed size is " + std::to_string(NJ));
+
+        KDL::Frame fixed = KDL::Frame::Identity();
+        KDL::RigidBodyInertia body_inertia = KDL::RigidBodyInertia::Zero();
+        int k = -1;
+        for(unsigned int i = 0; i < chain.getNrOfSegments(); i++){
+            const KDL::Segment& segment = chain.getSegment(i);
+            const KDL::Joint& jnt = segment.getJoint();
+            if(jnt.getType() == KDL::Joint::None){
+                fixed = fixed * segment.pose(0.0);
+                // Segments before the first joint do not move and do not contribute to the joint torques
+                if(k >= 0)
+                    body_inertia = body_inertia + fixed * segment.getInertia();
+                continue;
+            }
+            if(k >= 0)
+                setInertia(k, body_inertia);
+            k++;
+            // Move the preceding fixed transforms in front of the joint motion: fixed * Screw(axis, point) = Screw(R_fixed*axis, fixed*point) * fixed
+            const Eigen::Isometry3d fixed_iso = toIsometry(fixed);
+            joints[k].axis = fixed_iso.linear() * toVector(jnt.JointAxis());
+            joints[k].point = fixed_iso * toVector(jnt.JointOrigin());
+            joints[k].post = fixed_iso * toIsometry(segment.pose(0.0));
+            joints[k].prismatic = isPrismatic(jnt);
+            joint_names.push_back(jnt.getName());
+            fixed = KDL::Frame::Identity();
+            body_inertia = segment.getInertia();
+        }
+        setInertia(k, body_inertia);
+        tip_offset = toIsometry(fixed);
+        reset();
+    }
+
+    /**
+     * @brief Create a chain with the same model parameters but a different scalar type, e.g. for automatic differentiation
+     */
+    template<typename OtherScalar>
+    explicit FixedSizeChain(const FixedSizeChain<NJ,OtherScalar>& other) :
+        tip_offset(other.tip_offset),
+        joint_names(other.joint_names),
+        gravity(other.gravity){
+        for(int k = 0; k < NJ; k++){
+            joints[k].axis = other.joints[k].axis;
+            joints[k].point = other.joints[k].point;
+            joints[k].post = other.joints[k].post;
+            joints[k].prismatic = other.joints[k].prismatic;
+            joints[k].mass = other.joints[k].mass;
+            joints[k].com = other.joints[k].com;
+            joints[k].inertia = other.joints[k].inertia;
+        }
+        reset();
+    }
+
+    /** Set all joint dependent quantities to zero*/
+    void reset(){
+        pose_tip.setIdentity();
+        for(int k = 0; k < NJ; k++){
+            body_pose[k].setIdentity();
+            axis_world[k].setZero();
+            point_world[k].setZero();
+            jac_derivatives[k].setZero();
+        }
+        qd_cur.setZero();
+        qdd_cur.setZero();
+        jac.setZero();
+        jac_dot.setZero();
+        twist_tip.setZero();
+        acc_tip.setZero();
+        tau.setZero();
+    }
+
+    /** Set the inertia of the k-th body*/
+    void setInertia(int k, const KDL::RigidBodyInertia& inertia){
+        joints[k].mass = inertia.getMass();
+        joints[k].com = toVector(inertia.getCOG());
+        joints[k].inertia = Eigen::Map<const Eigen::Matrix3d>(inertia.getRotationalInertia().data);
+    }
+
+    /** Set gravity vector in root coordinates of the chain*/
+    void setGravity(const Eigen::Vector3d& g){gravity = g;}
+
+    /**
+     * @brief Compute pose, Jacobian, Jacobian derivative, twist and spatial acceleration of the tip in a single pass over the joints
+     * @param q Joint positions, in the order of jointNames()
+     * @param qd Joint velocities
+     * @param qdd Joint accelerations
+     */
+    void update(const JointVector& q, const JointVector& qd, const JointVector& qdd){
+
+        Pose pose = Pose::Identity();
+        for(int k = 0; k < NJ; k++){
+            const JointData& jnt = joints[k];
+            const Vector3 axis = jnt.axis.template cast<Scalar>();
+            const Vector3 point = jnt.point.template cast<Scalar>();
+            axis_world[k] = pose.linear() * axis;
+            point_world[k] = pose * point;
+            Pose screw = Pose::Identity();
+            if(jnt.prismatic)
+                screw.translation() = axis * q(k);
+            else{
+                screw.linear() = Eigen::AngleAxis<Scalar>(q(k), axis).toRotationMatrix();
+                screw.translation() = point - screw.linear() * point;
+            }
+            pose = pose * screw * jnt.post.template cast<Scalar>();
+            body_pose[k] = pose;
+        }
+        pose_tip = pose * tip_offset.template cast<Scalar>();
+        const Vector3 p_tip = pose_tip.translation();
+
+        for(int k = 0; k < NJ; k++){
+            if(joints[k].prismatic){
+                jac.template block<3,1>(0,k) = axis_world[k];
+                jac.template block<3,1>(3,k).setZero();
+            }
+            else{
+                jac.template block<3,1>(0,k) = axis_world[k].cross(p_tip - point_world[k]);
+                jac.template block<3,1>(3,k) = axis_world[k];
+            }
+        }
+        qd_cur = qd;
+        qdd_cur = qdd;
+        twist_tip = jac * qd;
+
+        // Jacobian derivative: Each joint axis moves with the velocity of the link it is attached to. Twist of that link (reference point tip)
+        // is the sum of all previous Jacobian columns times joint velocity
+        SpatialVector link_twist[NJ];
+        link_twist[0].setZero();
+        for(int k = 1; k < NJ; k++)
+            link_twist[k] = link_twist[k-1] + jac.col(k-1) * qd(k-1);
+        jacobianChange(link_twist, twist_tip.template segment<3>(0), jac_dot);
+        acc_tip = jac_dot * qd + jac * qdd;
+    }
+
+    /**
+     * @brief Compute the partial derivatives of the Jacobian wrt. the joint positions in closed form, using the current joint positions. Has to be called after update().
+     *  The i-th derivative is obtained from the Jacobian derivative formula with a unit velocity of joint i.
+     */
+    void calculateJacobianDerivatives(){
+        SpatialVector link_twist[NJ];
+        for(int i = 0; i < NJ; i++){
+            for(int k = 0; k < NJ; k++)
+                link_twist[k] = k > i ? SpatialVector(jac.col(i)) : SpatialVector(SpatialVector::Zero());
+            jacobianChange(link_twist, jac.col(i).template segment<3>(0), jac_derivatives[i]);
+        }
+    }
+
+    /**
+     * @brief Recursive Newton-Euler algorithm using the joint state of the last update() call. All quantities are computed in root coordinates
+     * @return Joint torques/forces required to achieve the given joint accelerations, including gravity, Coriolis and centrifugal terms
+     */
+    const JointVector& inverseDynamics(){
+
+        // Spatial vectors in root coordinates with reference point root origin, angular part first
+        SpatialVector v = SpatialVector::Zero(), a = SpatialVector::Zero();
+        a.template segment<3>(3) = -gravity.template cast<Scalar>();
+        SpatialVector f[NJ];
+        for(int k = 0; k < NJ; k++){
+            SpatialVector s;
+            if(joints[k].prismatic)
+                s << Vector3::Zero(), axis_world[k];
+            else
+                s << axis_world[k], point_world[k].cross(axis_world[k]);
+
+            const Vector3 w = v.template segment<3>(0), lin = v.template segment<3>(3);
+            const Vector3 sw = s.template segment<3>(0), slin = s.template segment<3>(3);
+            SpatialVector v_cross_s;
+            v_cross_s << w.cross(sw), w.cross(slin) + lin.cross(sw);
+            v += s * qd_cur(k);
+            a += s * qdd_cur(k) + v_cross_s * qd_cur(k);
+
+            // Spatial inertia of the body in root coordinates about the root origin
+            const Scalar m = Scalar(joints[k].mass);
+            const Matrix3 R = body_pose[k].linear();
+            const Vector3 c = body_pose[k] * joints[k].com.template cast<Scalar>();
+            const Vector3 c_body = R * joints[k].com.template cast<Scalar>();
+            // Rotational inertia about the body origin -> about the CoM -> about the root origin
+            Matrix3 I_c = R * joints[k].inertia.template cast<Scalar>() * R.transpose();
+            I_c += m * (skew(c_body) * skew(c_body));
+            const Matrix3 I_o = I_c - m * (skew(c) * skew(c));
+
+            const Vector3 vw = v.template segment<3>(0), vl = v.template segment<3>(3);
+            const Vector3 aw = a.template segment<3>(0), al = a.template segment<3>(3);
+            // h = I*v, f = I*a + v x* (I*v)
+            const Vector3 h_ang = I_o * vw + m * c.cross(vl);
+            const Vector3 h_lin = m * vl - m * c.cross(vw);
+            f[k] << I_o * aw + m * c.cross(al) + vw.cross(h_ang) + vl.cross(h_lin),
+                    m * al - m * c.cross(aw) + vw.cross(h_lin);
+        }
+        for(int k = NJ-1; k >= 0; k--){
+            if(joints[k].prismatic)
+                tau(k) = axis_world[k].dot(f[k].template segment<3>(3));
+            else
+                tau(k) = axis_world[k].dot(f[k].template segment<3>(0)) + point_world[k].cross(axis_world[k]).dot(f[k].template segment<3>(3));
+            if(k > 0)
+                f[k-1] += f[k];
+        }
+        return tau;
+    }
+
+    /** Skew symmetric matrix, such that skew(a)*b = a x b*/
+    static Matrix3 skew(const Vector3& v){
+        Matrix3 s;
+        s << Scalar(0), -v(2), v(1),
+             v(2), Scalar(0), -v(0),
+             -v(1), v(0), Scalar(0);
+        return s;
+    }
+
+    /** Pose of the tip in root coordinates*/
+    const Pose& pose() const {return pose_tip;}
+    /** Space Jacobian (hybrid representation), 6 x NJ, linear part first*/
+    const Jacobian& jacobian() const {return jac;}
+    /** Derivative of the space Jacobian (hybrid representation), 6 x NJ, linear part first*/
+    const Jacobian& jacobianDot() const {return jac_dot;}
+    /** Partial derivative of the space Jacobian wrt. the i-th joint position. Requires a previous call to calculateJacobianDerivatives()*/
+    const Jacobian& jacobianDerivative(int i) const {return jac_derivatives[i];}
+    /** Twist of the tip, linear part first*/
+    const SpatialVector& twist() const {return twist_tip;}
+    /** Spatial acceleration of the tip, linear part first*/
+    const SpatialVector& acceleration() const {return acc_tip;}
+    /** Names of the joints in the chain, in the order of the joint vectors*/
+    const std::vector<std::string>& jointNames() const {return joint_names;}
+};
+
+}
+
+#endif // FIXED_SIZE_CHAIN_HPP
@@ -3,6 +3,7 @@
 #include <kdl_parser/kdl_parser.hpp>
 #include <base-logging/Logging.hpp>
 #include "../../core/RobotModelConfig.hpp"
+#include "../../core/Profiler.hpp"
 #include <kdl/treeidsolver_recursive_newton_euler.hpp>
 #include <kdl/treejnttojacsolver.hpp>
 #include <algorithm>
@@ -12,9 +13,24 @@
 
 namespace wbc{
 
+namespace{
+bool isPrismatic(const KDL::Joint& jnt){
+    switch(jnt.getType()){
+    case KDL::Joint::TransAxis:
+    case KDL::Joint::TransX:
+    case KDL::Joint::TransY:
+    case KDL::Joint::TransZ:
+        return true;
+    default:
+        return false;
+    }
+}
+}
+
 RobotModelRegistry<RobotModelKDL> RobotModelKDL::reg("kdl");
 
-RobotModelKDL::RobotModelKDL(){
+RobotModelKDL::RobotModelKDL() :
+    com_is_up_to_date(false){
 }
 
 RobotModelKDL::~RobotModelKDL(){
@@ -32,6 +48,8 @@ void RobotModelKDL::clear(){
     joint_limits.clear();
     robot_urdf.reset();
     joint_names_floating_base.clear();
+    tree_segments.clear();
+    com_is_up_to_date = false;
 }
 
 bool RobotModelKDL::configure(const RobotModelConfig& cfg){
@@ -192,6 +210,31 @@ bool RobotModelKDL::configure(const RobotModelConfig& cfg){
             joint_idx_map_kdl[jnt.getName()] = GetTreeElementQNr(it.second);
     }
 
+    // Store tree segments in topological order for the CoM computations
+    TreeSegment root_segment;
+    root_segment.segment = full_tree.getRootSegment();
+    root_segment.parent = -1;
+    tree_segments.push_back(root_segment);
+    for(size_t i = 0; i < tree_segments.size(); i++){
+        const KDL::SegmentMap::const_iterator segment = tree_segments[i].segment;
+        for(const KDL::SegmentMap::const_iterator& child : GetTreeElementChildren(segment->second)){
+            TreeSegment tree_segment;
+            tree_segment.segment = child;
+            tree_segment.parent = i;
+            tree_segments.push_back(tree_segment);
+        }
+    }
+    for(TreeSegment& tree_segment : tree_segments){
+        const KDL::Joint& jnt = GetTreeElementSegment(tree_segment.segment->second).getJoint();
+        tree_segment.q_nr = tree_segment.joint_idx = -1;
+        if(jnt.getType() != KDL::Joint::None){
+            tree_segment.q_nr = GetTreeElementQNr(tree_segment.segment->second);
+            tree_segment.joint_idx = jointIndex(jnt.getName());
+        }
+    }
+    com_jacobian.resize(3, noOfJoints());
+    centroidal_momentum_matrix.resize(6, noOfJoints());
+
     // 5. Print some debug info
 
     LOG_DEBUG("------------------- WBC RobotModelKDL -----------------");
@@ -217,6 +260,60 @@ bool RobotModelKDL::configure(const RobotModelConfig& cfg){
                          << "  Max. Eff: " << joint_limits[n].max.effort   << std::endl;
     LOG_DEBUG("------------------------------------------------------------");
 
+    state_revision++;
+
+    return true;
+}
+
+bool RobotModelKDL::reconfigure(const RobotModelConfig& cfg){
+
+    // Structural changes, e.g. a different URDF file or blacklisted joints, require reparsing the model
+    if(!robot_urdf || hasStructuralChanges(cfg))
+        return configure(cfg);
+
+    // Same defaults as in configure(): If actuated joint names are empty, assume that all joints are actuated
+    std::vector<std::string> new_actuated_joint_names = cfg.actuated_joint_names;
+    if(new_actuated_joint_names.empty()){
+        if(cfg.joint_names.empty()){
+            for(const std::string& n : jointNames())
+                if(std::find(joint_names_floating_base.begin(), joint_names_floating_base.end(), n) == joint_names_floating_base.end())
+                    new_actuated_joint_names.push_back(n);
+        }
+        else
+            new_actuated_joint_names = cfg.joint_names;
+    }
+
+    // Verify the new config before applying anything, so that the model remains unchanged in case of failure
+    for(const std::string& n : new_actuated_joint_names){
+        if(!hasJoint(n)){
+            LOG_ERROR_S << "Joint " << n << " has been configured in actuated_joint_names, but is not a non-fixed joint in the robot URDF"<<std::endl;
+            return false;
+        }
+    }
+    for(auto c : cfg.contact_points.names){
+        if(!hasLink(c)){
+            LOG_ERROR("Contact point %s is not a valid link in the robot model", c.c_str());
+            return false;
+        }
+    }
+
+    // Tree, kinematic chains and joint space buffers remain valid, only update actuation and contacts
+    if(new_actuated_joint_names != actuated_joint_names){
+        actuated_joint_names = new_actuated_joint_names;
+        selection_matrix.resize(noOfActuatedJoints(),noOfJoints());
+        selection_matrix.setZero();
+        for(int i = 0; i < actuated_joint_names.size(); i++)
+            selection_matrix(i, jointIndex(actuated_joint_names[i])) = 1.0;
+    }
+    contact_points = cfg.contact_points.names;
+    active_contacts = cfg.contact_points;
+
+    // Keep the current floating base state, the one in cfg is only the initial state
+    base::RigidBodyStateSE3 initial_floating_base_state = robot_model_config.floating_base_state;
+    robot_model_config = cfg;
+    robot_model_config.floating_base_state = initial_floating_base_state;
+    state_revision++;
+
     return true;
 }
 
@@ -239,6 +336,8 @@ void RobotModelKDL::createChain(const std::string &root_frame, const std::string
 void RobotModelKDL::update(const base::samples::Joints& joint_state,
                            const base::samples::RigidBodyStateSE3& _floating_base_state){
 
+    WBC_PROFILE_SCOPE("RobotModelKDL::update");
+
     if(joint_state.elements.size() != joint_state.names.size()){
         LOG_ERROR_S << "Size of names and size of elements in joint state do not match"<<std::endl;
         throw std::runtime_error("Invalid joint state");
@@ -287,6 +386,8 @@ void RobotModelKDL::update(const base::samples::Joints& joint_state,
             qdotdot(idx) = current_joint_state[name].acceleration;
         }
     }
+    com_is_up_to_date = false;
+    state_revision++;
 }
 
 const base::samples::Joints& RobotModelKDL::jointState(const std::vector<std::string> &joint_names){
@@ -462,70 +563,133 @@ const base::MatrixXd& RobotModelKDL::jointSpaceInertiaMatrix(){
 }
 
 
-void RobotModelKDL::recursiveCOM( const KDL::SegmentMap::const_iterator& currentSegment,
-                                  const base::samples::Joints& status, const KDL::Frame& frame,
-                                  double& mass, KDL::Vector& cog)
-{
-    double jointPosition = 0.0; // Joint position of the current joint
-#ifdef KDL_USE_NEW_TREE_INTERFACE
-    KDL::Segment segment = currentSegment->second->segment;
-#else
-    KDL::Segment segment = currentSegment->second.segment;
-#endif
-    // If the segment has a real joint, get the joint position
-    if( segment.getJoint().getType() != KDL::Joint::None ) {
-        try {
-            jointPosition = status[segment.getJoint().getName() ].position;
-        } catch (const std::runtime_error& error)
-        {
-            LOG_WARN("There is not information for this joint: ", segment.getJoint().getName().c_str());
+void RobotModelKDL::updateCenterOfMass(){
+
+    // Forward pass: Poses, velocities and acceleration bias (zero joint accelerations) of all segments. The CoM acceleration bias
+    // is the mass weighted sum of the linear accelerations of all link CoMs
+    KDL::Vector com_acc_moment = KDL::Vector::Zero();
+    for(TreeSegment& seg : tree_segments){
+        const KDL::Segment& segment = GetTreeElementSegment(seg.segment->second);
+        const KDL::Frame parent_pose = seg.parent >= 0 ? tree_segments[seg.parent].pose : KDL::Frame::Identity();
+        seg.pose = parent_pose * segment.pose(seg.q_nr >= 0 ? q(seg.q_nr) : 0.0);
+        seg.twist = seg.parent >= 0 ? tree_segments[seg.parent].twist : KDL::Twist::Zero();
+        seg.acc_bias = seg.parent >= 0 ? tree_segments[seg.parent].acc_bias : KDL::Twist::Zero();
+        if(seg.q_nr >= 0){
+            const KDL::Joint& jnt = segment.getJoint();
+            const KDL::Vector axis = parent_pose.M * jnt.JointAxis();
+            if(isPrismatic(jnt))
+                seg.joint_twist = KDL::Twist(axis, KDL::Vector::Zero());
+            else
+                seg.joint_twist = KDL::Twist((parent_pose * jnt.JointOrigin()) * axis, axis);
+            const KDL::Twist joint_vel = seg.joint_twist * qdot(seg.q_nr);
+            seg.twist = seg.twist + joint_vel;
+            // Time derivative of the joint twist is the spatial cross product of segment velocity and joint twist
+            seg.acc_bias = seg.acc_bias + KDL::Twist(seg.twist.rot * joint_vel.vel + seg.twist.vel * joint_vel.rot, seg.twist.rot * joint_vel.rot);
+        }
+        const KDL::RigidBodyInertia& inertia = segment.getInertia();
+        const KDL::Vector cog = seg.pose * inertia.getCOG();
+        const KDL::Vector cog_vel = seg.twist.vel + seg.twist.rot * cog;
+        com_acc_moment += inertia.getMass() * (seg.acc_bias.vel + seg.acc_bias.rot * cog + seg.twist.rot * cog_vel);
+        seg.subtree_inertia = seg.pose * inertia;
+        seg.subtree_mass = inertia.getMass();
+        seg.subtree_com_moment = inertia.getMass() * cog;
+    }
+
+    // Backward pass: Accumulate mass, CoM and composite rigid body inertia of all subtrees
+    for(size_t i = tree_segments.size()-1; i > 0; i--){
+        const TreeSegment& seg = tree_segments[i];
+        TreeSegment& parent = tree_segments[seg.parent];
+        parent.subtree_inertia = parent.subtree_inertia + seg.subtree_inertia;
+        parent.subtree_mass += seg.subtree_mass;
+        parent.subtree_com_moment += seg.subtree_com_moment;
+    }
+
+    const double mass = tree_segments[0].subtree_mass;
+    if(mass <= 0){
+        LOG_ERROR("RobotModelKDL: Total mass of the robot model is %f. Cannot compute center of mass", mass);
+        throw std::runtime_error("Invalid robot model mass");
+    }
+    const KDL::Vector com = tree_segments[0].subtree_com_moment / mass;
+
+    // Each joint moves its whole subtree. Column i of the CoM Jacobian is the velocity of the subtree CoM scaled by the relative subtree mass,
+    // column i of the centroidal momentum matrix is the momentum of the subtree about the overall CoM
+    com_jacobian.setZero();
+    centroidal_momentum_matrix.setZero();
+    for(const TreeSegment& seg : tree_segments){
+        if(seg.joint_idx < 0)
+            continue;
+        const KDL::Vector com_vel = (seg.subtree_mass * seg.joint_twist.vel + seg.joint_twist.rot * seg.subtree_com_moment) / mass;
+        const KDL::Wrench momentum = (seg.subtree_inertia * seg.joint_twist).RefPoint(com);
+        for(int k = 0; k < 3; k++){
+            com_jacobian(k, seg.joint_idx) = com_vel(k);
+            centroidal_momentum_matrix(k, seg.joint_idx) = momentum.force(k);
+            centroidal_momentum_matrix(k+3, seg.joint_idx) = momentum.torque(k);
         }
     }
+    com_acc_bias = base::Vector3d(com_acc_moment.x(), com_acc_moment.y(), com_acc_moment.z()) / mass;
 
-    // Transform to the frame of the current segment
-    KDL::Frame currentFrame = frame * segment.pose( jointPosition );
-    // Get the COG of the current segemnt in the KDL tree
-    KDL::Vector currentCOG = segment.getInertia().getCOG();
-    // Gets the current mass
-    double currentMass = segment.getInertia().getMass();
-
-    // Computes the cog
-    cog += currentMass * ( currentFrame * currentCOG );
-    // Appends to the total mass
-    mass += currentMass;
-
-    // Iterates through all the child segments
-    std::vector< KDL::SegmentMap::const_iterator >::const_iterator childSegment;
-#ifdef KDL_USE_NEW_TREE_INTERFACE
-    for( childSegment = currentSegment->second->children.begin();
-            childSegment != currentSegment->second->children.end();
-#else
-    for( childSegment = currentSegment->second.children.begin();
-            childSegment != currentSegment->second.children.end();
-#endif
-            ++childSegment)
-    {
-        // Calls this functiion again with the child segment
-        recursiveCOM( *childSegment, status, currentFrame, mass, cog );
+    com_rbs.frame_id = base_frame;
+    com_rbs.pose.position = base::Vector3d(com.x(), com.y(), com.z());
+    com_rbs.pose.orientation.setIdentity();
+    com_rbs.twist.linear = com_rbs.twist.angular = com_rbs.acceleration.angular = base::Vector3d::Zero();
+    com_rbs.acceleration.linear = com_acc_bias;
+    for(uint i = 0; i < noOfJoints(); i++){
+        com_rbs.twist.linear += com_jacobian.col(i) * current_joint_state[i].speed;
+        com_rbs.acceleration.linear += com_jacobian.col(i) * current_joint_state[i].acceleration;
     }
+    com_rbs.time = current_joint_state.time;
+
+    com_is_up_to_date = true;
 }
 
 const base::samples::RigidBodyStateSE3& RobotModelKDL::centerOfMass(){
-    double mass = 0.0; // to get the total mass
-    KDL::Frame frame = KDL::Frame::Identity(); // Transformation of the last frame
 
-    // Computes the COG of the complete robot
-    KDL::Vector cog_pos;
-    recursiveCOM( full_tree.getRootSegment(), current_joint_state, frame, mass, cog_pos );
+    if(current_joint_state.time.isNull()){
+        LOG_ERROR("RobotModelKDL: You have to call update() with appropriately timestamped joint data at least once before requesting kinematic information!");
+        throw std::runtime_error(" Invalid call to centerOfMass()");
+    }
 
-    // Returns the COG
-    com_rbs.frame_id = base_frame;
-    com_rbs.pose.position = base::Vector3d( cog_pos.x(), cog_pos.y(), cog_pos.z() ) / mass;
-    com_rbs.pose.orientation.setIdentity();
-    com_rbs.time = current_joint_state.time;
+    if(!com_is_up_to_date)
+        updateCenterOfMass();
     return com_rbs;
 }
 
+const base::MatrixXd& RobotModelKDL::comJacobian(){
+
+    if(current_joint_state.time.isNull()){
+        LOG_ERROR("RobotModelKDL: You have to call update() with appropriately timestamped joint data at least once before requesting kinematic information!");
+        throw std::runtime_error(" Invalid call to comJacobian()");
+    }
+
+    if(!com_is_up_to_date)
+        updateCenterOfMass();
+    return com_jacobian;
+}
+
+const base::Vector3d& RobotModelKDL::comAccelerationBias(){
+
+    if(current_joint_state.time.isNull()){
+        LOG_ERROR("RobotModelKDL: You have to call update() with appropriately timestamped joint data at least once before requesting kinematic information!");
+        throw std::runtime_error(" Invalid call to comAccelerationBias()");
+    }
+
+    if(!com_is_up_to_date)
+        updateCenterOfMass();
+    return com_acc_bias;
+}
+
+const base::MatrixXd& RobotModelKDL::centroidalMomentumMatrix(){
+
+    if(current_joint_state.time.isNull()){
+        LOG_ERROR("RobotModelKDL: You have to call update() with appropriately timestamped joint data at least once before requesting kinematic information!");
+        throw std::runtime_error(" Invalid call to centroidalMomentumMatrix()");
+    }
+
+    if(!com_is_up_to_date)
+        updateCenterOfMass();
+    return centroidal_momentum_matrix;
+}
+
 uint RobotModelKDL::jointIndex(const std::string &joint_name){
     uint idx = std::find(current_joint_state.names.begin(), current_joint_state.names.end(), joint_name) - current_joint_state.names.begin();
     if(idx >= current_joint_state.names.size())
@@ -26,10 +26,8 @@ private:
     std::vector<std::string> actuated_joint_names;
     std::string base_frame;
     base::JointLimits joint_limits;
-    base::samples::Joints current_joint_state;
     base::MatrixXd joint_space_inertia_mat;
     base::VectorXd bias_forces;
-    base::Acceleration spatial_acc_bias;
     base::MatrixXd selection_matrix;
     base::samples::Joints joint_state_out;
     std::vector<std::string> joint_names_floating_base;
@@ -40,13 +38,19 @@ private:
     typedef std::shared_ptr<KinematicChainKDL> KinematicChainKDLPtr;
     typedef std::map<std::string, KinematicChainKDLPtr> KinematicChainKDLMap;
     KDL::JntArray q,qdot,qdotdot,tau,zero;
+    base::VectorXd tmp_acc;
+    base::MatrixXd com_jacobian;
+    base::Vector3d com_acc_bias;
+    base::MatrixXd centroidal_momentum_matrix;
+    bool com_is_up_to_date;
+
+protected:
     typedef std::map<std::string, base::MatrixXd > JacobianMap;
+    base::samples::Joints current_joint_state;
+    base::Acceleration spatial_acc_bias;
     JacobianMap space_jac_map;
     JacobianMap body_jac_map;
     JacobianMap jac_dot_map;
-    base::VectorXd tmp_acc;
-
-protected:
     KDL::Tree full_tree;                          /** Overall kinematic tree*/
     std::map<std::string,int> joint_idx_map_kdl;
     KinematicChainKDLMap kdl_chain_map;           /** Map of KDL Chains*/
@@ -68,16 +72,24 @@ protected:
     /** ID of kinematic chain given root and tip*/
     const std::string chainID(const std::string& root, const std::string& tip){return root + "_" + tip;}
 
-    /**
-     * Recursively loops through all the tree segments and compute the
-     * COG of the complete tree.
-     * @param currentSegement Current Segement in the recursive loop
-     * @param status Current joint state
-     */
-    void recursiveCOM( const KDL::SegmentMap::const_iterator& currentSegment,
-                       const base::samples::Joints& status, const KDL::Frame& frame,
-                       double& mass, KDL::Vector& cog);
-
+    /** Helper for the O(n) tree recursions used in the CoM computations. Quantities are expressed in base frame coordinates with reference point base frame origin*/
+    struct TreeSegment{
+        KDL::SegmentMap::const_iterator segment;    /** Segment in the KDL tree*/
+        int parent;                                 /** Index of the parent segment in tree_segments, -1 for the root segment*/
+        int q_nr;                                   /** Index of the segment's joint in the KDL joint arrays, -1 for fixed joints*/
+        int joint_idx;                              /** Index of the segment's joint in jointNames(), -1 for fixed joints*/
+        KDL::Frame pose;                            /** Pose of the segment tip*/
+        KDL::Twist joint_twist;                     /** Twist of the segment for unit joint velocity*/
+        KDL::Twist twist;                           /** Spatial velocity of the segment*/
+        KDL::Twist acc_bias;                        /** Spatial acceleration of the segment for zero joint accelerations*/
+        KDL::RigidBodyInertia subtree_inertia;      /** Composite rigid body inertia of the subtree starting at this segment*/
+        double subtree_mass;                        /** Mass of the subtree starting at this segment*/
+        KDL::Vector subtree_com_moment;             /** Mass weighted CoM of the subtree starting at this segment*/
+    };
+    std::vector<TreeSegment> tree_segments;       /** All segments of the full tree, parents are always stored before their children*/
+
+    /** Compute CoM, CoM Jacobian, CoM acceleration bias and centroidal momentum matrix with one forward and one backward pass through the tree*/
+    void updateCenterOfMass();
 
 public:
     RobotModelKDL();
@@ -95,6 +107,15 @@ public:
      */
     virtual bool configure(const RobotModelConfig& cfg);
 
+    /**
+     * @brief Change the configuration of an already configured model. If only contact points and/or actuated joints differ from the current configuration,
+     *  the KDL tree, all kinematic chains and the joint space buffers will be kept. Any other change (e.g. URDF file, joint names, joint blacklist or floating base)
+     *  requires reparsing the model, in which case a full configure() is performed.
+     * @param cfg New model configuration. See RobotModelConfig.hpp for details
+     * @return True in case of success, else false. In case of failure in the incremental case, the model remains unchanged.
+     */
+    virtual bool reconfigure(const RobotModelConfig& cfg);
+
     /**
      * @brief Update the robot model. The joint state has to contain all joints that are relevant in the model. This means: All joints that are ever required
      *  when requesting rigid body states, Jacobians or joint states. Note that
@@ -193,6 +214,17 @@ public:
     /** @brief Compute and return center of mass expressed in base frame*/
     virtual const base::samples::RigidBodyStateSE3& centerOfMass();
 
+    /** @brief Compute and return the CoM Jacobian, which is 3 x nj, where nj is the number of joints of the system. Reference frame is the base frame of the robot.
+      * The order of the columns will be the same as the configured joint order of the robot*/
+    virtual const base::MatrixXd& comJacobian();
+
+    /** @brief Compute and return the CoM acceleration bias, i.e. the term Jcom_dot*qdot, expressed in base frame*/
+    virtual const base::Vector3d& comAccelerationBias();
+
+    /** @brief Compute and return the centroidal momentum matrix A_G, which is 6 x nj, where nj is the number of joints of the system. A_G maps the joint velocities to
+      * the spatial momentum of the robot about its CoM, expressed in base frame. First three rows correspond to linear, last three rows to angular momentum*/
+    virtual const base::MatrixXd& centroidalMomentumMatrix();
+
     /** @brief Compute and return the inverse dynamics solution*/
     virtual void computeInverseDynamics(base::commands::Joints &solver_output);
 
@@ -0,0 +1,150 @@
+#ifndef ROBOTMODELKDLFIXED_HPP
+#define ROBOTMODELKDLFIXED_HPP
+
+#include "RobotModelKDL.hpp"
+#include "FixedSizeChain.hpp"
+#include <base-logging/Logging.hpp>
+
+namespace wbc{
+
+/**
+ * @brief Thin adapter that plugs FixedSizeChain into the RobotModel interface. All kinematic chains with exactly NJ joints are evaluated with
+ *  the fixed-size, allocation-free kernels of FixedSizeChain. All other chains and all dynamics computations are forwarded to RobotModelKDL.
+ *  Typical usage is with a known robot arm, e.g. RobotModelKDLFixed<7> for the KUKA iiwa.
+ */
+template<int NJ> class RobotModelKDLFixed : public RobotModelKDL{
+protected:
+    typedef Eigen::Matrix<int,NJ,1> JointIndexVector;
+
+    struct FixedChain{
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        FixedChain(const KDL::Chain& chain) : chain(chain), is_up_to_date(false){}
+        FixedSizeChain<NJ> chain;
+        JointIndexVector joint_idx;
+        base::samples::RigidBodyStateSE3 rbs;
+        base::MatrixXd space_jac, jac_dot;      /** Output buffers (6 x noOfJoints()). Only the NJ columns of the chain joints are non-zero*/
+        bool is_up_to_date;
+    };
+    typedef std::shared_ptr<FixedChain> FixedChainPtr;
+    /** Fixed size chains by root and tip frame. The nested maps allow the lookup without constructing a chain ID string. Null pointer for chains without NJ joints*/
+    std::map<std::string, std::map<std::string, FixedChainPtr> > fixed_chain_map;
+
+    typename FixedSizeChain<NJ>::JointVector q_fixed, qd_fixed, qdd_fixed;
+
+    /** Return the up-to-date fixed size chain for the given root and tip or a null pointer if the chain does not have NJ joints*/
+    FixedChain* fixedChain(const std::string &root_frame, const std::string &tip_frame){
+
+        if(current_joint_state.time.isNull()){
+            LOG_ERROR("RobotModelKDLFixed: You have to call update() with appropriately timestamped joint data at least once before requesting kinematic information!");
+            throw std::runtime_error(" Invalid call to fixedChain()");
+        }
+
+        std::map<std::string, FixedChainPtr>& chains = fixed_chain_map[root_frame];
+        auto it = chains.find(tip_frame);
+        if(it == chains.end()){
+            KDL::Chain chain;
+            if(!full_tree.getChain(root_frame, tip_frame, chain)){
+                LOG_ERROR("Unable to extract kinematics chain from %s to %s from KDL tree", root_frame.c_str(), tip_frame.c_str());
+                throw std::invalid_argument("Invalid robot model config");
+            }
+            FixedChainPtr fixed_chain;
+            if(chain.getNrOfJoints() == NJ){
+                // FixedChain contains fixed-size vectorizable Eigen members. In C++11, std::make_shared does not respect their alignment
+                fixed_chain = std::allocate_shared<FixedChain>(Eigen::aligned_allocator<FixedChain>(), chain);
+                for(int j = 0; j < NJ; j++)
+                    fixed_chain->joint_idx(j) = jointIndex(fixed_chain->chain.jointNames()[j]);
+                fixed_chain->rbs.frame_id = root_frame;
+                fixed_chain->space_jac.setZero(6,noOfJoints());
+                fixed_chain->jac_dot.setZero(6,noOfJoints());
+            }
+            it = chains.insert(std::make_pair(tip_frame, fixed_chain)).first;
+        }
+
+        FixedChain* fixed_chain = it->second.get();
+        if(fixed_chain && !fixed_chain->is_up_to_date){
+            for(int j = 0; j < NJ; j++){
+                const base::JointState& js = current_joint_state[fixed_chain->joint_idx(j)];
+                q_fixed(j) = js.position;
+                qd_fixed(j) = js.speed;
+                qdd_fixed(j) = js.acceleration;
+            }
+            fixed_chain->chain.update(q_fixed, qd_fixed, qdd_fixed);
+            fixed_chain->is_up_to_date = true;
+        }
+        return fixed_chain;
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    virtual bool configure(const RobotModelConfig& cfg){
+        fixed_chain_map.clear();
+        return RobotModelKDL::configure(cfg);
+    }
+
+    virtual void update(const base::samples::Joints& joint_state,
+                        const base::samples::RigidBodyStateSE3& floating_base_state = base::samples::RigidBodyStateSE3()){
+        RobotModelKDL::update(joint_state, floating_base_state);
+        for(auto& chains : fixed_chain_map){
+            for(auto& it : chains.second){
+                if(it.second)
+                    it.second->is_up_to_date = false;
+            }
+        }
+    }
+
+    virtual const base::samples::RigidBodyStateSE3 &rigidBodyState(const std::string &root_frame, const std::string &tip_frame){
+        FixedChain* fixed_chain = fixedChain(root_frame, tip_frame);
+        if(!fixed_chain)
+            return RobotModelKDL::rigidBodyState(root_frame, tip_frame);
+
+        const FixedSizeChain<NJ>& chain = fixed_chain->chain;
+        base::samples::RigidBodyStateSE3& rbs = fixed_chain->rbs;
+        rbs.pose.position = chain.pose().translation();
+        rbs.pose.orientation = base::Quaterniond(chain.pose().linear());
+        rbs.twist.linear = chain.twist().template segment<3>(0);
+        rbs.twist.angular = chain.twist().template segment<3>(3);
+        rbs.acceleration.linear = chain.acceleration().template segment<3>(0);
+        rbs.acceleration.angular = chain.acceleration().template segment<3>(3);
+        rbs.time = current_joint_state.time;
+        return rbs;
+    }
+
+    virtual const base::MatrixXd &spaceJacobian(const std::string &root_frame, const std::string &tip_frame){
+        FixedChain* fixed_chain = fixedChain(root_frame, tip_frame);
+        if(!fixed_chain)
+            return RobotModelKDL::spaceJacobian(root_frame, tip_frame);
+
+        base::MatrixXd& jac = fixed_chain->space_jac;
+        for(int j = 0; j < NJ; j++)
+            jac.col(fixed_chain->joint_idx(j)) = fixed_chain->chain.jacobian().col(j);
+        return jac;
+    }
+
+    virtual const base::MatrixXd &jacobianDot(const std::string &root_frame, const std::string &tip_frame){
+        FixedChain* fixed_chain = fixedChain(root_frame, tip_frame);
+        if(!fixed_chain)
+            return RobotModelKDL::jacobianDot(root_frame, tip_frame);
+
+        base::MatrixXd& jac_dot = fixed_chain->jac_dot;
+        for(int j = 0; j < NJ; j++)
+            jac_dot.col(fixed_chain->joint_idx(j)) = fixed_chain->chain.jacobianDot().col(j);
+        return jac_dot;
+    }
+
+    virtual const base::Acceleration &spatialAccelerationBias(const std::string &root_frame, const std::string &tip_frame){
+        FixedChain* fixed_chain = fixedChain(root_frame, tip_frame);
+        if(!fixed_chain)
+            return RobotModelKDL::spatialAccelerationBias(root_frame, tip_frame);
+
+        for(int j = 0; j < NJ; j++)
+            qd_fixed(j) = current_joint_state[fixed_chain->joint_idx(j)].speed;
+        const typename FixedSizeChain<NJ>::SpatialVector acc = fixed_chain->chain.jacobianDot() * qd_fixed;
+        spatial_acc_bias = base::Acceleration(acc.template segment<3>(0), acc.template segment<3>(3));
+        return spatial_acc_bias;
+    }
+};
+
+}
+
+#endif // ROBOTMODELKDLFIXED_HPP
@@ -1,6 +1,7 @@
 #include "AccelerationScene.hpp"
 #include "../core/RobotModel.hpp"
 #include <base-logging/Logging.hpp>
+#include "../core/Profiler.hpp"
 
 namespace wbc{
 
@@ -10,6 +11,8 @@ ConstraintPtr AccelerationScene::createConstraint(const ConstraintConfig &config
         return std::make_shared<CartesianAccelerationConstraint>(config, robot_model->noOfJoints());
     else if(config.type == jnt)
         return std::make_shared<JointAccelerationConstraint>(config, robot_model->noOfJoints());
+    else if(config.type == com)
+        return std::make_shared<CoMAccelerationConstraint>(config, robot_model->noOfJoints());
     else{
         LOG_ERROR("Constraint with name %s has an invalid constraint type: %i", config.name.c_str(), config.type);
         throw std::invalid_argument("Invalid constraint config");
@@ -18,6 +21,8 @@ ConstraintPtr AccelerationScene::createConstraint(const ConstraintConfig &config
 
 const HierarchicalQP& AccelerationScene::update(){
 
+    WBC_PROFILE_SCOPE("AccelerationScene::update");
+
     if(!configured)
         throw std::runtime_error("AccelerationScene has not been configured!. PLease call configure() before calling update() for the first time!");
 
@@ -35,7 +40,10 @@ const HierarchicalQP& AccelerationScene::update(){
     //    W - Vector of constraint weights. One vector for each priority
 
     int prio = 0; // Only one priority is implemented here!
-    constraints_prio[prio].resize(n_constraint_variables_per_prio[prio], robot_model->noOfJoints());
+    fetchInputs();
+    const bool model_changed = robotModelChanged();
+    n_skipped_constraints = 0;
+    constraints_prio[prio].resizeIfRequired(n_constraint_variables_per_prio[prio], robot_model->noOfJoints());
 
     // Walk through all tasks of current priority
     uint row_index = 0;
@@ -45,66 +53,84 @@ const HierarchicalQP& AccelerationScene::update(){
         int type = constraints[prio][i]->config.type;
         uint n_vars = constraints[prio][i]->config.nVariables();
 
-        if(type == cart){
-
-            CartesianAccelerationConstraintPtr constraint = std::static_pointer_cast<CartesianAccelerationConstraint>(constraints[prio][i]);
-
-            // Constraint Jacobian
-            constraint->A = robot_model->spaceJacobian(constraint->config.root, constraint->config.tip);
-
-            // Constraint reference
-            base::samples::Joints joint_state = robot_model->jointState(robot_model->jointNames());
-            q_dot.resize(robot_model->noOfJoints());
-            for(size_t j = 0; j < joint_state.size(); j++)
-                q_dot(j) = joint_state[j].speed;
-            base::Acceleration bias_acc = robot_model->spatialAccelerationBias(constraint->config.root, constraint->config.tip);
-            constraint->y_ref = constraint->y_ref - bias_acc;
-
-            // Convert input acceleration from the reference frame of the constraint to the base frame of the robot. We transform only the orientation of the
-            // reference frame to which the twist is expressed, NOT the position. This means that the center of rotation for a Cartesian constraint will
-            // be the origin of ref frame, not the root frame. This is more intuitive when controlling the orientation of e.g. a robot' s end effector.
-            ref_frame = robot_model->rigidBodyState(constraint->config.root, constraint->config.ref_frame);
-            constraint->y_ref_root.segment(0,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->y_ref.segment(0,3);
-            constraint->y_ref_root.segment(3,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->y_ref.segment(3,3);
-
-            // Also convert the weight vector from ref frame to the root frame. Take the absolute values after rotation, since weights can only
-            // assume positive values
-            constraint->weights_root.segment(0,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->weights.segment(0,3);
-            constraint->weights_root.segment(3,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->weights.segment(3,3);
-            constraint->weights_root = constraint->weights_root.cwiseAbs();
-
+        // Inactive constraints keep their rows in the QP, but these are set to zero. All kinematics computations are skipped
+        if(isInactive(constraints[prio][i])){
+            skipConstraint(constraints[prio][i]);
+            constraints_prio[prio].Wy.segment(row_index, n_vars).setZero();
+            constraints_prio[prio].A.block(row_index, 0, n_vars, robot_model->noOfJoints()).setZero();
+            constraints_prio[prio].lower_y.segment(row_index, n_vars).setZero();
+            constraints_prio[prio].upper_y.segment(row_index, n_vars).setZero();
+            row_index += n_vars;
+            continue;
         }
-        else if(type == jnt){
-            JointAccelerationConstraintPtr constraint = std::static_pointer_cast<JointAccelerationConstraint>(constraints[prio][i]);
 
-            // Joint space constraints: constraint matrix has only ones and Zeros. The joint order in the constraints might be different than in the robot model.
-            // Thus, for joint space constraints, the joint indices have to be mapped correctly.
-            for(uint k = 0; k < constraint->config.joint_names.size(); k++){
+        // Kinematic quantities of a constraint only have to be recomputed if the constraint or the robot state changed. Since A is reused for the
+        // cost function below, the constraint blocks themselves are always written
+        if(constraintNeedsUpdate(constraints[prio][i], model_changed)){
+            WBC_PROFILE_SCOPE_DETAIL("AccelerationScene::constraintKinematics", constraints[prio][i]->config.name.c_str());
+            if(type == cart){
+
+                CartesianAccelerationConstraintPtr constraint = std::static_pointer_cast<CartesianAccelerationConstraint>(constraints[prio][i]);
+
+                // Constraint Jacobian
+                constraint->A = model_cache.spaceJacobian(constraint->config.root, constraint->config.tip);
+
+                // Constraint reference
+                const base::samples::Joints& joint_state = model_cache.jointState();
+                q_dot.resize(robot_model->noOfJoints());
+                for(size_t j = 0; j < joint_state.size(); j++)
+                    q_dot(j) = joint_state[j].speed;
+                base::Acceleration bias_acc = model_cache.spatialAccelerationBias(constraint->config.root, constraint->config.tip);
+                constraint->y_ref = constraint->y_ref - bias_acc;
+
+                // Convert input acceleration from the reference frame of the constraint to the base frame of the robot. We transform only the orientation of the
+                // reference frame to which the twist is expressed, NOT the position. This means that the center of rotation for a Cartesian constraint will
+                // be the origin of ref frame, not the root frame. This is more intuitive when controlling the orientation of e.g. a robot' s end effector.
+                ref_frame = model_cache.rigidBodyState(constraint->config.root, constraint->config.ref_frame);
+                constraint->y_ref_root.segment(0,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->y_ref.segment(0,3);
+                constraint->y_ref_root.segment(3,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->y_ref.segment(3,3);
+
+                // Also convert the weight vector from ref frame to the root frame. Take the absolute values after rotation, since weights can only
+                // assume positive values
+                constraint->weights_root.segment(0,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->weights.segment(0,3);
+                constraint->weights_root.segment(3,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->weights.segment(3,3);
+                constraint->weights_root = constraint->weights_root.cwiseAbs();
+
+            }
+            else if(type == jnt){
+                JointAccelerationConstraintPtr constraint = std::static_pointer_cast<JointAccelerationConstraint>(constraints[prio][i]);
 
-                int idx = robot_model->jointIndex(constraint->config.joint_names[k]);
-                constraint->A(k,idx) = 1.0;
+                // Joint space constraints: The constraint matrix is a selection matrix, which has been initialized from the joint indices in configure()
                 constraint->y_ref_root = constraint->y_ref;     // In joint space y_ref is equal to y_ref_root
                 constraint->weights_root = constraint->weights; // Same for the weights
             }
-        }
-        else{
-            LOG_ERROR("Constraint %s: Invalid type: %i", constraints[prio][i]->config.name.c_str(), type);
-            throw std::invalid_argument("Invalid constraint configuration");
+            else if(type == com){
+                CoMAccelerationConstraintPtr constraint = std::static_pointer_cast<CoMAccelerationConstraint>(constraints[prio][i]);
+
+                // CoM constraints are always expressed in the base frame of the robot. Desired CoM acceleration: y_r = y_d - Jcom_dot*qdot
+                constraint->A = model_cache.comJacobian();
+                constraint->y_ref_root = constraint->y_ref - model_cache.comAccelerationBias();
+                constraint->weights_root = constraint->weights;
+            }
+            else{
+                LOG_ERROR("Constraint %s: Invalid type: %i", constraints[prio][i]->config.name.c_str(), type);
+                throw std::invalid_argument("Invalid constraint configuration");
+            }
         }
 
         ConstraintPtr constraint = constraints[prio][i];
 
-        // If the activation value is zero, also set reference to zero. Activation is usually used to switch between different
-        // task phases and we don't want to store the "old" reference value, in case we switch on the constraint again
-        if(constraint->activation == 0){
-           constraint->y_ref.setZero();
-           constraint->y_ref_root.setZero();
+        // Insert constraints into equation system of current priority at the correct position
+        constraints_prio[prio].Wy.segment(row_index, n_vars) = constraint->weights_root * constraint->activation;
+        if(type == jnt){
+            // Scatter the selection matrix instead of copying the dense constraint matrix
+            const std::vector<int>& joint_idx = std::static_pointer_cast<JointConstraint>(constraint)->joint_idx;
+            constraints_prio[prio].A.block(row_index, 0, n_vars, robot_model->noOfJoints()).setZero();
+            for(uint k = 0; k < n_vars; k++)
+                constraints_prio[prio].A(row_index+k, joint_idx[k]) = 1.0;
         }
-
-        // Insert constraints into equation system of current priority at the correct position. Note: Weights will be zero if activations
-        // for this constraint is zero or if the constraint is in timeout
-        constraints_prio[prio].Wy.segment(row_index, n_vars) = constraint->weights_root * constraint->activation * (!constraint->timeout);
-        constraints_prio[prio].A.block(row_index, 0, n_vars, robot_model->noOfJoints()) = constraint->A;
+        else
+            constraints_prio[prio].A.block(row_index, 0, n_vars, robot_model->noOfJoints()) = constraint->A;
         constraints_prio[prio].lower_y.segment(row_index, n_vars) = constraint->y_ref_root;
         constraints_prio[prio].upper_y.segment(row_index, n_vars) = constraint->y_ref_root;
 
@@ -125,16 +151,21 @@ const HierarchicalQP& AccelerationScene::update(){
 
     constraints_prio.time = base::Time::now(); //  TODO: Use latest time stamp from all constraints!?
     constraints_prio.Wq = base::VectorXd::Map(joint_weights.elements.data(), robot_model->noOfJoints());
+    clearChanges();
     return constraints_prio;
 }
 
 const base::commands::Joints& AccelerationScene::solve(const HierarchicalQP& hqp){
 
     // solve
+    WBC_PROFILE_SCOPE("AccelerationScene::solve");
     solver_output.resize(hqp[0].nq);
-    solver->solve(hqp, solver_output);
+    solver_status = solver->trySolve(solverInput(hqp), solver_output);
+    if(solver_status == solver_failed)
+        throw std::runtime_error("AccelerationScene::solve: Solver failed to solve the QP: " + solver->getFailureReason());
 
     // Convert Output
+    WBC_PROFILE_SCOPE("AccelerationScene::convertOutput");
     solver_output_joints.resize(robot_model->noOfActuatedJoints());
     solver_output_joints.names = robot_model->actuatedJointNames();
     for(uint i = 0; i < robot_model->noOfActuatedJoints(); i++){
@@ -150,7 +181,7 @@ const ConstraintsStatus &AccelerationScene::updateConstraintsStatus(){
 
     robot_acc.resize(robot_model->noOfJoints());
     uint nj = robot_model->noOfJoints();
-    const base::samples::Joints &joint_state = robot_model->jointState(robot_model->jointNames());
+    const base::samples::Joints &joint_state = model_cache.jointState();
     for(size_t i = 0; i < nj; i++)
         robot_acc(i) = joint_state[i].acceleration;
 
@@ -166,8 +197,14 @@ const ConstraintsStatus &AccelerationScene::updateConstraintsStatus(){
             constraints_status[name].weights    = constraint->weights;
             constraints_status[name].y_ref      = constraint->y_ref_root;
             if(constraint->config.type == cart){
-                const base::MatrixXd &jac = robot_model->spaceJacobian(constraint->config.root, constraint->config.tip);
-                const base::Acceleration &bias_acc = robot_model->spatialAccelerationBias(constraint->config.root, constraint->config.tip);
+                const base::MatrixXd &jac = model_cache.spaceJacobian(constraint->config.root, constraint->config.tip);
+                const base::Acceleration &bias_acc = model_cache.spatialAccelerationBias(constraint->config.root, constraint->config.tip);
+                constraints_status[name].y_solution = jac * solver_output + bias_acc;
+                constraints_status[name].y          = jac * robot_acc + bias_acc;
+            }
+            else if(constraint->config.type == com){
+                const base::MatrixXd &jac = model_cache.comJacobian();
+                const base::Vector3d &bias_acc = model_cache.comAccelerationBias();
                 constraints_status[name].y_solution = jac * solver_output + bias_acc;
                 constraints_status[name].y          = jac * robot_acc + bias_acc;
             }
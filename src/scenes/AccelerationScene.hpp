@@ -4,6 +4,7 @@
 #include "../core/Scene.hpp"
 #include "../core/JointAccelerationConstraint.hpp"
 #include "../core/CartesianAccelerationConstraint.hpp"
+#include "../core/CoMAccelerationConstraint.hpp"
 
 namespace wbc{
 
@@ -1,12 +1,18 @@
 #include "AccelerationSceneTSID.hpp"
 #include "core/RobotModel.hpp"
 #include <base-logging/Logging.hpp>
+#include <cmath>
+#include <limits>
+#include "core/Profiler.hpp"
 
 namespace wbc {
 
 AccelerationSceneTSID::AccelerationSceneTSID(RobotModelPtr robot_model, QPSolverPtr solver) :
     WbcScene(robot_model,solver),
-    hessian_regularizer(1e-8){
+    hessian_regularizer(1e-8),
+    priority_weight_ratio(100),
+    use_contact_constraints(false),
+    contact_params_changed(false){
 
 }
 
@@ -16,155 +22,305 @@ ConstraintPtr AccelerationSceneTSID::createConstraint(const ConstraintConfig &co
         return std::make_shared<CartesianAccelerationConstraint>(config, robot_model->noOfJoints());
     else if(config.type == jnt)
         return std::make_shared<JointAccelerationConstraint>(config, robot_model->noOfJoints());
+    else if(config.type == com)
+        return std::make_shared<CoMAccelerationConstraint>(config, robot_model->noOfJoints());
     else{
         LOG_ERROR("Constraint with name %s has an invalid constraint type: %i", config.name.c_str(), config.type);
         throw std::invalid_argument("Invalid constraint config");
     }
 }
 
+void AccelerationSceneTSID::setPriorityWeightRatio(const double ratio){
+    if(ratio <= 0){
+        LOG_ERROR("AccelerationSceneTSID: Priority weight ratio has to be > 0, but is %f", ratio);
+        throw std::invalid_argument("Invalid priority weight ratio");
+    }
+    priority_weight_ratio = ratio;
+}
+
+void AccelerationSceneTSID::checkContactParams(const ContactParams& params){
+    if(params.mu <= 0){
+        LOG_ERROR("AccelerationSceneTSID: Friction coefficient has to be > 0, but is %f", params.mu);
+        throw std::invalid_argument("Invalid contact params");
+    }
+    if(params.n_facets < 3){
+        LOG_ERROR("AccelerationSceneTSID: Number of friction pyramid facets has to be >= 3, but is %i", params.n_facets);
+        throw std::invalid_argument("Invalid contact params");
+    }
+    // The CoP constraints are multiplied with the normal force, which is only valid for f_z >= 0
+    if(params.min_normal_force < 0){
+        LOG_ERROR("AccelerationSceneTSID: Minimum normal force has to be >= 0, but is %f", params.min_normal_force);
+        throw std::invalid_argument("Invalid contact params");
+    }
+    if(params.cop_min[0] > params.cop_max[0] || params.cop_min[1] > params.cop_max[1]){
+        LOG_ERROR("AccelerationSceneTSID: Lower CoP bound (%f,%f) is larger than upper CoP bound (%f,%f)",
+                  params.cop_min[0], params.cop_min[1], params.cop_max[0], params.cop_max[1]);
+        throw std::invalid_argument("Invalid contact params");
+    }
+}
+
+void AccelerationSceneTSID::setUseContactConstraints(const bool use){
+    use_contact_constraints = use;
+    contact_params_changed = true;
+}
+
+void AccelerationSceneTSID::setContactParams(const ContactParams& params){
+    checkContactParams(params);
+    default_contact_params = params;
+    contact_params_changed = true;
+}
+
+void AccelerationSceneTSID::setContactParams(const std::string& contact_name, const ContactParams& params){
+    checkContactParams(params);
+    contact_params[contact_name] = params;
+    contact_params_changed = true;
+}
+
+const ContactParams& AccelerationSceneTSID::getContactParams(const std::string& contact_name){
+    auto it = contact_params.find(contact_name);
+    return it == contact_params.end() ? default_contact_params : it->second;
+}
+
+void AccelerationSceneTSID::setContactWrenchConstraints(const ContactParams& params, uint row, uint col, QuadraticProgram& qp){
+
+    // Contact wrench f = (force, torque), expressed in the contact frame. The contact normal is the z-axis
+    const double inf = std::numeric_limits<double>::infinity();
+    const uint fx = col, fy = col+1, fz = col+2, tx = col+3, ty = col+4;
+
+    // Friction pyramid, inscribed in the friction cone: cos(a_k)*f_x + sin(a_k)*f_y - mu*cos(pi/n)*f_z <= 0
+    const double mu = params.mu*cos(M_PI/params.n_facets);
+    for(uint k = 0; k < params.n_facets; k++, row++){
+        const double a = 2*M_PI*k/params.n_facets;
+        qp.A(row,fx) = cos(a);
+        qp.A(row,fy) = sin(a);
+        qp.A(row,fz) = -mu;
+        qp.lower_y(row) = -inf;
+        qp.upper_y(row) = 0;
+    }
+
+    // Unilateral contact: f_z >= f_min
+    qp.A(row,fz) = 1;
+    qp.lower_y(row) = params.min_normal_force;
+    qp.upper_y(row++) = inf;
+
+    // Center of pressure: cop_x = -tau_y/f_z, cop_y = tau_x/f_z. Multiplied with f_z >= 0 this is linear in the wrench
+    qp.A(row,ty) = -1;
+    qp.A(row,fz) = -params.cop_max[0];
+    qp.lower_y(row) = -inf;
+    qp.upper_y(row++) = 0;
+    qp.A(row,ty) = -1;
+    qp.A(row,fz) = -params.cop_min[0];
+    qp.lower_y(row) = 0;
+    qp.upper_y(row++) = inf;
+    qp.A(row,tx) = 1;
+    qp.A(row,fz) = -params.cop_max[1];
+    qp.lower_y(row) = -inf;
+    qp.upper_y(row++) = 0;
+    qp.A(row,tx) = 1;
+    qp.A(row,fz) = -params.cop_min[1];
+    qp.lower_y(row) = 0;
+    qp.upper_y(row++) = inf;
+}
+
 const HierarchicalQP& AccelerationSceneTSID::update(){
 
+    WBC_PROFILE_SCOPE("AccelerationSceneTSID::update");
+
     if(!configured)
         throw std::runtime_error("AccelerationSceneTSID has not been configured!. PLease call configure() before calling update() for the first time!");
 
-    if(constraints.size() != 1){
-        LOG_ERROR("Number of priorities in AccelerationSceneTSID should be 1, but is %i", constraints.size());
-        throw std::runtime_error("Invalid constraint configuration");
-    }
+    // All priorities are mapped to a single weighted level of the QP (soft hierarchy), see setPriorityWeightRatio()
+    if(constraints_prio.size() != 1)
+        constraints_prio.resize(1);
 
-    int prio = 0; // Only one priority is implemented here!
+    int prio = 0; // All priorities are mapped to a single QP level
     uint nj = robot_model->noOfJoints();
     uint na = robot_model->noOfActuatedJoints();
     uint ncp = robot_model->getActiveContacts().size();
+    uint n_contact_rows = 0;
+    if(use_contact_constraints){
+        // Only active contacts can transmit forces, so inactive contacts do not get contact wrench constraints
+        const ActiveContacts& contact_points = robot_model->getActiveContacts();
+        for(uint i = 0; i < ncp; i++){
+            if(contact_points[i] != 0)
+                n_contact_rows += getContactParams(contact_points.names[i]).noOfRows();
+        }
+    }
 
-    // QP Size: (NJoints+NContacts*2*6 x NJoints+NActuatedJoints+NContacts*6)
+    // QP Size: (NJoints+NContacts*6+NContactRows x NJoints+NActuatedJoints+NContacts*6)
     // Variable order: (acc,torque,f_ext)
-    constraints_prio[prio].resize(nj+ncp*6,nj+na+ncp*6);
-    constraints_prio[prio].H.setZero();
-    constraints_prio[prio].g.setZero();
+    fetchInputs();
+    const bool model_changed = robotModelChanged();
+    const bool resized = constraints_prio[prio].resizeIfRequired(nj+ncp*6+n_contact_rows,nj+na+ncp*6);
+    if(resized){
+        // Only the joint acceleration block of H and g is written below, the torques and contact forces are not part of the cost function
+        constraints_prio[prio].H.setZero();
+        constraints_prio[prio].g.setZero();
+    }
+    hessian_assembler.reset(nj);
+    n_skipped_constraints = 0;
+    col_weights = base::VectorXd::Map(joint_weights.elements.data(), nj);
 
     ///////// Tasks
 
     // Walk through all tasks
-    for(uint i = 0; i < constraints[prio].size(); i++){
-
-        int type = constraints[prio][i]->config.type;
-        constraints[prio][i]->checkTimeout();
-        ConstraintPtr constraint;
-
-        if(type == cart){
-            constraint = std::static_pointer_cast<CartesianAccelerationConstraint>(constraints[prio][i]);
-
-            // Task Jacobian
-            constraint->A = robot_model->spaceJacobian(constraint->config.root, constraint->config.tip);
-
-             // Desired task space acceleration: y_r = y_d - Jdot*qdot
-            base::samples::Joints joint_state = robot_model->jointState(robot_model->jointNames());
-            q_dot.resize(robot_model->noOfJoints());
-            for(size_t j = 0; j < joint_state.size(); j++)
-                q_dot(j) = joint_state[j].speed;
-            constraint->y_ref = constraint->y_ref - robot_model->spatialAccelerationBias(constraint->config.root, constraint->config.tip);
-
-            // Convert input acceleration from the reference frame of the constraint to the base frame of the robot. We transform only the orientation of the
-            // reference frame to which the twist is expressed, NOT the position. This means that the center of rotation for a Cartesian constraint will
-            // be the origin of ref frame, not the root frame. This is more intuitive when controlling the orientation of e.g. a robot' s end effector.
-            base::samples::RigidBodyStateSE3 ref_frame = robot_model->rigidBodyState(constraint->config.root, constraint->config.ref_frame);
-            constraint->y_ref_root.segment(0,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->y_ref.segment(0,3);
-            constraint->y_ref_root.segment(3,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->y_ref.segment(3,3);
-
-            // Also convert the weight vector from ref frame to the root frame. Take the absolute values after rotation, since weights can only
-            // assume positive values
-            constraint->weights_root.segment(0,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->weights.segment(0,3);
-            constraint->weights_root.segment(3,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->weights.segment(3,3);
-            constraint->weights_root = constraint->weights_root.cwiseAbs();
-        }
-        else if(type == jnt){
-            constraint = std::static_pointer_cast<JointAccelerationConstraint>(constraints[prio][i]);
+    for(uint level = 0; level < constraints.size(); level++){
+
+        // Lower priorities get exponentially smaller weights in the cost function, priority 0 keeps the configured weights. Since the row weights
+        // enter the Hessian quadratically, the square root of the cost weight is applied to the rows
+        const double level_weight = pow(priority_weight_ratio, -0.5*level);
+        for(uint i = 0; i < constraints[level].size(); i++){
 
-            // Joint space constraints: constraint matrix has only ones and Zeros. The joint order in the constraints might be different than in the robot model.
-            // Thus, for joint space constraints, the joint indices have to be mapped correctly.
-            for(uint k = 0; k < constraint->config.joint_names.size(); k++){
+            int type = constraints[level][i]->config.type;
+            constraints[level][i]->checkTimeout();
+            ConstraintPtr constraint = constraints[level][i];
 
-                int idx = robot_model->jointIndex(constraint->config.joint_names[k]);
-                constraint->A(k,idx) = 1.0;
-                constraint->y_ref_root = constraint->y_ref;     // In joint space y_ref is equal to y_ref_root
-                constraint->weights_root = constraint->weights; // Same for the weights
+            // Inactive constraints do not contribute to the cost function. Skip them, including all kinematics computations
+            if(isInactive(constraints[level][i])){
+                skipConstraint(constraints[level][i]);
+                continue;
             }
 
-        }
-        else{
-            LOG_ERROR("Constraint %s: Invalid type: %i", constraints[prio][i]->config.name.c_str(), type);
-            throw std::invalid_argument("Invalid constraint configuration");
-        }
+            // Kinematic quantities of a constraint only have to be recomputed if the constraint or the robot state changed
+            if(constraintNeedsUpdate(constraint, model_changed)){
+                WBC_PROFILE_SCOPE_DETAIL("AccelerationSceneTSID::constraintKinematics", constraints[level][i]->config.name.c_str());
+                if(type == cart){
+                    constraint = std::static_pointer_cast<CartesianAccelerationConstraint>(constraints[level][i]);
+
+                    // Task Jacobian
+                    constraint->A = model_cache.spaceJacobian(constraint->config.root, constraint->config.tip);
+
+                     // Desired task space acceleration: y_r = y_d - Jdot*qdot
+                    const base::samples::Joints& joint_state = model_cache.jointState();
+                    q_dot.resize(robot_model->noOfJoints());
+                    for(size_t j = 0; j < joint_state.size(); j++)
+                        q_dot(j) = joint_state[j].speed;
+                    constraint->y_ref = constraint->y_ref - model_cache.spatialAccelerationBias(constraint->config.root, constraint->config.tip);
+
+                    // Convert input acceleration from the reference frame of the constraint to the base frame of the robot. We transform only the orientation of the
+                    // reference frame to which the twist is expressed, NOT the position. This means that the center of rotation for a Cartesian constraint will
+                    // be the origin of ref frame, not the root frame. This is more intuitive when controlling the orientation of e.g. a robot' s end effector.
+                    base::samples::RigidBodyStateSE3 ref_frame = model_cache.rigidBodyState(constraint->config.root, constraint->config.ref_frame);
+                    constraint->y_ref_root.segment(0,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->y_ref.segment(0,3);
+                    constraint->y_ref_root.segment(3,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->y_ref.segment(3,3);
+
+                    // Also convert the weight vector from ref frame to the root frame. Take the absolute values after rotation, since weights can only
+                    // assume positive values
+                    constraint->weights_root.segment(0,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->weights.segment(0,3);
+                    constraint->weights_root.segment(3,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->weights.segment(3,3);
+                    constraint->weights_root = constraint->weights_root.cwiseAbs();
+                }
+                else if(type == jnt){
+                    constraint = std::static_pointer_cast<JointAccelerationConstraint>(constraints[level][i]);
+
+                    // Joint space constraints: The constraint matrix is a selection matrix, which has been initialized from the joint indices in configure()
+                    constraint->y_ref_root = constraint->y_ref;     // In joint space y_ref is equal to y_ref_root
+                    constraint->weights_root = constraint->weights; // Same for the weights
+
+                }
+                else if(type == com){
+                    constraint = std::static_pointer_cast<CoMAccelerationConstraint>(constraints[level][i]);
+
+                    // CoM constraints are always expressed in the base frame of the robot. Desired CoM acceleration: y_r = y_d - Jcom_dot*qdot
+                    constraint->A = model_cache.comJacobian();
+                    constraint->y_ref_root = constraint->y_ref - model_cache.comAccelerationBias();
+                    constraint->weights_root = constraint->weights;
+                }
+                else{
+                    LOG_ERROR("Constraint %s: Invalid type: %i", constraints[level][i]->config.name.c_str(), type);
+                    throw std::invalid_argument("Invalid constraint configuration");
+                }
+            }
 
-        // If the activation value is zero, also set reference to zero. Activation is usually used to switch between different
-        // task phases and we don't want to store the "old" reference value, in case we switch on the constraint again
-        if(constraint->activation == 0){
-           constraint->y_ref.setZero();
-           constraint->y_ref_root.setZero();
+            // Joint space constraints only add to the diagonal of the Hessian, all others are added via rank updates on their non-zero columns
+            row_weights = constraint->weights_root * constraint->activation * level_weight;
+            if(type == jnt)
+                hessian_assembler.addSelector(std::static_pointer_cast<JointConstraint>(constraint)->joint_idx, row_weights, col_weights, constraint->y_ref_root, constraint->Aw);
+            else
+                hessian_assembler.addConstraint(constraint->A, row_weights, col_weights, constraint->y_ref_root, constraint->Aw);
         }
+    } // priorities
 
-        for(int i = 0; i < constraint->A.rows(); i++)
-            constraint->Aw.row(i) = constraint->weights_root(i) * constraint->A.row(i) * constraint->activation * (!constraint->timeout);
-        for(int i = 0; i < constraint->A.cols(); i++)
-            constraint->Aw.col(i) = joint_weights[i] * constraint->Aw.col(i);
-
-        constraints_prio[prio].H.block(0,0,nj,nj) += constraint->Aw.transpose()*constraint->Aw;
-        constraints_prio[prio].g.segment(0,nj) -= constraint->Aw.transpose()*constraint->y_ref_root;
-    }
-
-    constraints_prio[prio].H.block(0,0,nj,nj).diagonal().array() += hessian_regularizer;
+    hessian_assembler.addDiagonal(hessian_regularizer);
+    hessian_assembler.get(constraints_prio[prio].H, constraints_prio[prio].g);
 
 
     ///////// Constraints
 
-    constraints_prio[prio].A.setZero();
-    constraints_prio[prio].lower_y.setZero();
-    constraints_prio[prio].upper_y.setZero();
-
-
-    // 1. M*qdd - S^T*tau - Jb_1^T*f_ext_1 - Jb_2^T*f_ext_2 - ... = -h (Rigid Body Dynamic Equation)
-
-    ActiveContacts contact_points = robot_model->getActiveContacts();
-    constraints_prio[prio].A.block(0,  0, nj, nj) =  robot_model->jointSpaceInertiaMatrix();
-    constraints_prio[prio].A.block(0, nj, nj, na) = -robot_model->selectionMatrix().transpose();
-    for(int i = 0; i < contact_points.size(); i++)
-        constraints_prio[prio].A.block(0, nj+na+i*6, nj, 6) = -robot_model->bodyJacobian(robot_model->baseFrame(), contact_points.names[i]).transpose();
-    constraints_prio[prio].lower_y.segment(0,nj) = constraints_prio[prio].upper_y.segment(0,nj) = -robot_model->biasForces();// + robot_model->bodyJacobian(world_link, contact_link).transpose() * f_ext;
-
-    // 2. For all contacts: Js*qdd = -Jsdot*qd (Rigid Contacts, contact points do not move!)
+    // Rigid body dynamics and contact constraints depend only on the robot state. Skip them if the state did not change since the last update
+    if(model_changed || resized){
+        WBC_PROFILE_SCOPE("AccelerationSceneTSID::contactConstraints");
+        constraints_prio[prio].A.setZero();
+        constraints_prio[prio].lower_y.setZero();
+        constraints_prio[prio].upper_y.setZero();
+
+        // 1. M*qdd - S^T*tau - Jb_1^T*f_ext_1 - Jb_2^T*f_ext_2 - ... = -h (Rigid Body Dynamic Equation)
+
+        ActiveContacts contact_points = robot_model->getActiveContacts();
+        constraints_prio[prio].A.block(0,  0, nj, nj) =  model_cache.jointSpaceInertiaMatrix();
+        constraints_prio[prio].A.block(0, nj, nj, na) = -robot_model->selectionMatrix().transpose();
+        for(int i = 0; i < contact_points.size(); i++)
+            constraints_prio[prio].A.block(0, nj+na+i*6, nj, 6) = -model_cache.bodyJacobian(robot_model->baseFrame(), contact_points.names[i]).transpose();
+        constraints_prio[prio].lower_y.segment(0,nj) = constraints_prio[prio].upper_y.segment(0,nj) = -model_cache.biasForces();// + robot_model->bodyJacobian(world_link, contact_link).transpose() * f_ext;
+
+        // 2. For all contacts: Js*qdd = -Jsdot*qd (Rigid Contacts, contact points do not move!)
+
+        for(int i = 0; i < contact_points.size(); i++){
+            constraints_prio[prio].A.block(nj+i*6,  0, 6, nj) = model_cache.spaceJacobian(robot_model->baseFrame(), contact_points.names[i]);
+            base::Vector6d acc;
+            base::Acceleration a = model_cache.spatialAccelerationBias(robot_model->baseFrame(), contact_points.names[i]);
+            acc.segment(0,3) = a.linear;
+            acc.segment(3,3) = a.angular;
+            constraints_prio[prio].lower_y.segment(nj+i*6,6) = constraints_prio[prio].upper_y.segment(nj+i*6,6) = -acc;
+        }
+    }
 
-    for(int i = 0; i < contact_points.size(); i++){
-        constraints_prio[prio].A.block(nj+i*6,  0, 6, nj) = robot_model->spaceJacobian(robot_model->baseFrame(), contact_points.names[i]);
-        base::Vector6d acc;
-        base::Acceleration a = robot_model->spatialAccelerationBias(robot_model->baseFrame(), contact_points.names[i]);
-        acc.segment(0,3) = a.linear;
-        acc.segment(3,3) = a.angular;
-        constraints_prio[prio].lower_y.segment(nj+i*6,6) = constraints_prio[prio].upper_y.segment(nj+i*6,6) = -acc;
+    // 3. Contact wrench constraints: Friction pyramid, unilateral contact and center of pressure. These depend only on the contact parameters
+
+    if(use_contact_constraints && (model_changed || resized || contact_params_changed)){
+        WBC_PROFILE_SCOPE("AccelerationSceneTSID::contactWrenchConstraints");
+        const ActiveContacts& contact_points = robot_model->getActiveContacts();
+        constraints_prio[prio].A.bottomRows(n_contact_rows).setZero();
+        uint row = nj+ncp*6;
+        for(uint i = 0; i < ncp; i++){
+            if(contact_points[i] == 0)
+                continue;
+            const ContactParams& params = getContactParams(contact_points.names[i]);
+            setContactWrenchConstraints(params, row, nj+na+i*6, constraints_prio[prio]);
+            row += params.noOfRows();
+        }
     }
+    contact_params_changed = false;
 
-    // 3. Torque and acceleration limits
+    // 4. Torque and acceleration limits. These are constant
 
-    constraints_prio[prio].upper_x.setConstant(10000);
-    constraints_prio[prio].lower_x.setConstant(-10000);
-    for(int i = 0; i < robot_model->noOfActuatedJoints(); i++){
-        const std::string& name = robot_model->actuatedJointNames()[i];
-        constraints_prio[prio].lower_x(i+nj) = robot_model->jointLimits()[name].min.effort;
-        constraints_prio[prio].upper_x(i+nj) = robot_model->jointLimits()[name].max.effort;
+    if(resized || full_update_required){
+        constraints_prio[prio].upper_x.setConstant(10000);
+        constraints_prio[prio].lower_x.setConstant(-10000);
+        for(int i = 0; i < robot_model->noOfActuatedJoints(); i++){
+            const std::string& name = robot_model->actuatedJointNames()[i];
+            constraints_prio[prio].lower_x(i+nj) = robot_model->jointLimits()[name].min.effort;
+            constraints_prio[prio].upper_x(i+nj) = robot_model->jointLimits()[name].max.effort;
+        }
     }
 
     constraints_prio.Wq = base::VectorXd::Map(joint_weights.elements.data(), robot_model->noOfJoints());
     constraints_prio.time = base::Time::now(); //  TODO: Use latest time stamp from all constraints!?
+    clearChanges();
     return constraints_prio;
 }
 
 const base::commands::Joints& AccelerationSceneTSID::solve(const HierarchicalQP& hqp){
 
     // solve
+    WBC_PROFILE_SCOPE("AccelerationSceneTSID::solve");
     solver_output.resize(hqp[0].nq);
-    solver->solve(hqp, solver_output);
+    solver_status = solver->trySolve(solverInput(hqp), solver_output);
+    if(solver_status == solver_failed)
+        throw std::runtime_error("AccelerationSceneTSID::solve: Solver failed to solve the QP: " + solver->getFailureReason());
 
     // Convert solver output: Acceleration and torque
+    WBC_PROFILE_SCOPE("AccelerationSceneTSID::convertOutput");
     uint nj = robot_model->noOfJoints();
     uint na = robot_model->noOfActuatedJoints();
     solver_output_joints.resize(robot_model->noOfActuatedJoints());
@@ -197,7 +353,7 @@ const ConstraintsStatus& AccelerationSceneTSID::updateConstraintsStatus(){
 
     uint nj = robot_model->noOfJoints();
     solver_output_acc = solver_output.segment(0,nj);
-    const base::samples::Joints& joint_state = robot_model->jointState(robot_model->jointNames());
+    const base::samples::Joints& joint_state = model_cache.jointState();
     robot_acc.resize(nj);
     for(size_t i = 0; i < nj; i++)
         robot_acc(i) = joint_state[i].acceleration;
@@ -214,8 +370,14 @@ const ConstraintsStatus& AccelerationSceneTSID::updateConstraintsStatus(){
             constraints_status[name].weights    = constraint->weights;
             constraints_status[name].y_ref      = constraint->y_ref_root;
             if(constraint->config.type == cart){
-                const base::MatrixXd &jac = robot_model->spaceJacobian(constraint->config.root, constraint->config.tip);
-                const base::Acceleration &bias_acc = robot_model->spatialAccelerationBias(constraint->config.root, constraint->config.tip);
+                const base::MatrixXd &jac = model_cache.spaceJacobian(constraint->config.root, constraint->config.tip);
+                const base::Acceleration &bias_acc = model_cache.spatialAccelerationBias(constraint->config.root, constraint->config.tip);
+                constraints_status[name].y_solution = jac * solver_output_acc + bias_acc;
+                constraints_status[name].y          = jac * robot_acc + bias_acc;
+            }
+            else if(constraint->config.type == com){
+                const base::MatrixXd &jac = model_cache.comJacobian();
+                const base::Vector3d &bias_acc = model_cache.comAccelerationBias();
                 constraints_status[name].y_solution = jac * solver_output_acc + bias_acc;
                 constraints_status[name].y          = jac * robot_acc + bias_acc;
             }
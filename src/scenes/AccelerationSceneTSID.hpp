@@ -4,12 +4,38 @@
 #include "../core/Scene.hpp"
 #include "../core/JointAccelerationConstraint.hpp"
 #include "../core/CartesianAccelerationConstraint.hpp"
+#include "../core/CoMAccelerationConstraint.hpp"
+#include "../core/HessianAssembler.hpp"
 #include <base/samples/Wrenches.hpp>
+#include <map>
 
 namespace wbc{
 
 typedef std::shared_ptr<CartesianAccelerationConstraint> CartesianAccelerationConstraintPtr;
 typedef std::shared_ptr<JointAccelerationConstraint> JointAccelerationConstraintPtr;
+
+/**
+ * @brief Parameters of the contact wrench constraints of a single contact, see AccelerationSceneTSID::setUseContactConstraints(). All quantities refer to the contact
+ *  frame, whose z-axis is the contact normal, pointing away from the environment.
+ */
+struct ContactParams{
+    ContactParams() :
+        mu(0.6),
+        n_facets(4),
+        min_normal_force(0),
+        cop_min(-0.05,-0.05),
+        cop_max(0.05,0.05){
+    }
+    double mu;               /** Friction coefficient. Has to be > 0. Default is 0.6*/
+    uint n_facets;           /** Number of facets of the linearized friction pyramid, which is inscribed in the friction cone. Has to be >= 3. Default is 4*/
+    double min_normal_force; /** Lower bound of the normal force (unilateral contact). Has to be >= 0, since the CoP constraints assume a non-negative normal force. Default is 0*/
+    base::Vector2d cop_min;  /** Lower bound of the center of pressure (x,y) in the contact frame, i.e. the support polygon. Default is (-0.05,-0.05)*/
+    base::Vector2d cop_max;  /** Upper bound of the center of pressure (x,y) in the contact frame. Default is (0.05,0.05)*/
+
+    /** Number of inequality rows of the contact: One per pyramid facet, one for the normal force and four for the center of pressure*/
+    uint noOfRows() const {return n_facets + 5;}
+};
+
 /**
  * @brief Acceleration-based implementation of the WBC Scene. It sets up and solves the following problem:
  *  \f[
@@ -19,6 +45,7 @@ typedef std::shared_ptr<JointAccelerationConstraint> JointAccelerationConstraint
  *           s.t.  & \mathbf{H}\mathbf{\ddot{q}} - \mathbf{S}^T\mathbf{\tau} - \mathbf{J}_c^T\mathbf{f} = -\mathbf{h} & \\
  *                 & \mathbf{J}_{c,i}\mathbf{\ddot{q}} = -\dot{\mathbf{J}}_{c,i}\dot{\mathbf{q}}, \, \forall i& \\
  *                 & \mathbf{\tau}_m \leq \mathbf{\tau} \leq \mathbf{\tau}_M& \\
+ *                 & \mathbf{C}_i\mathbf{f}_i \leq \mathbf{c}_i, \, \forall i \quad \textrm{(optional)}& \\
  *        \end{array}
  *  \f]
  * \f$\ddot{\mathbf{q}}\f$ - Vector of robot joint accelerations<br>
@@ -34,11 +61,12 @@ typedef std::shared_ptr<JointAccelerationConstraint> JointAccelerationConstraint
  * \f$\mathbf{J}_{c,i}\f$ - Contact Jacobian of i-th contact point<br>
  * \f$\dot{\mathbf{J}}\dot{\mathbf{q}}\f$ - Acceleration bias<br>
  * \f$\mathbf{\tau}_m,\mathbf{\tau}_M\f$ - Joint force/torque limits<br>
+ * \f$\mathbf{C}_i,\mathbf{c}_i\f$ - Linearized friction pyramid, unilateral normal force and center of pressure bounds of the i-th active contact, see ContactParams<br>
  *
  * The implementation is close to the task-space-inverse dynamics (TSID) method: https://andreadelprete.github.io/teaching/tsid/1_tsid_theory.pdf.
  * It computes the required joint space accelerations \f$\ddot{\mathbf{q}}\f$, torques \f$\mathbf{\tau}\f$ and contact wrenches \f$\mathbf{f}\f$, required to achieve the given task space
- * accelerations \f$\mathbf{v}_{d}\f$ under consideration of the equations of motion (eom), rigid contacts and joint force/torque limits. Note that onyl a single hierarchy level is allowed here,
- * prioritization can be achieved by assigning suitable task weights \f$\mathbf{W}\f$.
+ * accelerations \f$\mathbf{v}_{d}\f$ under consideration of the equations of motion (eom), rigid contacts and joint force/torque limits. Tasks on different priorities are combined in a single cost function,
+ * where the weights \f$\mathbf{W}\f$ of lower priorities are scaled down (soft hierarchy, see setPriorityWeightRatio()). Additionally, prioritization can be achieved by assigning suitable task weights.
  */
 class AccelerationSceneTSID : public WbcScene{
 protected:
@@ -47,6 +75,19 @@ protected:
     base::VectorXd solver_output, robot_acc, solver_output_acc;
     base::samples::Wrenches contact_wrenches;
     double hessian_regularizer;
+    double priority_weight_ratio;
+    HessianAssembler hessian_assembler;
+    base::VectorXd row_weights, col_weights;
+    bool use_contact_constraints;
+    bool contact_params_changed;
+    ContactParams default_contact_params;
+    std::map<std::string, ContactParams> contact_params;
+
+    /** Throw if the given contact parameters are invalid*/
+    void checkContactParams(const ContactParams& params);
+
+    /** Write the contact wrench constraints of one contact to the given rows of the QP. col is the index of the first wrench variable of the contact*/
+    void setContactWrenchConstraints(const ContactParams& params, uint row, uint col, QuadraticProgram& qp);
 
     /**
      * brief Create a constraint and add it to the WBC scene
@@ -91,6 +132,47 @@ public:
      * @brief Return the current value of hessian regularizer
      */
     double getHessianRegularizer(){return hessian_regularizer;}
+
+    /**
+     * @brief Set the weight ratio between two consecutive priorities. All priorities are mapped to a single level of the QP (soft hierarchy), where the weights of
+     *  the cost of the constraints on priority p is multiplied with ratio^(-p). Thus, priority 0 keeps the configured weights and has the highest weight. The spread of
+     *  the Hessian grows with ratio^(n-1), n being the number of priorities, so a large ratio approximates a strict hierarchy, but deteriorates the conditioning of the QP.
+     *  Has no effect if there is only one priority. Default is 100
+     */
+    void setPriorityWeightRatio(const double ratio);
+
+    /**
+     * @brief Return the weight ratio between two consecutive priorities
+     */
+    double getPriorityWeightRatio(){return priority_weight_ratio;}
+
+    /**
+     * @brief Enable/disable the contact wrench constraints: For each active contact (value 1 in RobotModel::getActiveContacts()), the contact wrench, expressed in the contact frame,
+     *  is constrained by a linearized friction pyramid, a lower bound on the normal force and bounds on the center of pressure (see ContactParams). The constraints are added as
+     *  sparse inequality rows, which only affect the wrench variables of the contact. Inactive contacts get no such rows. Default is false, i.e. the contact wrenches are only bounded
+     *  by the variable bounds
+     */
+    void setUseContactConstraints(const bool use);
+
+    /**
+     * @brief Return true if the contact wrench constraints are enabled
+     */
+    bool getUseContactConstraints(){return use_contact_constraints;}
+
+    /**
+     * @brief Set the contact parameters of all contacts, which do not have individual parameters
+     */
+    void setContactParams(const ContactParams& params);
+
+    /**
+     * @brief Set the contact parameters of the given contact
+     */
+    void setContactParams(const std::string& contact_name, const ContactParams& params);
+
+    /**
+     * @brief Return the contact parameters of the given contact, i.e. its individual parameters if set, otherwise the parameters for all contacts
+     */
+    const ContactParams& getContactParams(const std::string& contact_name);
 };
 
 } // namespace wbc
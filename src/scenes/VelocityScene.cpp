@@ -1,8 +1,10 @@
 #include "VelocityScene.hpp"
 #include "../core/RobotModel.hpp"
 #include <base-logging/Logging.hpp>
+#include "../core/Profiler.hpp"
 #include "../core/JointVelocityConstraint.hpp"
 #include "../core/CartesianVelocityConstraint.hpp"
+#include "../core/CoMVelocityConstraint.hpp"
 
 namespace wbc{
 
@@ -12,6 +14,8 @@ ConstraintPtr VelocityScene::createConstraint(const ConstraintConfig &config){
         return std::make_shared<CartesianVelocityConstraint>(config, robot_model->noOfJoints());
     else if(config.type == jnt)
         return std::make_shared<JointVelocityConstraint>(config, robot_model->noOfJoints());
+    else if(config.type == com)
+        return std::make_shared<CoMVelocityConstraint>(config, robot_model->noOfJoints());
     else{
         LOG_ERROR("Constraint with name %s has an invalid constraint type: %i", config.name.c_str(), config.type);
         throw std::invalid_argument("Invalid constraint config");
@@ -20,6 +24,8 @@ ConstraintPtr VelocityScene::createConstraint(const ConstraintConfig &config){
 
 const HierarchicalQP& VelocityScene::update(){
 
+    WBC_PROFILE_SCOPE("VelocityScene::update");
+
     if(!configured)
         throw std::runtime_error("VelocityScene has not been configured!. PLease call configure() before calling update() for the first time!");
 
@@ -30,9 +36,33 @@ const HierarchicalQP& VelocityScene::update(){
     //    A - Vector of constraint matrices. One matrix for each priority
     //    y - Vector of constraint velocities. One vector for each priority
     //    W - Vector of constraint weights. One vector for each priority
+    //    Only the blocks of constraints whose reference, weights, activation or timeout changed are rewritten. Cartesian and CoM constraints
+    //    are additionally rewritten whenever the robot state changed.
+    fetchInputs();
+    const bool model_changed = robotModelChanged();
+    n_skipped_constraints = 0;
     for(uint prio = 0; prio < constraints.size(); prio++){
 
-        constraints_prio[prio].resize(n_constraint_variables_per_prio[prio], robot_model->noOfJoints());
+        const bool resized = constraints_prio[prio].resizeIfRequired(n_constraint_variables_per_prio[prio], robot_model->noOfJoints());
+        if(resized || full_update_required){
+            constraints_prio[prio].H.setIdentity();
+            constraints_prio[prio].g.setZero();
+            if(use_joint_limits){
+                // Joint velocity limits are constant. Joints that are not actuated, e.g. the floating base, get the same large bound as in VelocitySceneQuadraticCost
+                constraints_prio[prio].lower_x.setConstant(robot_model->noOfJoints(), -1000);
+                constraints_prio[prio].upper_x.setConstant(robot_model->noOfJoints(), 1000);
+                for(auto n : robot_model->actuatedJointNames()){
+                    size_t idx = robot_model->jointIndex(n);
+                    const base::JointLimitRange &range = robot_model->jointLimits().getElementByName(n);
+                    constraints_prio[prio].lower_x(idx) = range.min.speed;
+                    constraints_prio[prio].upper_x(idx) = range.max.speed;
+                }
+            }
+            else{
+                constraints_prio[prio].lower_x.resize(0);
+                constraints_prio[prio].upper_x.resize(0);
+            }
+        }
 
         // Walk through all tasks of current priority
         uint row_index = 0;
@@ -42,18 +72,37 @@ const HierarchicalQP& VelocityScene::update(){
             int type = constraints[prio][i]->config.type;
             uint n_vars = constraints[prio][i]->config.nVariables();
 
+            // Inactive constraints keep their rows in the QP, but these are set to zero. All kinematics computations are skipped
+            if(isInactive(constraints[prio][i])){
+                skipConstraint(constraints[prio][i]);
+                if(resized || constraintNeedsUpdate(constraints[prio][i], model_changed)){
+                    constraints_prio[prio].Wy.segment(row_index, n_vars).setZero();
+                    constraints_prio[prio].A.block(row_index, 0, n_vars, robot_model->noOfJoints()).setZero();
+                    constraints_prio[prio].lower_y.segment(row_index, n_vars).setZero();
+                    constraints_prio[prio].upper_y.segment(row_index, n_vars).setZero();
+                }
+                row_index += n_vars;
+                continue;
+            }
+
+            if(!resized && !constraintNeedsUpdate(constraints[prio][i], model_changed)){
+                row_index += n_vars;
+                continue;
+            }
+
+            WBC_PROFILE_SCOPE_DETAIL("VelocityScene::constraint", constraints[prio][i]->config.name.c_str());
             if(type == cart){
 
                 CartesianVelocityConstraintPtr constraint = std::static_pointer_cast<CartesianVelocityConstraint>(constraints[prio][i]);
 
                 // Constraint Jacobian
-                constraint->A = robot_model->spaceJacobian(constraint->config.root, constraint->config.tip);
+                constraint->A = model_cache.spaceJacobian(constraint->config.root, constraint->config.tip);
 
                 // Constraint reference
                 // Convert input twist from the reference frame of the constraint to the base frame of the robot. We transform only the orientation of the
                 // reference frame to which the twist is expressed, NOT the position. This means that the center of rotation for a Cartesian constraint will
                 // be the origin of ref frame, not the root frame. This is more intuitive when controlling the orientation of e.g. a robot' s end effector.
-                ref_frame = robot_model->rigidBodyState(constraint->config.root, constraint->config.ref_frame);
+                ref_frame = model_cache.rigidBodyState(constraint->config.root, constraint->config.ref_frame);
                 constraint->y_ref_root.segment(0,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->y_ref.segment(0,3);
                 constraint->y_ref_root.segment(3,3) = ref_frame.pose.orientation.toRotationMatrix() * constraint->y_ref.segment(3,3);
 
@@ -67,15 +116,18 @@ const HierarchicalQP& VelocityScene::update(){
 
                 JointVelocityConstraintPtr constraint = std::static_pointer_cast<JointVelocityConstraint>(constraints[prio][i]);
 
-                // Joint space constraints: constraint matrix has only ones and Zeros. The joint order in the constraints might be different than in the robot model.
-                // Thus, for joint space constraints, the joint indices have to be mapped correctly.
-                for(uint k = 0; k < constraint->config.joint_names.size(); k++){
+                // Joint space constraints: The constraint matrix is a selection matrix, which has been initialized from the joint indices in configure()
+                constraint->y_ref_root = constraint->y_ref;     // In joint space y_ref is equal to y_ref_root
+                constraint->weights_root = constraint->weights; // Same of the weights
+            }
+            else if(type == com){
 
-                    int idx = robot_model->jointIndex(constraint->config.joint_names[k]);
-                    constraint->A(k,idx) = 1.0;
-                    constraint->y_ref_root = constraint->y_ref;     // In joint space y_ref is equal to y_ref_root
-                    constraint->weights_root = constraint->weights; // Same of the weights
-                }
+                CoMVelocityConstraintPtr constraint = std::static_pointer_cast<CoMVelocityConstraint>(constraints[prio][i]);
+
+                // CoM constraints are always expressed in the base frame of the robot, so no transformation is required
+                constraint->A = model_cache.comJacobian();
+                constraint->y_ref_root = constraint->y_ref;
+                constraint->weights_root = constraint->weights;
             }
             else{
                 LOG_ERROR("Constraint %s: Invalid type: %i", constraints[prio][i]->config.name.c_str(), type);
@@ -84,28 +136,25 @@ const HierarchicalQP& VelocityScene::update(){
 
             ConstraintPtr constraint = constraints[prio][i];
 
-            // If the activation value is zero, also set reference to zero. Activation is usually used to switch between different
-            // task phases and we don't want to store the "old" reference value, in case we switch on the constraint again
-            if(constraint->activation == 0){
-               constraint->y_ref.setZero();
-               constraint->y_ref_root.setZero();
+            // Insert constraints into equation system of current priority at the correct position
+            constraints_prio[prio].Wy.segment(row_index, n_vars) = constraint->weights_root * constraint->activation;
+            if(type == jnt){
+                // Scatter the selection matrix instead of copying the dense constraint matrix
+                const std::vector<int>& joint_idx = std::static_pointer_cast<JointConstraint>(constraint)->joint_idx;
+                constraints_prio[prio].A.block(row_index, 0, n_vars, robot_model->noOfJoints()).setZero();
+                for(uint k = 0; k < n_vars; k++)
+                    constraints_prio[prio].A(row_index+k, joint_idx[k]) = 1.0;
             }
-
-            // Insert constraints into equation system of current priority at the correct position. Note: Weights will be zero if activations
-            // for this constraint is zero or if the constraint is in timeout
-            constraints_prio[prio].Wy.segment(row_index, n_vars) = constraint->weights_root * constraint->activation * (!constraint->timeout);
-            constraints_prio[prio].A.block(row_index, 0, n_vars, robot_model->noOfJoints()) = constraint->A;
+            else
+                constraints_prio[prio].A.block(row_index, 0, n_vars, robot_model->noOfJoints()) = constraint->A;
             constraints_prio[prio].lower_y.segment(row_index, n_vars) = constraint->y_ref_root;
             constraints_prio[prio].upper_y.segment(row_index, n_vars) = constraint->y_ref_root;
-            constraints_prio[prio].H.setIdentity();
-            constraints_prio[prio].lower_x.resize(0);
-            constraints_prio[prio].upper_x.resize(0);
-            constraints_prio[prio].g.setZero();
 
             row_index += n_vars;
 
         } // constraints on prio
     } // priorities
+    clearChanges();
 
     constraints_prio.time = base::Time::now(); //  TODO: Use latest time stamp from all constraints!?
 
@@ -117,10 +166,18 @@ const HierarchicalQP& VelocityScene::update(){
 const base::commands::Joints& VelocityScene::solve(const HierarchicalQP& hqp){
 
     // solve
+    WBC_PROFILE_SCOPE("VelocityScene::solve");
     solver_output.resize(hqp[0].nq);
-    solver->solve(hqp, solver_output);
+    solver_status = solver->trySolve(solverInput(hqp), solver_output);
+    if(solver_status == solver_failed)
+        throw std::runtime_error("VelocityScene::solve: Solver failed to solve the QP: " + solver->getFailureReason());
 
-    // Convert Output
+    return convertSolverOutput();
+}
+
+const base::commands::Joints& VelocityScene::convertSolverOutput(){
+
+    WBC_PROFILE_SCOPE("VelocityScene::convertOutput");
     solver_output_joints.resize(robot_model->noOfActuatedJoints());
     solver_output_joints.names = robot_model->actuatedJointNames();
     for(uint i = 0; i < robot_model->noOfActuatedJoints(); i++){
@@ -137,7 +194,7 @@ const ConstraintsStatus& VelocityScene::updateConstraintsStatus(){
 
     robot_vel.resize(robot_model->noOfJoints());
     uint nj = robot_model->noOfJoints();
-    const base::samples::Joints &joint_state = robot_model->jointState(robot_model->jointNames());
+    const base::samples::Joints &joint_state = model_cache.jointState();
     for(size_t i = 0; i < nj; i++)
         robot_vel(i) = joint_state[i].speed;
 
@@ -152,8 +209,21 @@ const ConstraintsStatus& VelocityScene::updateConstraintsStatus(){
             constraints_status[name].timeout    = constraint->timeout;
             constraints_status[name].weights    = constraint->weights;
             constraints_status[name].y_ref      = constraint->y_ref;
-            constraints_status[name].y_solution = constraint->A * solver_output;
-            constraints_status[name].y          = constraint->A * robot_vel;
+            // Query the Jacobians from the model cache, since constraint->A is not updated for inactive constraints
+            if(constraint->config.type == cart){
+                const base::MatrixXd &jac = model_cache.spaceJacobian(constraint->config.root, constraint->config.tip);
+                constraints_status[name].y_solution = jac * solver_output;
+                constraints_status[name].y          = jac * robot_vel;
+            }
+            else if(constraint->config.type == com){
+                const base::MatrixXd &jac = model_cache.comJacobian();
+                constraints_status[name].y_solution = jac * solver_output;
+                constraints_status[name].y          = jac * robot_vel;
+            }
+            else{
+                constraints_status[name].y_solution = constraint->A * solver_output;
+                constraints_status[name].y          = constraint->A * robot_vel;
+            }
         }
     }
 
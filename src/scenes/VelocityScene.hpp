@@ -21,21 +21,29 @@ namespace wbc{
  * \f$\mathbf{W}\f$ - Diagonal task weight matrix<br>
  *
  * The tasks are all modeled as linear equality constraints to the above optimization problem. The task hierarchies are kept, i.e., multiple priorities are possible, depending on the solver.
+ * Optionally, the joint velocity limits of the robot can be passed to the solver as bounds on all priorities, see setUseJointLimits().
  */
 class VelocityScene : public WbcScene{
 protected:
     base::VectorXd solver_output, robot_vel;
     bool compute_id;
+    bool use_joint_limits;
 
     /**
      * @brief Create a constraint and add it to the WBC scene
      */
     virtual ConstraintPtr createConstraint(const ConstraintConfig &config);
 
+    /**
+     * @brief Convert the current solver output to a joint velocity command for the actuated joints
+     */
+    const base::commands::Joints& convertSolverOutput();
+
 public:
     VelocityScene(RobotModelPtr robot_model, QPSolverPtr solver) :
         WbcScene(robot_model, solver),
-        compute_id(false){
+        compute_id(false),
+        use_joint_limits(false){
     }
     virtual ~VelocityScene(){
     }
@@ -57,6 +65,15 @@ public:
      *  Both values can be used to evaluate the performance of WBC
      */
     virtual const ConstraintsStatus &updateConstraintsStatus();
+
+    /**
+     * @brief If true, the velocity limits of the actuated joints are written to lower_x/upper_x of all priorities, so that solvers which support joint bounds,
+     *  e.g. SNSSolver or QPOASESCascadeSolver, respect them. Solvers like HierarchicalLSSolver ignore the bounds. Default is false, i.e. no joint bounds
+     */
+    void setUseJointLimits(const bool use){use_joint_limits = use; full_update_required = true;}
+
+    /** @brief Return true if the joint velocity limits are passed to the solver*/
+    bool getUseJointLimits(){return use_joint_limits;}
 };
 
 } // namespace wbc
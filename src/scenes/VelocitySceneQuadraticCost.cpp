@@ -1,128 +1,239 @@
 #include "VelocitySceneQuadraticCost.hpp"
 #include <base/JointLimits.hpp>
 #include <base-logging/Logging.hpp>
+#include <cmath>
+#include "../core/Profiler.hpp"
 #include "../core/CartesianVelocityConstraint.hpp"
 #include "../core/JointVelocityConstraint.hpp"
+#include "../core/CoMVelocityConstraint.hpp"
 
 namespace wbc{
 
 VelocitySceneQuadraticCost::VelocitySceneQuadraticCost(RobotModelPtr robot_model, QPSolverPtr solver) :
     VelocityScene(robot_model, solver),
-    hessian_regularizer(1e-8){
+    hessian_regularizer(1e-8),
+    priority_weight_ratio(100),
+    use_box_qp_solver(true),
+    box_qp_solver_used(false),
+    default_contact_model(surface_contact),
+    contact_models_changed(false){
 
 }
 
 VelocitySceneQuadraticCost::~VelocitySceneQuadraticCost(){
 }
 
+void VelocitySceneQuadraticCost::setPriorityWeightRatio(const double ratio){
+    if(ratio <= 0){
+        LOG_ERROR("VelocitySceneQuadraticCost: Priority weight ratio has to be > 0, but is %f", ratio);
+        throw std::invalid_argument("Invalid priority weight ratio");
+    }
+    priority_weight_ratio = ratio;
+}
+
+uint VelocitySceneQuadraticCost::noOfContactRows(const ContactModel model){
+    switch(model){
+    case point_contact: return 3;
+    case line_contact: return 5;
+    case surface_contact: return 6;
+    default:
+        LOG_ERROR("VelocitySceneQuadraticCost: Invalid contact model: %i", model);
+        throw std::invalid_argument("Invalid contact model");
+    }
+}
+
+void VelocitySceneQuadraticCost::setContactModel(const ContactModel model){
+    noOfContactRows(model);
+    default_contact_model = model;
+    contact_models_changed = true;
+}
+
+void VelocitySceneQuadraticCost::setContactModel(const std::string& contact_name, const ContactModel model){
+    noOfContactRows(model);
+    contact_models[contact_name] = model;
+    contact_models_changed = true;
+}
+
+ContactModel VelocitySceneQuadraticCost::getContactModel(const std::string& contact_name){
+    auto it = contact_models.find(contact_name);
+    return it == contact_models.end() ? default_contact_model : it->second;
+}
+
 const HierarchicalQP& VelocitySceneQuadraticCost::update(){
 
+    WBC_PROFILE_SCOPE("VelocitySceneQuadraticCost::update");
+
     if(!configured)
         throw std::runtime_error("VelocitySceneQuadraticCost has not been configured!. PLease call configure() before calling update() for the first time!");
 
-    if(constraints.size() != 1){
-        LOG_ERROR("Number of priorities in VelocitySceneQuadraticCost should be 1, but is %i", constraints.size());
-        throw std::runtime_error("Invalid constraint configuration");
-    }
+    // All priorities are mapped to a single weighted level of the QP (soft hierarchy), see setPriorityWeightRatio()
+    if(constraints_prio.size() != 1)
+        constraints_prio.resize(1);
 
     int nj = robot_model->noOfJoints();
     const ActiveContacts& contact_points = robot_model->getActiveContacts();
     uint ncp = contact_points.size();
     uint prio = 0;
 
-    // QP Size: (NContacts*6 X NJoints)
-    constraints_prio[prio].resize(ncp*6,nj);
-    constraints_prio[prio].H.setZero();
-    constraints_prio[prio].g.setZero();
-
-    ///////// Tasks
-
-    for(uint i = 0; i < constraints[prio].size(); i++){
-
-        constraints[prio][i]->checkTimeout();
-        int type = constraints[prio][i]->config.type;
-
-        if(type == cart){
-
-            CartesianVelocityConstraintPtr constraint = std::static_pointer_cast<CartesianVelocityConstraint>(constraints[prio][i]);
+    // Only active contacts are constrained, each with the number of rows given by its contact model
+    uint nc = 0;
+    for(uint i = 0; i < ncp; i++){
+        if(contact_points[i] != 0)
+            nc += noOfContactRows(getContactModel(contact_points.names[i]));
+    }
 
-            // Constraint Jacobian
-            constraint->A = robot_model->spaceJacobian(constraint->config.root, constraint->config.tip);
+    // QP Size: (NContactRows X NJoints)
+    fetchInputs();
+    const bool model_changed = robotModelChanged();
+    const bool resized = constraints_prio[prio].resizeIfRequired(nc,nj);
+    hessian_assembler.reset(nj);
+    n_skipped_constraints = 0;
+    col_weights = base::VectorXd::Map(joint_weights.elements.data(), nj);
 
-            // Convert constraint twist to robot root
-            base::MatrixXd rot_mat = robot_model->rigidBodyState(constraint->config.root, constraint->config.ref_frame).pose.orientation.toRotationMatrix();
-            constraint->y_ref_root.segment(0,3) = rot_mat * constraint->y_ref.segment(0,3);
-            constraint->y_ref_root.segment(3,3) = rot_mat * constraint->y_ref.segment(3,3);
+    ///////// Tasks
 
-            // Also convert the weight vector from ref frame to the root frame. Take the absolute values after rotation, since weights can only
-            // assume positive values
-            constraint->weights_root.segment(0,3) = rot_mat * constraint->weights.segment(0,3);
-            constraint->weights_root.segment(3,3) = rot_mat * constraint->weights.segment(3,3);
-            constraint->weights_root = constraint->weights_root.cwiseAbs();
-        }
-        else if(type == jnt){
+    for(uint level = 0; level < constraints.size(); level++){
 
-            JointVelocityConstraintPtr constraint = std::static_pointer_cast<JointVelocityConstraint>(constraints[prio][i]);
+        // Lower priorities get exponentially smaller weights in the cost function, priority 0 keeps the configured weights. Since the row weights
+        // enter the Hessian quadratically, the square root of the cost weight is applied to the rows
+        const double level_weight = pow(priority_weight_ratio, -0.5*level);
+        for(uint i = 0; i < constraints[level].size(); i++){
 
-            // Joint space constraints: constraint matrix has only ones and Zeros. The joint order in the constraints might be different than in the robot model.
-            // Thus, for joint space constraints, the joint indices have to be mapped correctly.
-            for(uint k = 0; k < constraint->config.joint_names.size(); k++){
+            constraints[level][i]->checkTimeout();
+            int type = constraints[level][i]->config.type;
 
-                int idx = robot_model->jointIndex(constraint->config.joint_names[k]);
-                constraint->A(k,idx) = 1.0;
-                constraint->y_ref_root = constraint->y_ref;     // In joint space y_ref is equal to y_ref_root
-                constraint->weights_root = constraint->weights; // Same of the weights
+            // Inactive constraints do not contribute to the cost function. Skip them, including all kinematics computations
+            if(isInactive(constraints[level][i])){
+                skipConstraint(constraints[level][i]);
+                continue;
             }
-        }
-        else{
-            LOG_ERROR("Constraint %s: Invalid type: %i", constraints[prio][i]->config.name.c_str(), type);
-            throw std::invalid_argument("Invalid constraint configuration");
-        }
 
-        ConstraintPtr constraint = constraints[prio][i];
-
-        // If the activation value is zero, also set reference to zero. Activation is usually used to switch between different
-        // task phases and we don't want to store the "old" reference value, in case we switch on the constraint again
-        if(constraint->activation == 0){
-           constraint->y_ref.setZero();
-           constraint->y_ref_root.setZero();
-        }
+            // Kinematic quantities of a constraint only have to be recomputed if the constraint or the robot state changed
+            if(constraintNeedsUpdate(constraints[level][i], model_changed)){
+                WBC_PROFILE_SCOPE_DETAIL("VelocitySceneQuadraticCost::constraintKinematics", constraints[level][i]->config.name.c_str());
+                if(type == cart){
+
+                    CartesianVelocityConstraintPtr constraint = std::static_pointer_cast<CartesianVelocityConstraint>(constraints[level][i]);
+
+                    // Constraint Jacobian
+                    constraint->A = model_cache.spaceJacobian(constraint->config.root, constraint->config.tip);
+
+                    // Convert constraint twist to robot root
+                    base::MatrixXd rot_mat = model_cache.rigidBodyState(constraint->config.root, constraint->config.ref_frame).pose.orientation.toRotationMatrix();
+                    constraint->y_ref_root.segment(0,3) = rot_mat * constraint->y_ref.segment(0,3);
+                    constraint->y_ref_root.segment(3,3) = rot_mat * constraint->y_ref.segment(3,3);
+
+                    // Also convert the weight vector from ref frame to the root frame. Take the absolute values after rotation, since weights can only
+                    // assume positive values
+                    constraint->weights_root.segment(0,3) = rot_mat * constraint->weights.segment(0,3);
+                    constraint->weights_root.segment(3,3) = rot_mat * constraint->weights.segment(3,3);
+                    constraint->weights_root = constraint->weights_root.cwiseAbs();
+                }
+                else if(type == jnt){
+
+                    JointVelocityConstraintPtr constraint = std::static_pointer_cast<JointVelocityConstraint>(constraints[level][i]);
+
+                    // Joint space constraints: The constraint matrix is a selection matrix, which has been initialized from the joint indices in configure()
+                    constraint->y_ref_root = constraint->y_ref;     // In joint space y_ref is equal to y_ref_root
+                    constraint->weights_root = constraint->weights; // Same of the weights
+                }
+                else if(type == com){
+
+                    CoMVelocityConstraintPtr constraint = std::static_pointer_cast<CoMVelocityConstraint>(constraints[level][i]);
+
+                    // CoM constraints are always expressed in the base frame of the robot, so no transformation is required
+                    constraint->A = model_cache.comJacobian();
+                    constraint->y_ref_root = constraint->y_ref;
+                    constraint->weights_root = constraint->weights;
+                }
+                else{
+                    LOG_ERROR("Constraint %s: Invalid type: %i", constraints[level][i]->config.name.c_str(), type);
+                    throw std::invalid_argument("Invalid constraint configuration");
+                }
+            }
 
-        for(int i = 0; i < constraint->A.rows(); i++)
-            constraint->Aw.row(i) = constraint->weights_root(i) * constraint->A.row(i) * constraint->activation * (!constraint->timeout);
-        for(int i = 0; i < constraint->A.cols(); i++)
-            constraint->Aw.col(i) = joint_weights[i] * constraint->Aw.col(i);
+            ConstraintPtr constraint = constraints[level][i];
 
-        constraints_prio[prio].H.block(0,0,nj,nj) += constraint->Aw.transpose()*constraint->Aw;
-        constraints_prio[prio].g.segment(0,nj) -= constraint->Aw.transpose()*constraint->y_ref_root;
+            // Joint space constraints only add to the diagonal of the Hessian, all others are added via rank updates on their non-zero columns
+            row_weights = constraint->weights_root * constraint->activation * level_weight;
+            if(type == jnt)
+                hessian_assembler.addSelector(std::static_pointer_cast<JointConstraint>(constraint)->joint_idx, row_weights, col_weights, constraint->y_ref_root, constraint->Aw);
+            else
+                hessian_assembler.addConstraint(constraint->A, row_weights, col_weights, constraint->y_ref_root, constraint->Aw);
 
-    } // constraints on prio
+        }
+    } // priorities
 
     // Add regularization term
-    constraints_prio[prio].H.block(0,0,nj,nj).diagonal().array() += hessian_regularizer;
+    hessian_assembler.addDiagonal(hessian_regularizer);
+    hessian_assembler.get(constraints_prio[prio].H, constraints_prio[prio].g);
 
 
     ///////// Constraints
 
-    // For all contacts: Js*qd = 0 (Rigid Contacts, contact points do not move!)
-    constraints_prio[prio].A.setZero();
-    for(int i = 0; i < contact_points.size(); i++)
-        constraints_prio[prio].A.block(i*6, 0, 6, nj) = contact_points[i]*robot_model->bodyJacobian(robot_model->baseFrame(), contact_points.names[i]);
-    constraints_prio[prio].lower_y.setZero();
-    constraints_prio[prio].upper_y.setZero();
-    // TODO: Using actual limits does not work well (QP Solver sometimes fails due to infeasible QP)
-    constraints_prio[prio].lower_x.setConstant(-1000);
-    constraints_prio[prio].upper_x.setConstant(1000);
-    for(auto n : robot_model->actuatedJointNames()){
-        size_t idx = robot_model->jointIndex(n);
-        const base::JointLimitRange &range = robot_model->jointLimits().getElementByName(n);
-        constraints_prio[prio].lower_x(idx) = range.min.speed;
-        constraints_prio[prio].upper_x(idx) = range.max.speed;
+    // For all active contacts: S*Js*qd = 0 (Rigid Contacts, contact points do not move in the constrained directions!). Depends only on the robot state and the contact models
+    if(model_changed || resized || contact_models_changed){
+        WBC_PROFILE_SCOPE("VelocitySceneQuadraticCost::contactConstraints");
+        uint row = 0;
+        for(uint i = 0; i < ncp; i++){
+            if(contact_points[i] == 0)
+                continue;
+            const base::MatrixXd& jac = model_cache.bodyJacobian(robot_model->baseFrame(), contact_points.names[i]);
+            switch(getContactModel(contact_points.names[i])){
+            case point_contact:
+                constraints_prio[prio].A.middleRows(row, 3) = jac.topRows(3);
+                row += 3;
+                break;
+            case line_contact:
+                // Rotation about the line (x-axis of the contact frame) is free
+                constraints_prio[prio].A.middleRows(row, 3) = jac.topRows(3);
+                constraints_prio[prio].A.middleRows(row+3, 2) = jac.bottomRows(2);
+                row += 5;
+                break;
+            default:
+                constraints_prio[prio].A.middleRows(row, 6) = jac;
+                row += 6;
+                break;
+            }
+        }
+        constraints_prio[prio].lower_y.setZero();
+        constraints_prio[prio].upper_y.setZero();
+    }
+    contact_models_changed = false;
+    // Joint limits are constant
+    if(resized || full_update_required){
+        // TODO: Using actual limits does not work well (QP Solver sometimes fails due to infeasible QP)
+        constraints_prio[prio].lower_x.setConstant(-1000);
+        constraints_prio[prio].upper_x.setConstant(1000);
+        for(auto n : robot_model->actuatedJointNames()){
+            size_t idx = robot_model->jointIndex(n);
+            const base::JointLimitRange &range = robot_model->jointLimits().getElementByName(n);
+            constraints_prio[prio].lower_x(idx) = range.min.speed;
+            constraints_prio[prio].upper_x(idx) = range.max.speed;
+        }
     }
 
     constraints_prio.time = base::Time::now(); //  TODO: Use latest time stamp from all constraints!?
+    clearChanges();
 
     return constraints_prio;
 }
 
+const base::commands::Joints& VelocitySceneQuadraticCost::solve(const HierarchicalQP& hqp){
+
+    WBC_PROFILE_SCOPE("VelocitySceneQuadraticCost::solve");
+
+    // Without contacts, there are only joint velocity bounds. Solve the box constrained QP directly and fall back to the QP solver if it does not converge
+    box_qp_solver_used = false;
+    if(use_box_qp_solver && hqp.size() == 1 && hqp[0].nc == 0){
+        solver_output.resize(hqp[0].nq);
+        if(box_qp_solver.solve(hqp[0].H, hqp[0].g, hqp[0].lower_x, hqp[0].upper_x, solver_output)){
+            solver_status = solver_success;
+            box_qp_solver_used = true;
+            return convertSolverOutput();
+        }
+    }
+    return VelocityScene::solve(hqp);
+}
+
 } // namespace wbc
@@ -2,9 +2,20 @@
 #define VELOCITYSCENEQUADRATICCOST_HPP
 
 #include "../scenes/VelocityScene.hpp"
+#include "../core/HessianAssembler.hpp"
+#include "../core/BoxQPSolver.hpp"
+#include <map>
 
 namespace wbc{
 
+/**
+ * @brief Model of a rigid contact. Determines which directions of the contact frame are constrained, i.e., which rows of the contact Jacobian are used
+ */
+enum ContactModel{point_contact = 0,   /** Linear velocity of the contact point (3 rows), the contact frame can rotate freely, e.g. point feet*/
+                  line_contact = 1,    /** Linear velocity and angular velocity about the y- and z-axis of the contact frame (5 rows). The line is the x-axis of the contact frame*/
+                  surface_contact = 2  /** Full spatial velocity of the contact frame (6 rows), e.g. flat feet. This is the default*/
+                 };
+
 /**
  * @brief Velocity-based implementation of the WBC Scene. It sets up and solves the following problem:
  *  \f[
@@ -12,13 +23,16 @@ namespace wbc{
  *        minimize & \| \mathbf{J}_w\dot{\mathbf{q}} - \mathbf{v}_d\|_2& \\
  *            \mathbf{\dot{q}} & & \\
  *             & & \\
- *           s.t. & \mathbf{J}_{c,i}\dot{\mathbf{q}}=0, \, \forall i & \\
+ *           s.t. & \mathbf{S}_i\mathbf{J}_{c,i}\dot{\mathbf{q}}=0, \, \forall i & \\
  *                & \dot{\mathbf{q}}_{m} \leq \dot{\mathbf{q}} \leq \dot{\mathbf{q}}_{M} & \\
  *        \end{array}
  *  \f]
  *
  * In contrast to the VelocityScene class, the tasks are formulated within the cost function instead of modeling them as constraints. The problem is
  * solved with respect to a number of rigid contacts \f$\mathbf{J}_{c,i}\dot{\mathbf{q}}=0, \, \forall i \f$ and under consideration of the joint velocity limits of the robot.
+ * Tasks on different priorities are combined in a single cost function, where the weights of lower priorities are scaled down (soft hierarchy, see setPriorityWeightRatio()).
+ * If there are no active contacts, the QP has only joint velocity bounds. By default, it is then solved with a projected Newton method (see BoxQPSolver) instead of
+ * the given QP solver, which is considerably faster for fixed base robots. The given QP solver is used as fallback, see setUseBoxQPSolver().
  *
  * \f$\dot{\mathbf{q}}\f$ - Vector of robot joint velocities<br>
  * \f$\mathbf{v}_{d}\f$ - Desired Spatial velocities of all tasks stacked in a vector<br>
@@ -26,7 +40,11 @@ namespace wbc{
  * \f$\mathbf{J}_w = \mathbf{W}\mathbf{J}\f$ - Weighted task Jacobians<br>
  * \f$\mathbf{W}\f$ - Diagonal task weight matrix<br>
  * \f$\dot{\mathbf{q}}_{m},\dot{\mathbf{q}}_{M}\f$ - Joint velocity limits<br>
- * \f$\mathbf{J}_{c,i}\f$ - Contact Jcaobian of i-th contact point<br>
+ * \f$\mathbf{J}_{c,i}\f$ - Contact Jcaobian of i-th active contact point<br>
+ * \f$\mathbf{S}_i\f$ - Selects the constrained rows of the i-th contact Jacobian according to its contact model, see ContactModel<br>
+ *
+ * Only active contacts (value 1 in RobotModel::getActiveContacts()) are part of the QP. Thus, the number of constraint rows is the sum of the rows of all
+ * active contacts, e.g. 3 rows per foot for a quadruped with point feet, instead of 6 rows per contact point.
  *
  *
  */
@@ -35,6 +53,18 @@ protected:
     base::VectorXd s_vals, tmp;
     base::MatrixXd sing_vect_r, U;
     double hessian_regularizer;
+    double priority_weight_ratio;
+    HessianAssembler hessian_assembler;
+    base::VectorXd row_weights, col_weights;
+    BoxQPSolver box_qp_solver;
+    bool use_box_qp_solver;
+    bool box_qp_solver_used;
+    ContactModel default_contact_model;
+    std::map<std::string, ContactModel> contact_models;
+    bool contact_models_changed;
+
+    /** Number of constraint rows of the given contact model*/
+    uint noOfContactRows(const ContactModel model);
 
 public:
     /**
@@ -50,6 +80,28 @@ public:
      */
     virtual const HierarchicalQP& update();
 
+    /**
+     * @brief Solve the given optimization problem. Without contacts, the box constrained QP is solved with the projected Newton method, if enabled.
+     *  If that does not converge, the given QP solver is used.
+     * @return Solver output as joint velocity command
+     */
+    virtual const base::commands::Joints& solve(const HierarchicalQP& hqp);
+
+    /**
+     * @brief Enable/disable the projected Newton method for QPs without contacts. If disabled, the given QP solver is always used. Default is true
+     */
+    void setUseBoxQPSolver(const bool use){use_box_qp_solver = use;}
+
+    /**
+     * @brief Return true if the projected Newton method is used for QPs without contacts
+     */
+    bool getUseBoxQPSolver(){return use_box_qp_solver;}
+
+    /**
+     * @brief Return true if the last call to solve() used the projected Newton method, false if it used the given QP solver
+     */
+    bool boxQPSolverUsed(){return box_qp_solver_used;}
+
     /**
      * @brief setHessianRegularizer
      * @param reg This value is added to the diagonal of the Hessian matrix inside the QP to reduce the risk of infeasibility. Default is 1e-8
@@ -60,6 +112,34 @@ public:
      * @brief Return the current value of hessian regularizer
      */
     double getHessianRegularizer(){return hessian_regularizer;}
+
+    /**
+     * @brief Set the weight ratio between two consecutive priorities. All priorities are mapped to a single level of the QP (soft hierarchy), where the weights of
+     *  the cost of the constraints on priority p is multiplied with ratio^(-p). Thus, priority 0 keeps the configured weights and has the highest weight. The spread of
+     *  the Hessian grows with ratio^(n-1), n being the number of priorities, so a large ratio approximates a strict hierarchy, but deteriorates the conditioning of the QP.
+     *  Has no effect if there is only one priority. Default is 100
+     */
+    void setPriorityWeightRatio(const double ratio);
+
+    /**
+     * @brief Return the weight ratio between two consecutive priorities
+     */
+    double getPriorityWeightRatio(){return priority_weight_ratio;}
+
+    /**
+     * @brief Set the contact model for all contact points, which have no individual contact model, see setContactModel(contact_name, model). Default is surface_contact
+     */
+    void setContactModel(const ContactModel model);
+
+    /**
+     * @brief Set the contact model of the given contact point. Overrides the contact model set with setContactModel(model)
+     */
+    void setContactModel(const std::string& contact_name, const ContactModel model);
+
+    /**
+     * @brief Return the contact model of the given contact point
+     */
+    ContactModel getContactModel(const std::string& contact_name);
 };
 
 } // namespace wbc
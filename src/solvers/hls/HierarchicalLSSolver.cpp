@@ -2,6 +2,8 @@
 #include <stdexcept>
 #include <tools/SVD.hpp>
 #include "../../core/QuadraticProgram.hpp"
+#include "../../core/Profiler.hpp"
+#include <base/Time.hpp>
 
 using namespace std;
 
@@ -10,7 +12,9 @@ namespace wbc{
 HierarchicalLSSolver::HierarchicalLSSolver() :
     no_of_joints(0),
     min_eigenvalue(1e-9),
-    max_solver_output_norm(10){
+    max_solver_output_norm(10),
+    max_svd_iterations(150),
+    svd_iteration_limit_reached(false){
 }
 
 HierarchicalLSSolver::~HierarchicalLSSolver(){
@@ -26,9 +30,10 @@ bool HierarchicalLSSolver::configure(const std::vector<int>& n_constraints_per_p
     if(n_constraints_per_prio.size() == 0)
         throw std::invalid_argument("Invalid Solver config. No of priority levels (size of n_constraints_per_prio) has to be > 0");
 
+    // Priorities without constraint variables are allowed, e.g. if all constraints of a priority are inactive and have been removed from the QP
     for(uint i = 0; i < n_constraints_per_prio.size(); i++){
-        if(n_constraints_per_prio[i] == 0)
-            throw std::invalid_argument("Invalid Solver config. No of constraint variables on each priority level must be > 0");
+        if(n_constraints_per_prio[i] < 0)
+            throw std::invalid_argument("Invalid Solver config. No of constraint variables on each priority level must be >= 0");
     }
 
     for(uint prio = 0; prio < n_constraints_per_prio.size(); prio++)
@@ -53,6 +58,8 @@ bool HierarchicalLSSolver::configure(const std::vector<int>& n_constraints_per_p
 
 void HierarchicalLSSolver::solve(const wbc::HierarchicalQP &hierarchical_qp, base::VectorXd &solver_output){
 
+    WBC_PROFILE_SCOPE("HierarchicalLSSolver::solve");
+
     if(!configured){
         uint n_joints;
         std::vector<int> n_constraints_per_prio;
@@ -70,6 +77,8 @@ void HierarchicalLSSolver::solve(const wbc::HierarchicalQP &hierarchical_qp, bas
                                     + ", Size of input vector: " + std::to_string(hierarchical_qp.size()));
 
     solver_output.setZero(no_of_joints);
+    const base::Time start = base::Time::now();
+    time_budget_exceeded = svd_iteration_limit_reached = false;
 
     // Init projection matrix as identity, so that the highest priority can look for a solution in whole configuration space
     proj_mat.setIdentity();
@@ -78,6 +87,16 @@ void HierarchicalLSSolver::solve(const wbc::HierarchicalQP &hierarchical_qp, bas
 
     for(uint prio = 0; prio < priorities.size(); prio++){
 
+        // The number of rows may change between calls, e.g. if inactive constraints are removed from the QP. In this case, only the
+        // workspace of the affected priority is reallocated. Joint weights are kept.
+        if(hierarchical_qp[prio].A.rows() != priorities[prio].n_constraint_variables &&
+           hierarchical_qp[prio].A.rows() == hierarchical_qp[prio].lower_y.size() &&
+           hierarchical_qp[prio].A.cols() == no_of_joints){
+            base::MatrixXd joint_weight_mat = priorities[prio].joint_weight_mat;
+            priorities[prio] = PriorityData(hierarchical_qp[prio].A.rows(), no_of_joints);
+            priorities[prio].joint_weight_mat = joint_weight_mat;
+        }
+
         if(hierarchical_qp[prio].A.rows()        != priorities[prio].n_constraint_variables ||
            hierarchical_qp[prio].A.cols()        != no_of_joints ||
            hierarchical_qp[prio].lower_y.size()  != priorities[prio].n_constraint_variables){
@@ -95,6 +114,20 @@ void HierarchicalLSSolver::solve(const wbc::HierarchicalQP &hierarchical_qp, bas
         if(hierarchical_qp.Wq.size() != 0)
             setJointWeights(hierarchical_qp.Wq, prio);
 
+        // Nothing to do if all constraints of this priority are inactive
+        if(priorities[prio].n_constraint_variables == 0){
+            priorities[prio].solution_prio.setZero();
+            priorities[prio].sing_vals.setZero();
+            continue;
+        }
+
+        // Time budget: Return the solution of the priorities solved so far. The highest priority is always solved
+        if(prio > 0 && max_solve_time > 0 && (base::Time::now() - start).toSeconds() > max_solve_time){
+            time_budget_exceeded = true;
+            break;
+        }
+
+        WBC_PROFILE_SCOPE("HierarchicalLSSolver::solvePriority");
         priorities[prio].y_comp.setZero();
 
         // Compensate y for part of the solution already met in higher priorities. For the first priority y_comp will be equal to  y
@@ -113,7 +146,8 @@ void HierarchicalLSSolver::solve(const wbc::HierarchicalQP &hierarchical_qp, bas
         for(uint i = 0; i < no_of_joints; i++)
             priorities[prio].A_proj_w.col(i) = priorities[prio].joint_weight_mat(i,i) * priorities[prio].A_proj_w.col(i);
 
-        svd_eigen_decomposition(priorities[prio].A_proj_w, priorities[prio].U, s_vals, sing_vect_r, tmp);
+        if(svd_eigen_decomposition(priorities[prio].A_proj_w, priorities[prio].U, s_vals, sing_vect_r, tmp, max_svd_iterations) == -2)
+            svd_iteration_limit_reached = true;
 
         // Compute damping factor based on
         // A.A. Maciejewski, C.A. Klein, “Numerical Filtering for the Operation of
@@ -174,6 +208,12 @@ void HierarchicalLSSolver::solve(const wbc::HierarchicalQP &hierarchical_qp, bas
     ///////////////
 }
 
+void HierarchicalLSSolver::setMaxSVDIterations(const int n){
+    if(n <= 0)
+        throw std::invalid_argument("Max. number of SVD iterations has to be > 0, but is " + to_string(n));
+    max_svd_iterations = n;
+}
+
 void HierarchicalLSSolver::setJointWeights(const base::VectorXd& weights){
     if(!configured)
         throw std::runtime_error("setJointWeights: Solver has not been configured yet!");
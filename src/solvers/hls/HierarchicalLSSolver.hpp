@@ -85,7 +85,8 @@ public:
      * @brief solve Compute optimal control solution
      * @param constraints Description of the hierarchical quadratic program to solve. Each vector entry correspond to a stage in the hierarchy where
      *                    the first entry has the highest priority. The solver will only use the constraint matrices A,  the lower bound of the
-     *                    constraint variables and the constraint weight vector.
+     *                    constraint variables and the constraint weight vector. If the time budget expires (see setMaxSolveTime()), the solution
+     *                    of the priorities solved so far is returned. The highest priority is always solved.
      * @param x solution
      */
     virtual void solve(const wbc::HierarchicalQP &hierarchical_qp, base::VectorXd &solver_output);
@@ -133,6 +134,19 @@ public:
     /** Return the maximum norm term.*/
     double getMaxSolverOutputNorm(){return max_solver_output_norm;}
 
+    /**
+     * @brief setMaxSVDIterations Sets the maximum number of QR iterations per singular value in the SVD, which bounds the worst-case computation time of each priority.
+     *        If the limit is reached, the SVD is approximate, see svdIterationLimitReached(). Default is 150.
+     * @param n Has to be > 0
+     */
+    void setMaxSVDIterations(const int n);
+
+    /** Return the maximum number of QR iterations per singular value in the SVD*/
+    int getMaxSVDIterations(){return max_svd_iterations;}
+
+    /** Return true if the SVD iteration limit has been reached on any priority in the last call to solve()*/
+    bool svdIterationLimitReached(){return svd_iteration_limit_reached;}
+
     /**
      * @brief Has configure() been  called already?
      */
@@ -154,6 +168,8 @@ protected:
     //Properties
     double min_eigenvalue;    /** Precision for eigenvalue inversion. Inverse of an Eigenvalue smaller than this will be set to zero*/
     double max_solver_output_norm;   /** Maximum norm of (J#) * y */
+    int max_svd_iterations;          /** Maximum number of QR iterations per singular value in the SVD*/
+    bool svd_iteration_limit_reached;
 
     //Helpers
     base::VectorXd tmp;
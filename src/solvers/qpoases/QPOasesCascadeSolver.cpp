@@ -0,0 +1,249 @@
+#include "QPOasesCascadeSolver.hpp"
+#include "../../core/QuadraticProgram.hpp"
+#include "../../core/Profiler.hpp"
+#include <base-logging/Logging.hpp>
+#include <base/Time.hpp>
+
+using namespace qpOASES;
+
+namespace wbc{
+
+QPOASESCascadeSolver::QPOASESCascadeSolver(){
+    n_wsr = 10;
+    hessian_regularizer = 1e-8;
+    options.setToDefault();
+}
+
+QPOASESCascadeSolver::~QPOASESCascadeSolver(){
+
+}
+
+void QPOASESCascadeSolver::solve(const wbc::HierarchicalQP &hierarchical_qp, base::VectorXd &solver_output){
+
+    WBC_PROFILE_SCOPE("QPOASESCascadeSolver::solve");
+
+    const base::Time start = base::Time::now();
+    time_budget_exceeded = false;
+
+    if(hierarchical_qp.size() == 0)
+        throw std::runtime_error("QPOASESCascadeSolver::solve: Hierarchical QP is empty");
+
+    const int nq = hierarchical_qp[0].nq;
+    for(uint prio = 0; prio < hierarchical_qp.size(); prio++){
+        const QuadraticProgram& qp = hierarchical_qp[prio];
+        if(qp.nq != nq)
+            throw std::runtime_error("Number of joints is " + std::to_string(nq) + " on priority 0, but "
+                                     + std::to_string(qp.nq) + " on priority " + std::to_string(prio));
+        if(qp.A.rows() != qp.nc || qp.A.cols() != nq)
+            throw std::runtime_error("Constraint matrix A on priority " + std::to_string(prio) + " should have size " + std::to_string(qp.nc) + "x" + std::to_string(nq) +
+                                     " but has size " +  std::to_string(qp.A.rows()) + "x" + std::to_string(qp.A.cols()));
+        if(qp.lower_y.size() != qp.nc || qp.upper_y.size() != qp.nc)
+            throw std::runtime_error("Number of constraints on priority " + std::to_string(prio) + " is " + std::to_string(qp.nc)
+                                     + ", but lower/upper bound have size " + std::to_string(qp.lower_y.size()) + "/" + std::to_string(qp.upper_y.size()));
+        if(qp.Wy.size() != 0 && qp.Wy.size() != qp.nc)
+            throw std::runtime_error("Number of constraints on priority " + std::to_string(prio) + " is " + std::to_string(qp.nc)
+                                     + ", but constraint weight vector has size " + std::to_string(qp.Wy.size()));
+    }
+    if(hierarchical_qp.Wq.size() != 0 && hierarchical_qp.Wq.size() != nq)
+        throw std::runtime_error("Number of joints is " + std::to_string(nq) + ", but joint weight vector has size " + std::to_string(hierarchical_qp.Wq.size()));
+
+    // Joint bounds: Intersection of the bounds on all priorities. Joints with zero weight are not used
+    lower_x.setConstant(nq, -INFTY);
+    upper_x.setConstant(nq, INFTY);
+    for(uint prio = 0; prio < hierarchical_qp.size(); prio++){
+        const QuadraticProgram& qp = hierarchical_qp[prio];
+        if(qp.lower_x.size() > 0){
+            if(qp.lower_x.size() != nq)
+                throw std::runtime_error("Number of joints in quadratic program is " + std::to_string(nq)
+                                         + ", but lower bound has size " + std::to_string(qp.lower_x.size()));
+            lower_x = lower_x.cwiseMax(qp.lower_x);
+        }
+        if(qp.upper_x.size() > 0){
+            if(qp.upper_x.size() != nq)
+                throw std::runtime_error("Number of joints in quadratic program is " + std::to_string(nq)
+                                         + ", but upper bound has size " + std::to_string(qp.upper_x.size()));
+            upper_x = upper_x.cwiseMin(qp.upper_x);
+        }
+    }
+    for(int i = 0; i < hierarchical_qp.Wq.size(); i++){
+        if(hierarchical_qp.Wq[i] == 0)
+            lower_x[i] = upper_x[i] = 0;
+    }
+
+    if(levels.size() != hierarchical_qp.size()){
+        levels.resize(hierarchical_qp.size());
+        configured = false;
+    }
+    if(!configured){
+        for(LevelData& level : levels)
+            level.sq_problem = SQProblem();
+        configured = true;
+    }
+
+    solver_output.setZero(nq);
+    int nc_fixed = 0;
+    bool level_completed = false;
+    for(uint prio = 0; prio < hierarchical_qp.size(); prio++){
+
+        WBC_PROFILE_SCOPE("QPOASESCascadeSolver::solveLevel");
+
+        const QuadraticProgram& qp = hierarchical_qp[prio];
+        LevelData& level = levels[prio];
+        const int nc = qp.nc;
+        const int nv = nq + nc;
+
+        // Empty priority level: Nothing to solve and nothing to fix on the lower priorities
+        if(nc == 0){
+            level.slack.resize(0);
+            level.fixed_lower_y.resize(0);
+            level.fixed_upper_y.resize(0);
+            continue;
+        }
+
+        // Reconfigure if the size of the level changed, e.g. because inactive constraints have been removed from the QP
+        if((int)level.sq_problem.getNV() != nv || (int)level.sq_problem.getNC() != nc_fixed + nc){
+            level.sq_problem = SQProblem(nv, nc_fixed + nc);
+            level.sq_problem.setOptions(options);
+            level.H.setZero(nv, nv);
+            level.A.setZero(nc_fixed + nc, nv);
+        }
+
+        // Cost: Weighted squared slack variables + regularization
+        level.H.diagonal().setConstant(hessian_regularizer);
+        for(int i = 0; i < nc; i++){
+            const double w = qp.Wy.size() == 0 ? 1.0 : qp.Wy[i];
+            level.H(nq+i,nq+i) += w*w;
+        }
+
+        // Constraints: Rows of all higher priorities with their fixed bounds, then the rows of this level with slack variables
+        level.lbA.resize(nc_fixed + nc);
+        level.ubA.resize(nc_fixed + nc);
+        int row = 0;
+        for(uint j = 0; j < prio; j++){
+            const QuadraticProgram& qp_j = hierarchical_qp[j];
+            level.A.block(row, 0, qp_j.nc, nq) = qp_j.A;
+            level.lbA.segment(row, qp_j.nc) = levels[j].fixed_lower_y;
+            level.ubA.segment(row, qp_j.nc) = levels[j].fixed_upper_y;
+            row += qp_j.nc;
+        }
+        level.A.block(row, 0, nc, nq) = qp.A;
+        level.A.block(row, nq, nc, nc) = -base::MatrixXd::Identity(nc, nc);
+        level.lbA.segment(row, nc) = qp.lower_y;
+        level.ubA.segment(row, nc) = qp.upper_y;
+
+        // Bounds: Joint bounds, slack variables are unbounded
+        level.lb.resize(nv);
+        level.ub.resize(nv);
+        level.lb.head(nq) = lower_x;
+        level.ub.head(nq) = upper_x;
+        level.lb.tail(nc).setConstant(-INFTY);
+        level.ub.tail(nc).setConstant(INFTY);
+
+        // Time budget: Pass the remaining time to qpOASES. If it expires, the solution of the last completed priority level is returned
+        real_t cputime = 0;
+        real_t *cputime_ptr = 0;
+        if(max_solve_time > 0){
+            cputime = max_solve_time - (base::Time::now() - start).toSeconds();
+            if(cputime <= 0){
+                time_budget_exceeded = true;
+                break;
+            }
+            cputime_ptr = &cputime;
+        }
+
+        level.actual_n_wsr = n_wsr;
+        if(!level.sq_problem.isInitialised()){
+            WBC_PROFILE_SCOPE("QPOASESCascadeSolver::init");
+            level.ret_val = level.sq_problem.init(level.H.data(), 0, level.A.data(), level.lb.data(), level.ub.data(),
+                                                  level.lbA.data(), level.ubA.data(), level.actual_n_wsr, cputime_ptr);
+            if(cputime_ptr && level.ret_val == RET_MAX_NWSR_REACHED){
+                time_budget_exceeded = true;
+                break;
+            }
+            if(level.ret_val != SUCCESSFUL_RETURN){
+                LOG_ERROR("QPOASESCascadeSolver: SQ Problem initialization on priority %i failed with error %i", prio, (int)level.ret_val);
+                throw std::runtime_error("SQ Problem initialization on priority " + std::to_string(prio) + " failed with error " + std::to_string(level.ret_val));
+            }
+        }
+        else{
+            WBC_PROFILE_SCOPE("QPOASESCascadeSolver::hotstart");
+            level.ret_val = level.sq_problem.hotstart(level.H.data(), 0, level.A.data(), level.lb.data(), level.ub.data(),
+                                                      level.lbA.data(), level.ubA.data(), level.actual_n_wsr, cputime_ptr);
+            if(cputime_ptr && level.ret_val == RET_MAX_NWSR_REACHED){
+                time_budget_exceeded = true;
+                break;
+            }
+            if(level.ret_val != SUCCESSFUL_RETURN){
+                LOG_ERROR("QPOASESCascadeSolver: SQ Problem hotstart on priority %i failed with error %i", prio, (int)level.ret_val);
+                throw std::runtime_error("SQ Problem hotstart on priority " + std::to_string(prio) + " failed with error " + std::to_string(level.ret_val));
+            }
+        }
+
+        level.solution.resize(nv);
+        if(level.sq_problem.getPrimalSolution(level.solution.data()) == RET_QP_NOT_SOLVED)
+            throw std::runtime_error("SQ Problem getPrimalSolution() on priority " + std::to_string(prio) + " returned " + std::to_string(RET_QP_NOT_SOLVED));
+        solver_output = level.solution.head(nq);
+        level.slack = level.solution.tail(nc);
+
+        // Fix the task error of this level on all lower priorities. Rows with zero weight do not constrain the lower priorities
+        level.fixed_lower_y = qp.lower_y + level.slack;
+        level.fixed_upper_y = qp.upper_y + level.slack;
+        for(int i = 0; i < qp.Wy.size(); i++){
+            if(qp.Wy[i] == 0){
+                level.fixed_lower_y[i] = -INFTY;
+                level.fixed_upper_y[i] = INFTY;
+            }
+        }
+        nc_fixed += nc;
+        level_completed = true;
+    }
+
+    // If the time budget expired before any priority level has been completed, return the solution of the last call, if there is one
+    if(time_budget_exceeded && !level_completed){
+        if(last_solution.size() != nq){
+            LOG_ERROR("QPOASESCascadeSolver: Time budget of %f s expired before priority 0 has been solved and there is no previous solution", max_solve_time);
+            throw std::runtime_error("QPOASESCascadeSolver::solve: Time budget expired before priority 0 has been solved");
+        }
+        solver_output = last_solution;
+    }
+    else if(!time_budget_exceeded)
+        last_solution = solver_output;
+}
+
+void QPOASESCascadeSolver::setOptions(const qpOASES::Options& opt){
+    options = opt;
+    for(LevelData& level : levels)
+        level.sq_problem.setOptions(opt);
+}
+
+void QPOASESCascadeSolver::setHessianRegularizer(const double reg){
+    if(reg <= 0){
+        LOG_ERROR("QPOASESCascadeSolver: Hessian regularizer has to be > 0, but is %f", reg);
+        throw std::invalid_argument("Invalid Hessian regularizer");
+    }
+    hessian_regularizer = reg;
+}
+
+void QPOASESCascadeSolver::checkLevel(const uint level){
+    if(level >= levels.size()){
+        LOG_ERROR("QPOASESCascadeSolver: Priority level %i does not exist, number of levels is %i", level, (int)levels.size());
+        throw std::invalid_argument("Invalid priority level");
+    }
+}
+
+returnValue QPOASESCascadeSolver::getReturnValue(const uint level){
+    checkLevel(level);
+    return levels[level].ret_val;
+}
+
+int QPOASESCascadeSolver::getNoWSR(const uint level){
+    checkLevel(level);
+    return levels[level].actual_n_wsr;
+}
+
+const base::VectorXd& QPOASESCascadeSolver::getSlackVariables(const uint level){
+    checkLevel(level);
+    return levels[level].slack;
+}
+
+}
@@ -0,0 +1,97 @@
+#ifndef WBC_SOLVERS_QP_OASES_CASCADE_SOLVER_HPP
+#define WBC_SOLVERS_QP_OASES_CASCADE_SOLVER_HPP
+
+#include "../../core/QPSolver.hpp"
+#include <qpOASES.hpp>
+
+namespace wbc {
+
+class HierarchicalQP;
+
+/**
+ * @brief The QPOASESCascadeSolver class solves a hierarchy of QPs as a sequence (cascade) of QPs using qpOASES. In contrast to QPOASESSolver, it interprets the
+ *  hierarchical QP like HierarchicalLSSolver, i.e., the rows of each priority level are tasks \f$lb(\mathbf{A}_k\mathbf{x}) \leq \mathbf{A}_k\mathbf{x} \leq ub(\mathbf{A}_k\mathbf{x})\f$,
+ *  which are fulfilled as well as possible without affecting the higher priorities. Equality tasks are given by lower_y = upper_y, inequality tasks by lower_y < upper_y.
+ *  On priority level k, the following problem is solved:
+ *  \f[
+ *        \begin{array}{ccc}
+ *        min(\mathbf{x},\mathbf{w}_k) & \mathbf{w}_k^T\mathbf{W}_k^2\mathbf{w}_k + \epsilon(\mathbf{x}^T\mathbf{x} + \mathbf{w}_k^T\mathbf{w}_k)& \\
+ *             & & \\
+ *        s.t. & lb(\mathbf{A}_k\mathbf{x}) \leq \mathbf{A}_k\mathbf{x} - \mathbf{w}_k \leq ub(\mathbf{A}_k\mathbf{x})& \\
+ *             & lb(\mathbf{A}_j\mathbf{x}) + \mathbf{w}^*_j \leq \mathbf{A}_j\mathbf{x} \leq ub(\mathbf{A}_j\mathbf{x}) + \mathbf{w}^*_j, \quad j < k& \\
+ *             & lb(\mathbf{x}) \leq \mathbf{x} \leq ub(\mathbf{x})& \\
+ *        \end{array}
+ *  \f]
+ *
+ *  \f$\mathbf{w}_k\f$ - Slack variables of level k, i.e. the task error<br>
+ *  \f$\mathbf{w}^*_j\f$ - Optimal slack variables of the higher priority level j, which are fixed on all lower priorities<br>
+ *  \f$\mathbf{W}_k\f$ - Diagonal task weight matrix (Wy) of level k. Rows with zero weight are not fixed on the lower priorities<br>
+ *  \f$\epsilon\f$ - Hessian regularizer, see setHessianRegularizer()<br>
+ *
+ *  The joint bounds are the intersection of the bounds given on all priority levels. Joints with zero joint weight (Wq) are fixed to zero. The Hessian H and gradient g of the
+ *  hierarchical QP are ignored. Each priority level uses its own qpOASES instance, which is hot-started in the next call to solve(), so that the cost per level stays predictable.
+ *  The solution of the lowest priority level is the solver output. If the time budget expires (see setMaxSolveTime()), the solution of the last completed priority level
+ *  is returned. If no level has been completed, the solution of the last call to solve() without timeout is returned. If there is none, solve() throws and trySolve()
+ *  returns solver_failed.
+ */
+class QPOASESCascadeSolver : public QPSolver{
+public:
+    QPOASESCascadeSolver();
+    virtual ~QPOASESCascadeSolver();
+
+    /**
+     * @brief solve Solve the given hierarchical quadratic program
+     * @param constraints Description of the hierarchical quadratic program to solve. Each vector entry correspond to a stage in the hierarchy where
+     *                    the first entry has the highest priority.
+     * @param solver_output solution of the lowest priority level
+     */
+    virtual void solve(const wbc::HierarchicalQP &hierarchical_qp, base::VectorXd &solver_output);
+
+    /** Set the maximum number of working set recalculations per priority level*/
+    void setMaxNoWSR(const uint& n){n_wsr = n;}
+    /** Get the maximum number of working set recalculations per priority level*/
+    uint getMaxNoWSR(){return n_wsr;}
+    /** Return current solver options*/
+    qpOASES::Options getOptions(){return options;}
+    /** Set new solver options, which are used on all priority levels*/
+    void setOptions(const qpOASES::Options& opt);
+    /** Set the value that is added to the diagonal of the Hessian on all priority levels. Has to be > 0. Default is 1e-8*/
+    void setHessianRegularizer(const double reg);
+    /** Return the current Hessian regularizer*/
+    double getHessianRegularizer(){return hessian_regularizer;}
+    /** Return the number of priority levels of the last call to solve()*/
+    uint noOfLevels(){return levels.size();}
+    /** Retrieve the return value from the last QP calculation on the given priority level*/
+    qpOASES::returnValue getReturnValue(const uint level);
+    /** Get number of working set recalculations actually performed on the given priority level*/
+    int getNoWSR(const uint level);
+    /** Return the task error (slack variables) of the given priority level from the last call to solve()*/
+    const base::VectorXd& getSlackVariables(const uint level);
+
+protected:
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrix;
+
+    /** All data of a single priority level*/
+    struct LevelData{
+        qpOASES::SQProblem sq_problem;
+        RowMajorMatrix H, A;
+        base::VectorXd lb, ub, lbA, ubA;
+        base::VectorXd fixed_lower_y, fixed_upper_y; /** Bounds of this level's rows on all lower priorities*/
+        base::VectorXd solution, slack;
+        int actual_n_wsr;
+        qpOASES::returnValue ret_val;
+    };
+
+    std::vector<LevelData> levels;
+    qpOASES::Options options;
+    int n_wsr;
+    double hessian_regularizer;
+    base::VectorXd lower_x, upper_x;
+    base::VectorXd last_solution;
+
+    void checkLevel(const uint level);
+};
+
+}
+
+#endif
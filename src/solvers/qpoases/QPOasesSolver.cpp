@@ -1,7 +1,9 @@
 #include "QPOasesSolver.hpp"
 #include "../../core/QuadraticProgram.hpp"
+#include "../../core/Profiler.hpp"
 #include <base/Eigen.hpp>
 #include <Eigen/Core>
+#include <base-logging/Logging.hpp>
 #include <iostream>
 
 using namespace qpOASES;
@@ -10,7 +12,13 @@ namespace wbc{
 
 QPOASESSolver::QPOASESSolver(){
     n_wsr = 10;
+    matrices_changed = true;
+    recovery_policy = recover_none;
+    recovery_relaxation = 1e-3;
+    recovery_damping = 1e-3;
+    active_set_prediction = false;
     options.setToDefault();
+    resetCounters();
 }
 
 QPOASESSolver::~QPOASESSolver(){
@@ -19,96 +27,377 @@ QPOASESSolver::~QPOASESSolver(){
 
 void QPOASESSolver::solve(const wbc::HierarchicalQP &hierarchical_qp, base::VectorXd &solver_output){
 
+    WBC_PROFILE_SCOPE("QPOASESSolver::solve");
+
     if(hierarchical_qp.size() != 1)
         throw std::runtime_error("QPOASESSolver::solve: Constraints vector size must be 1 for the current implementation");
 
     const wbc::QuadraticProgram &qp = hierarchical_qp[0];
+    checkDimensions(qp);
+
+    bool init;
+    ret_val = solveQP(qp, init);
+    if(time_budget_exceeded && anytimeSolution(qp, solver_output))
+        return;
+    if(ret_val != SUCCESSFUL_RETURN){
+        options.print();
+        qp.print();
+        if(init)
+            throw std::runtime_error("SQ Problem initialization failed with error " + std::to_string(ret_val));
+        else
+            throw std::runtime_error("SQ Problem hotstart failed with error " + std::to_string(ret_val));
+    }
+
+    solver_output.resize(qp.nq);
+    if(sq_problem.getPrimalSolution( solver_output.data() ) == RET_QP_NOT_SOLVED)
+        throw std::runtime_error("SQ Problem getPrimalSolution() returned " + std::to_string(RET_QP_NOT_SOLVED));
+    last_solution = solver_output;
+    n_solves++;
+}
+
+SolverStatus QPOASESSolver::trySolve(const wbc::HierarchicalQP &hierarchical_qp, base::VectorXd &solver_output){
+
+    WBC_PROFILE_SCOPE("QPOASESSolver::trySolve");
+
+    // Invalid input is not a solver failure, so it is not handled by the recovery policy
+    failure_reason.clear();
+    if(hierarchical_qp.size() != 1 || !hasValidDimensions(hierarchical_qp[0])){
+        LOG_ERROR("QPOASESSolver::trySolve: Invalid QP. Number of priorities must be 1 and all matrices and vectors must match the number of variables and constraints");
+        throw std::invalid_argument("QPOASESSolver::trySolve: Invalid QP dimensions");
+    }
+
+    const wbc::QuadraticProgram &qp = hierarchical_qp[0];
+    bool init;
+    ret_val = solveQP(qp, init);
+    solver_output.resize(qp.nq);
+    if(ret_val == SUCCESSFUL_RETURN && sq_problem.getPrimalSolution(solver_output.data()) != RET_QP_NOT_SOLVED){
+        last_solution = solver_output;
+        n_solves++;
+        return solver_success;
+    }
+    if(time_budget_exceeded && anytimeSolution(qp, solver_output))
+        return solver_timeout;
+
+    WBC_PROFILE_SCOPE("QPOASESSolver::recover");
+    if(recovery_policy == recover_relaxed_reinit && relaxedReinit(qp, solver_output)){
+        n_recoveries[recover_relaxed_reinit]++;
+        return solver_recovered;
+    }
+
+    // The internal state of qpOASES is invalid, enforce initialization in the next call
+    sq_problem.reset();
+
+    if(recovery_policy == recover_damped_least_squares && dampedLeastSquares(qp, solver_output)){
+        n_recoveries[recover_damped_least_squares]++;
+        return solver_recovered;
+    }
+    if(recovery_policy != recover_none && last_solution.size() == qp.nq){
+        solver_output = last_solution;
+        n_recoveries[recover_last_solution]++;
+        return solver_recovered;
+    }
+    failure_reason = "qpOASES returned error " + std::to_string(ret_val);
+    n_failures++;
+    return solver_failed;
+}
+
+bool QPOASESSolver::hasValidDimensions(const wbc::QuadraticProgram &qp){
+    return (qp.lower_x.size() == 0 || qp.lower_x.size() == qp.nq) &&
+           (qp.upper_x.size() == 0 || qp.upper_x.size() == qp.nq) &&
+           (qp.lower_y.size() == 0 || qp.lower_y.size() == qp.nc) &&
+           (qp.upper_y.size() == 0 || qp.upper_y.size() == qp.nc) &&
+           (qp.g.size() == 0 || qp.g.size() == qp.nq) &&
+           qp.A.rows() == qp.nc && qp.A.cols() == qp.nq &&
+           qp.H.rows() == qp.nq && qp.H.cols() == qp.nq;
+}
+
+void QPOASESSolver::checkDimensions(const wbc::QuadraticProgram &qp){
+    if(qp.lower_x.size() > 0 && qp.lower_x.size() != qp.nq)
+        throw std::runtime_error("Number of joints in quadratic program is " + std::to_string(qp.nq)
+                                 + ", but lower bound has size " + std::to_string(qp.lower_x.size()));
+    if(qp.upper_x.size() > 0 && qp.upper_x.size() != qp.nq)
+        throw std::runtime_error("Number of joints in quadratic program is " + std::to_string(qp.nq)
+                                 + ", but lower bound has size " + std::to_string(qp.upper_x.size()));
+    if(qp.lower_y.size() > 0 && qp.lower_y.size() != qp.nc)
+        throw std::runtime_error("Number of constraints in quadratic program is " + std::to_string(qp.nc)
+                                 + ", but lower bound has size " + std::to_string(qp.lower_y.size()));
+    if(qp.upper_y.size() > 0 && qp.upper_y.size() != qp.nc)
+        throw std::runtime_error("Number of constraints in quadratic program is " + std::to_string(qp.nc)
+                                 + ", but lower bound has size " + std::to_string(qp.upper_y.size()));
+    if(qp.A.rows() != qp.nc || qp.A.cols() != qp.nq)
+        throw std::runtime_error("Constraint matrix A should have size " + std::to_string(qp.nc) + "x" + std::to_string(qp.nq) +
+                                 "but has size " +  std::to_string(qp.A.rows()) + "x" + std::to_string(qp.A.cols()));
+    if(qp.H.rows() != qp.nq || qp.H.cols() != qp.nq)
+        throw std::runtime_error("Hessian matrix H should have size " + std::to_string(qp.nq) + "x" + std::to_string(qp.nq) +
+                                 "but has size " +  std::to_string(qp.H.rows()) + "x" + std::to_string(qp.H.cols()));
+    if(qp.g.size() > 0 && qp.g.size() != qp.nq)
+        throw std::runtime_error("Gradient vector g should have size " + std::to_string(qp.nq) + "but has size " + std::to_string(qp.g.size()));
+}
+
+returnValue QPOASESSolver::solveQP(const wbc::QuadraticProgram &qp, bool &init){
+
+    // Reconfigure if the size of the QP changed, e.g. because inactive constraints have been removed from the QP
+    if(configured && ((int)sq_problem.getNV() != qp.A.cols() || (int)sq_problem.getNC() != qp.A.rows()))
+        configured = false;
 
     if(!configured){
         sq_problem = SQProblem(qp.A.cols(), qp.A.rows());
         sq_problem.setOptions(options);
+
+        // Preallocate the memory of the recovery strategies, so that recovery does not allocate
+        lb_relaxed.resize(qp.nq);
+        ub_relaxed.resize(qp.nq);
+        lbA_relaxed.resize(qp.nc);
+        ubA_relaxed.resize(qp.nc);
+        M.resize(qp.nq, qp.nq);
+        rhs.resize(qp.nq);
+        a_row.resize(qp.nq);
+        ldlt = Eigen::LDLT<base::MatrixXd>(qp.nq);
+
+        // Same for active set export
+        working_set_bounds.resize(qp.nq);
+        working_set_constraints.resize(qp.nc);
         configured = true;
     }
 
+    // If H and A did not change since the last call, qpOASES can reuse its matrix factorization and only the
+    // vectors have to be updated, e.g. joint space tasks with constant Hessian. Comparing is much cheaper than the refactorization.
+    // Note that qpOASES does not copy the matrices, but keeps pointers to the data of H and A.
+    matrices_changed = !sq_problem.isInitialised() || H.rows() != qp.H.rows() || H.cols() != qp.H.cols() || A.rows() != qp.A.rows() ||
+                       A.cols() != qp.A.cols() || H != qp.H || A != qp.A;
+
     // Have to convert to row-major order matrices. Eigen uses column major by default and
     // qpoases expects the data to be arranged in row-major
-    A = qp.A;
-    H = qp.H;
+    if(matrices_changed){
+        A = qp.A;
+        H = qp.H;
+    }
 
-    // Joint space upper and lower bounds
-    real_t *lb_ptr = 0;
-    real_t *ub_ptr = 0;
-    if(qp.lower_x.size() > 0){
-        if(qp.lower_x.size() != qp.nq)
-            throw std::runtime_error("Number of joints in quadratic program is " + std::to_string(qp.nq)
-                                     + ", but lower bound has size " + std::to_string(qp.lower_x.size()));
+    // Joint space and constraint space upper and lower bounds, gradient vector
+    real_t *lb_ptr  = qp.lower_x.size() > 0 ? (real_t*)qp.lower_x.data() : 0;
+    real_t *ub_ptr  = qp.upper_x.size() > 0 ? (real_t*)qp.upper_x.data() : 0;
+    real_t *lbA_ptr = qp.lower_y.size() > 0 ? (real_t*)qp.lower_y.data() : 0;
+    real_t *ubA_ptr = qp.upper_y.size() > 0 ? (real_t*)qp.upper_y.data() : 0;
+    real_t *g_ptr   = qp.g.size() > 0 ? (real_t*)qp.g.data() : 0;
 
-        lb_ptr = (real_t*)qp.lower_x.data();
-    }
-    if(qp.upper_x.size() > 0){
-        if(qp.upper_x.size() != qp.nq)
-            throw std::runtime_error("Number of joints in quadratic program is " + std::to_string(qp.nq)
-                                     + ", but lower bound has size " + std::to_string(qp.upper_x.size()));
-        ub_ptr = (real_t*)qp.upper_x.data();
-    }
+    // Time budget: qpOASES stops after the given time (input) and returns the time actually spent (output)
+    real_t cputime = max_solve_time;
+    real_t *cputime_ptr = max_solve_time > 0 ? &cputime : 0;
 
-    // Constraint space upper and lower bounds
-    real_t *lbA_ptr = 0;
-    real_t *ubA_ptr = 0;
-    if(qp.lower_y.size() > 0){
-        if(qp.lower_y.size() != qp.nc)
-            throw std::runtime_error("Number of constraints in quadratic program is " + std::to_string(qp.nc)
-                                     + ", but lower bound has size " + std::to_string(qp.lower_y.size()));
-         lbA_ptr = (real_t*)qp.lower_y.data();
+    actual_n_wsr = n_wsr;
+    init = !sq_problem.isInitialised();
+    returnValue ret;
+    if(init){
+        WBC_PROFILE_SCOPE("QPOASESSolver::init");
+        ret = initQP(qp, g_ptr, lb_ptr, ub_ptr, lbA_ptr, ubA_ptr, cputime_ptr);
     }
-    if(qp.upper_y.size() > 0){
-        if(qp.upper_y.size() != qp.nc)
-            throw std::runtime_error("Number of constraints in quadratic program is " + std::to_string(qp.nc)
-                                     + ", but lower bound has size " + std::to_string(qp.upper_y.size()));
-         ubA_ptr = (real_t*)qp.upper_y.data();
+    else if(!matrices_changed){
+        WBC_PROFILE_SCOPE("QPOASESSolver::hotstartVectors");
+        ret = sq_problem.QProblem::hotstart(g_ptr, lb_ptr, ub_ptr, lbA_ptr, ubA_ptr, actual_n_wsr, cputime_ptr);
+    }
+    else{
+        WBC_PROFILE_SCOPE("QPOASESSolver::hotstart");
+        ret = sq_problem.hotstart(H.data(), g_ptr, A.data(), lb_ptr, ub_ptr, lbA_ptr, ubA_ptr, actual_n_wsr, cputime_ptr);
     }
 
-    // Constraint matrix
-    if(A.rows() != qp.nc || A.cols() != qp.nq)
-        throw std::runtime_error("Constraint matrix A should have size " + std::to_string(qp.nc) + "x" + std::to_string(qp.nq) +
-                                 "but has size " +  std::to_string(A.rows()) + "x" + std::to_string(A.cols()));
-    real_t *A_ptr = A.data();
+    // qpOASES does not distinguish between the time limit and the limit of working set recalculations. If a time budget is given, both are treated as expired budget
+    time_budget_exceeded = max_solve_time > 0 && ret == RET_MAX_NWSR_REACHED;
 
-    // Hessian matrix:
-    if(H.rows() != qp.nq || H.cols() != qp.nq)
-        throw std::runtime_error("Hessian matrix H should have size " + std::to_string(qp.nq) + "x" + std::to_string(qp.nq) +
-                                 "but has size " +  std::to_string(H.rows()) + "x" + std::to_string(H.cols()));
-    real_t *H_ptr = (real_t*)H.data();
+    if(ret == SUCCESSFUL_RETURN && active_set_prediction)
+        getActiveSet(active_set_guess);
+    return ret;
+}
 
-    // Gradient vector
-    real_t *g_ptr = 0;
-    if(qp.g.size() > 0){
-        if(qp.g.size() != qp.nq)
-            throw std::runtime_error("Gradient vector g should have size " + std::to_string(qp.nq) + "but has size " + std::to_string(qp.g.size()));
-        g_ptr = (real_t*)qp.g.data();
+returnValue QPOASESSolver::initQP(const wbc::QuadraticProgram &qp, const real_t *g, const real_t *lb, const real_t *ub,
+                                  const real_t *lbA, const real_t *ubA, real_t *cputime){
+
+    const bool use_bounds = active_set_guess.bounds.size() == (size_t)qp.nq;
+    const bool use_constraints = qp.nc > 0 && active_set_guess.constraints.size() == (size_t)qp.nc;
+    actual_n_wsr = n_wsr;
+    if(!use_bounds && !use_constraints)
+        return sq_problem.init(H.data(), g, A.data(), lb, ub, lbA, ubA, actual_n_wsr, cputime);
+
+    // qpOASES keeps index lists in Bounds/Constraints and rejects indices that have been set up before. Thus, the guess has to be
+    // initialized on each call. Variables and constraints without the corresponding bound cannot be active
+    bool guess_valid = true;
+    if(use_bounds){
+        guess_valid = guessed_bounds.init(qp.nq) == SUCCESSFUL_RETURN;
+        for(int i = 0; i < qp.nq && guess_valid; i++){
+            const int8_t status = active_set_guess.bounds[i];
+            if(status < 0 && lb)
+                guess_valid = guessed_bounds.setupBound(i, ST_LOWER) == SUCCESSFUL_RETURN;
+            else if(status > 0 && ub)
+                guess_valid = guessed_bounds.setupBound(i, ST_UPPER) == SUCCESSFUL_RETURN;
+            else
+                guess_valid = guessed_bounds.setupBound(i, ST_INACTIVE) == SUCCESSFUL_RETURN;
+        }
+    }
+    if(use_constraints && guess_valid){
+        guess_valid = guessed_constraints.init(qp.nc) == SUCCESSFUL_RETURN;
+        for(int i = 0; i < qp.nc && guess_valid; i++){
+            const int8_t status = active_set_guess.constraints[i];
+            if(status < 0 && lbA)
+                guess_valid = guessed_constraints.setupConstraint(i, ST_LOWER) == SUCCESSFUL_RETURN;
+            else if(status > 0 && ubA)
+                guess_valid = guessed_constraints.setupConstraint(i, ST_UPPER) == SUCCESSFUL_RETURN;
+            else
+                guess_valid = guessed_constraints.setupConstraint(i, ST_INACTIVE) == SUCCESSFUL_RETURN;
+        }
     }
+    if(!guess_valid){
+        LOG_WARN("QPOASESSolver: Unable to set up the active set guess, using cold start");
+        return sq_problem.init(H.data(), g, A.data(), lb, ub, lbA, ubA, actual_n_wsr, cputime);
+    }
+
+    const real_t max_time = cputime ? *cputime : 0;
+    returnValue ret = sq_problem.init(H.data(), g, A.data(), lb, ub, lbA, ubA, actual_n_wsr, cputime, 0, 0,
+                                      use_bounds ? &guessed_bounds : 0, use_constraints ? &guessed_constraints : 0);
+    if(ret == SUCCESSFUL_RETURN || (cputime && ret == RET_MAX_NWSR_REACHED))
+        return ret;
 
+    // The guess may not fit the current QP anymore, e.g. after large changes of the bounds. Cold start
+    sq_problem.reset();
+    if(cputime)
+        *cputime = max_time;
     actual_n_wsr = n_wsr;
-    if(!sq_problem.isInitialised()){
-        ret_val = sq_problem.init(H_ptr, g_ptr, A_ptr, lb_ptr, ub_ptr, lbA_ptr, ubA_ptr, actual_n_wsr, 0);
-        if(ret_val != SUCCESSFUL_RETURN){
-            options.print();
-            qp.print();
-            throw std::runtime_error("SQ Problem initialization failed with error " + std::to_string(ret_val));
+    return sq_problem.init(H.data(), g, A.data(), lb, ub, lbA, ubA, actual_n_wsr, cputime);
+}
+
+bool QPOASESSolver::getActiveSet(QPActiveSet& active_set){
+    if(!sq_problem.isInitialised())
+        return false;
+
+    const int nv = sq_problem.getNV(), nc = sq_problem.getNC();
+    working_set_bounds.resize(nv);
+    working_set_constraints.resize(nc);
+    if(sq_problem.getWorkingSetBounds(working_set_bounds.data()) != SUCCESSFUL_RETURN)
+        return false;
+    if(nc > 0 && sq_problem.getWorkingSetConstraints(working_set_constraints.data()) != SUCCESSFUL_RETURN)
+        return false;
+
+    active_set.bounds.resize(nv);
+    for(int i = 0; i < nv; i++)
+        active_set.bounds[i] = working_set_bounds[i] > 0.5 ? 1 : (working_set_bounds[i] < -0.5 ? -1 : 0);
+    active_set.constraints.resize(nc);
+    for(int i = 0; i < nc; i++)
+        active_set.constraints[i] = working_set_constraints[i] > 0.5 ? 1 : (working_set_constraints[i] < -0.5 ? -1 : 0);
+    return true;
+}
+
+void QPOASESSolver::setActiveSet(const QPActiveSet& active_set){
+    for(auto status : active_set.bounds){
+        if(status < -1 || status > 1){
+            LOG_ERROR("QPOASESSolver: Invalid status %i in active set of the bounds. Valid values are -1, 0 and 1", status);
+            throw std::invalid_argument("Invalid active set");
         }
     }
-    else{
-        ret_val = sq_problem.hotstart(H_ptr, g_ptr, A_ptr, lb_ptr, ub_ptr, lbA_ptr, ubA_ptr, actual_n_wsr, 0);
-        if(ret_val != SUCCESSFUL_RETURN){
-            options.print();
-            qp.print();
-            throw std::runtime_error("SQ Problem hotstart failed with error " + std::to_string(ret_val));
+    for(auto status : active_set.constraints){
+        if(status < -1 || status > 1){
+            LOG_ERROR("QPOASESSolver: Invalid status %i in active set of the constraints. Valid values are -1, 0 and 1", status);
+            throw std::invalid_argument("Invalid active set");
         }
     }
+    active_set_guess = active_set;
+}
 
+bool QPOASESSolver::anytimeSolution(const wbc::QuadraticProgram &qp, base::VectorXd &solver_output){
+    // Use the current primal iterate if qpOASES provides one, otherwise the last valid solution
     solver_output.resize(qp.nq);
-    if(sq_problem.getPrimalSolution( solver_output.data() ) == RET_QP_NOT_SOLVED)
-        throw std::runtime_error("SQ Problem getPrimalSolution() returned " + std::to_string(RET_QP_NOT_SOLVED));
+    if(sq_problem.getPrimalSolution(solver_output.data()) != RET_QP_NOT_SOLVED){
+        n_timeouts++;
+        return true;
+    }
+    if(last_solution.size() == qp.nq){
+        solver_output = last_solution;
+        n_timeouts++;
+        return true;
+    }
+    return false;
+}
+
+bool QPOASESSolver::relaxedReinit(const wbc::QuadraticProgram &qp, base::VectorXd &solver_output){
+    real_t *lb_ptr = 0, *ub_ptr = 0, *lbA_ptr = 0, *ubA_ptr = 0;
+    if(qp.lower_x.size() > 0){
+        lb_relaxed = (qp.lower_x.array() - recovery_relaxation).matrix();
+        lb_ptr = lb_relaxed.data();
+    }
+    if(qp.upper_x.size() > 0){
+        ub_relaxed = (qp.upper_x.array() + recovery_relaxation).matrix();
+        ub_ptr = ub_relaxed.data();
+    }
+    if(qp.lower_y.size() > 0){
+        lbA_relaxed = (qp.lower_y.array() - recovery_relaxation).matrix();
+        lbA_ptr = lbA_relaxed.data();
+    }
+    if(qp.upper_y.size() > 0){
+        ubA_relaxed = (qp.upper_y.array() + recovery_relaxation).matrix();
+        ubA_ptr = ubA_relaxed.data();
+    }
+    real_t *g_ptr = qp.g.size() > 0 ? (real_t*)qp.g.data() : 0;
+
+    // Cold start, the active set of the failed hotstart is not trustworthy. Use the active set guess instead, if available
+    sq_problem.reset();
+    ret_val = initQP(qp, g_ptr, lb_ptr, ub_ptr, lbA_ptr, ubA_ptr, 0);
+    return ret_val == SUCCESSFUL_RETURN && sq_problem.getPrimalSolution(solver_output.data()) != RET_QP_NOT_SOLVED;
+}
+
+bool QPOASESSolver::dampedLeastSquares(const wbc::QuadraticProgram &qp, base::VectorXd &solver_output){
+    // Solve (H + damping*I + 1/damping * A_eq^T*A_eq) x = -g + 1/damping * A_eq^T*y_eq, i.e. the cost function plus the equality constraints
+    // as penalty. Inequality constraints are ignored, joint bounds are enforced by clipping. Only the lower triangle of M is used.
+    M = qp.H;
+    M.diagonal().array() += recovery_damping;
+    if(qp.g.size() > 0)
+        rhs = -qp.g;
+    else
+        rhs.setZero();
+    if(qp.lower_y.size() > 0 && qp.upper_y.size() > 0){
+        for(int i = 0; i < qp.nc; i++){
+            if(qp.lower_y[i] != qp.upper_y[i])
+                continue;
+            a_row = qp.A.row(i).transpose();
+            M.selfadjointView<Eigen::Lower>().rankUpdate(a_row, 1.0/recovery_damping);
+            rhs += (qp.lower_y[i]/recovery_damping) * a_row;
+        }
+    }
+    ldlt.compute(M);
+    if(ldlt.info() != Eigen::Success)
+        return false;
+    solver_output = ldlt.solve(rhs);
+    if(qp.lower_x.size() > 0)
+        solver_output = solver_output.cwiseMax(qp.lower_x);
+    if(qp.upper_x.size() > 0)
+        solver_output = solver_output.cwiseMin(qp.upper_x);
+    return solver_output.allFinite();
+}
+
+void QPOASESSolver::setRecoveryRelaxation(const double relaxation){
+    if(relaxation <= 0){
+        LOG_ERROR("QPOASESSolver: Recovery relaxation has to be > 0, but is %f", relaxation);
+        throw std::invalid_argument("Invalid recovery relaxation");
+    }
+    recovery_relaxation = relaxation;
+}
+
+void QPOASESSolver::setRecoveryDamping(const double damping){
+    if(damping <= 0){
+        LOG_ERROR("QPOASESSolver: Recovery damping has to be > 0, but is %f", damping);
+        throw std::invalid_argument("Invalid recovery damping");
+    }
+    recovery_damping = damping;
+}
+
+uint QPOASESSolver::getNoOfRecoveries(const QPRecoveryPolicy path){
+    if(path <= recover_none || path >= n_recovery_policies){
+        LOG_ERROR("QPOASESSolver: Invalid recovery path %i", path);
+        throw std::invalid_argument("Invalid recovery path");
+    }
+    return n_recoveries[path];
+}
+
+void QPOASESSolver::resetCounters(){
+    n_solves = n_failures = n_timeouts = 0;
+    for(uint i = 0; i < n_recovery_policies; i++)
+        n_recoveries[i] = 0;
 }
 
 returnValue QPOASESSolver::getReturnValue(){
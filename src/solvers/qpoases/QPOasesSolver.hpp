@@ -4,6 +4,8 @@
 #include "../../core/QPSolver.hpp"
 #include <qpOASES.hpp>
 #include <base/Time.hpp>
+#include <Eigen/Cholesky>
+#include <cstdint>
 
 namespace qpOASES {
 enum optionPresets{qp_default, qp_reliable, qp_fast, qp_unset};
@@ -12,6 +14,26 @@ enum optionPresets{qp_default, qp_reliable, qp_fast, qp_unset};
 namespace wbc {
 
 class HierarchicalQP;
+class QuadraticProgram;
+
+/** Recovery strategy of QPOASESSolver::trySolve(), if the QP cannot be solved*/
+enum QPRecoveryPolicy{recover_none,                 /** No recovery, trySolve() returns solver_failed*/
+                      recover_last_solution,        /** Return the last valid solution*/
+                      recover_relaxed_reinit,       /** Cold start with all bounds relaxed by the recovery relaxation. If this fails, return the last valid solution*/
+                      recover_damped_least_squares, /** Solve the cost function with damping and the equality constraints as penalty, clip to the joint bounds.
+                                                        Inequality constraints are ignored. If this fails, return the last valid solution*/
+                      n_recovery_policies};
+
+/**
+ * @brief Compact representation of the active set (working set) of a QP. Each entry is -1 (lower bound active), 0 (inactive) or 1 (upper bound active).
+ *  Equality constraints are reported as active at one of their bounds.
+ */
+struct QPActiveSet{
+    std::vector<int8_t> bounds;      /** Status of the joint bounds, size nq*/
+    std::vector<int8_t> constraints; /** Status of the constraints, size nc*/
+    void clear(){bounds.clear(); constraints.clear();}
+    bool empty() const {return bounds.empty() && constraints.empty();}
+};
 
 /**
  * @brief The QPOASESSolver class is a wrapper for the qp-solver qpoases (see https://www.coin-or.org/qpOASES/doc/3.0/manual.pdf). It solves problems of shape:
@@ -37,6 +59,38 @@ public:
      */
     virtual void solve(const wbc::HierarchicalQP &hierarchical_qp, base::VectorXd &solver_output);
 
+    /**
+     * @brief trySolve Like solve(), but does not throw or print if qpOASES fails. Instead, the configured recovery policy is applied (see setRecoveryPolicy()).
+     *  Recovery does not allocate memory, except recover_relaxed_reinit, which reinitializes qpOASES. Set the qpOASES print level to PL_NONE to suppress all console output.
+     *  Throws std::invalid_argument if the dimensions of the QP are invalid.
+     * @return solver_success, solver_recovered if the output was computed by the recovery policy, or solver_failed if no output could be computed. In the latter case,
+     *  getFailureReason() contains the qpOASES return value
+     */
+    virtual SolverStatus trySolve(const wbc::HierarchicalQP &hierarchical_qp, base::VectorXd &solver_output);
+
+    /** Set the recovery policy of trySolve(). Default is recover_none*/
+    void setRecoveryPolicy(const QPRecoveryPolicy policy){recovery_policy = policy;}
+    /** Get the recovery policy of trySolve()*/
+    QPRecoveryPolicy getRecoveryPolicy(){return recovery_policy;}
+    /** Set the amount by which all bounds are relaxed in recover_relaxed_reinit. Has to be > 0. Default is 1e-3*/
+    void setRecoveryRelaxation(const double relaxation);
+    /** Get the amount by which all bounds are relaxed in recover_relaxed_reinit*/
+    double getRecoveryRelaxation(){return recovery_relaxation;}
+    /** Set the damping of recover_damped_least_squares. Has to be > 0. Default is 1e-3*/
+    void setRecoveryDamping(const double damping);
+    /** Get the damping of recover_damped_least_squares*/
+    double getRecoveryDamping(){return recovery_damping;}
+    /** Number of successful solves (solve() and trySolve()) since the last call to resetCounters()*/
+    uint getNoOfSolves(){return n_solves;}
+    /** Number of calls to trySolve() in which the given recovery path computed the output, since the last call to resetCounters()*/
+    uint getNoOfRecoveries(const QPRecoveryPolicy path);
+    /** Number of calls to trySolve() that returned solver_failed since the last call to resetCounters()*/
+    uint getNoOfFailures(){return n_failures;}
+    /** Number of calls to solve() or trySolve(), in which the time budget expired (see setMaxSolveTime()), since the last call to resetCounters()*/
+    uint getNoOfTimeouts(){return n_timeouts;}
+    /** Reset the solve, recovery, timeout and failure counters*/
+    void resetCounters();
+
     /** Set the maximum number of working set recalculations to be performed during the initial homotopy*/
     void setMaxNoWSR(const uint& n){n_wsr = n;}
     /** Get the maximum number of working set recalculations to be performed during the initial homotopy*/
@@ -51,14 +105,67 @@ public:
     void setOptions(const qpOASES::Options& opt);
     /** Set new solver options using one of the following presets: qp_default, qp_reliable, qp_fast, qp_unset*/
     void setOptionsPreset(const qpOASES::optionPresets& opt);
+    /** Return true if H or A changed in the last call to solve(). If not, only the vectors of the QP have been updated in the hotstart*/
+    bool matricesChanged(){return matrices_changed;}
     /** Get Quadratic program*/
     const qpOASES::SQProblem& getSQProblem(){return sq_problem;}
 
+    /**
+     * @brief Export the active set of the last successful solve
+     * @return False, if qpOASES has not been initialized
+     */
+    bool getActiveSet(QPActiveSet& active_set);
+    /**
+     * @brief Set the active set that is used as initial guess in the next initialization of qpOASES, i.e. after reset(), after the QP size changed or after recovery.
+     *  Hotstarts are not affected. The bound guess is only used if its size matches the number of joints, the constraint guess only if its size matches the number of
+     *  constraints, so that e.g. the bounds can still be restored after a contact switch. Guesses for unbounded variables or constraints are ignored.
+     *  Throws if an entry is not -1, 0 or 1. Pass an empty active set to cold start without guess.
+     */
+    void setActiveSet(const QPActiveSet& active_set);
+    /** Return the active set that is used as initial guess in the next initialization*/
+    const QPActiveSet& getActiveSetGuess(){return active_set_guess;}
+    /**
+     * @brief If enabled, the active set is exported after each successful solve and used as initial guess in the next initialization (see setActiveSet()).
+     *  Thus, the working set survives reset(), reconfiguration and recovery. Default is false
+     */
+    void setActiveSetPrediction(const bool enable){active_set_prediction = enable;}
+    /** Return true if active set prediction is enabled*/
+    bool getActiveSetPrediction(){return active_set_prediction;}
+
 protected:
     qpOASES::Options options;
     qpOASES::SQProblem sq_problem;
     int n_wsr, actual_n_wsr;
     qpOASES::returnValue ret_val;
+    bool matrices_changed;
+    base::VectorXd last_solution;
+    QPRecoveryPolicy recovery_policy;
+    double recovery_relaxation, recovery_damping;
+    uint n_solves, n_failures, n_timeouts, n_recoveries[n_recovery_policies];
+    base::VectorXd lb_relaxed, ub_relaxed, lbA_relaxed, ubA_relaxed, rhs, a_row;
+    base::MatrixXd M;
+    Eigen::LDLT<base::MatrixXd> ldlt;
+    QPActiveSet active_set_guess;
+    bool active_set_prediction;
+    qpOASES::Bounds guessed_bounds;
+    qpOASES::Constraints guessed_constraints;
+    base::VectorXd working_set_bounds, working_set_constraints;
+
+    /** Return true if all vectors and matrices of the QP have consistent size*/
+    bool hasValidDimensions(const wbc::QuadraticProgram &qp);
+    /** Throw if vectors and matrices of the QP have inconsistent size*/
+    void checkDimensions(const wbc::QuadraticProgram &qp);
+    /** Init or hotstart qpOASES with the given QP. Does not throw on failure. init is true if qpOASES has been initialized*/
+    qpOASES::returnValue solveQP(const wbc::QuadraticProgram &qp, bool &init);
+    /** Output of an interrupted solve: The current primal iterate, if available, otherwise the last valid solution. Returns false if neither is available*/
+    bool anytimeSolution(const wbc::QuadraticProgram &qp, base::VectorXd &solver_output);
+    /** Initialize qpOASES, using the active set guess if available (see setActiveSet()). Falls back to a cold start if this fails*/
+    qpOASES::returnValue initQP(const wbc::QuadraticProgram &qp, const qpOASES::real_t *g, const qpOASES::real_t *lb, const qpOASES::real_t *ub,
+                                const qpOASES::real_t *lbA, const qpOASES::real_t *ubA, qpOASES::real_t *cputime);
+    /** Recovery: Cold start with relaxed bounds*/
+    bool relaxedReinit(const wbc::QuadraticProgram &qp, base::VectorXd &solver_output);
+    /** Recovery: Damped least squares solution of the cost function with equality constraints as penalty*/
+    bool dampedLeastSquares(const wbc::QuadraticProgram &qp, base::VectorXd &solver_output);
     Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> H;
     Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> A;
     base::Time stamp;
@@ -0,0 +1,299 @@
+#include "SNSSolver.hpp"
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <tools/SVD.hpp>
+#include "../../core/QuadraticProgram.hpp"
+#include "../../core/Profiler.hpp"
+#include <base/Time.hpp>
+
+using namespace std;
+
+namespace wbc{
+
+SNSSolver::SNSSolver() :
+    no_of_joints(0),
+    min_eigenvalue(1e-9),
+    max_solver_output_norm(10),
+    n_saturated(0){
+}
+
+SNSSolver::~SNSSolver(){
+}
+
+void SNSSolver::configure(const uint n_joints){
+    if(n_joints == 0)
+        throw std::invalid_argument("Invalid Solver config. Number of joints must be > 0");
+
+    no_of_joints = n_joints;
+    proj_mat.setIdentity(n_joints, n_joints);
+    proj_mat_sat.setIdentity(n_joints, n_joints);
+    proj_mat_best.setIdentity(n_joints, n_joints);
+    lower_x.resize(n_joints);
+    upper_x.resize(n_joints);
+    joint_weights.setOnes(n_joints);
+    delta.setZero(n_joints);
+    delta_best.setZero(n_joints);
+    delta_task.setZero(n_joints);
+    delta_sat.setZero(n_joints);
+    sat_value.setZero(n_joints);
+
+    // Workspaces of the saturation loop. The saturated joints are selected by zeroing the rows of the other joints, so that the sizes do not change between iterations
+    sat_proj.setZero(n_joints, n_joints);
+    sat_proj_inv.setZero(n_joints, n_joints);
+    sat_proj_inv_damped.setZero(n_joints, n_joints);
+    sat_diff.setZero(n_joints);
+    joint_tmp.setZero(n_joints);
+    U.setZero(n_joints, n_joints);
+    V.setZero(n_joints, n_joints);
+    s_vals.setZero(n_joints);
+    tmp.setZero(n_joints);
+    saturated.resize(n_joints);
+    saturated_best.resize(n_joints);
+    configured = true;
+}
+
+uint SNSSolver::pseudoInverse(const base::MatrixXd& mat, base::MatrixXd& mat_inv, base::MatrixXd& mat_inv_damped){
+    // The SVD only uses the top m rows of U, so U is only enlarged, never shrunk. All matrices passed here have no_of_joints columns
+    const uint m = mat.rows(), n = mat.cols(), k = min(m,n);
+    if(U.rows() < m || U.cols() != n)
+        U.setZero(max<uint>(m, U.rows()), n);
+    svd_eigen_decomposition(mat, U, s_vals, V, tmp);
+
+    // Damping factor based on A.A. Maciejewski, C.A. Klein, “Numerical Filtering for the Operation of Robotic Manipulators through Kinematically
+    // Singular Configurations”, Journal of Robotic Systems, Vol. 5, No. 6, pp. 527 - 552, 1988. See also HierarchicalLSSolver
+    double damping = 0;
+    const double s_min = k > 0 ? s_vals.head(k).minCoeff() : 0;
+    if(s_min <= (1/max_solver_output_norm)/2)
+        damping = (1/max_solver_output_norm)/2;
+    else if(s_min < (1/max_solver_output_norm))
+        damping = sqrt(s_min*((1/max_solver_output_norm)-s_min));
+
+    mat_inv.setZero(n, m);
+    mat_inv_damped.setZero(n, m);
+    uint rank = 0;
+    for(uint i = 0; i < k; i++){
+        if(s_vals(i) >= min_eigenvalue){
+            mat_inv.noalias() += (1/s_vals(i)) * V.col(i) * U.col(i).head(m).transpose();
+            rank++;
+        }
+        mat_inv_damped.noalias() += (s_vals(i) / (s_vals(i)*s_vals(i) + damping*damping)) * V.col(i) * U.col(i).head(m).transpose();
+    }
+    return rank;
+}
+
+void SNSSolver::solve(const wbc::HierarchicalQP &hierarchical_qp, base::VectorXd &solver_output){
+
+    WBC_PROFILE_SCOPE("SNSSolver::solve");
+
+    if(hierarchical_qp.size() == 0)
+        throw std::invalid_argument("Invalid solver input. Hierarchical QP is empty");
+
+    const uint nq = hierarchical_qp[0].A.cols();
+    if(!configured || nq != no_of_joints)
+        configure(nq);
+
+    if(hierarchical_qp.Wq.size() != 0){
+        if(hierarchical_qp.Wq.size() != nq)
+            throw std::invalid_argument("Cannot set joint weights. Size of joint weight vector is " + to_string(hierarchical_qp.Wq.size()) + " but should be " + to_string(nq));
+        for(uint i = 0; i < nq; i++){
+            if(hierarchical_qp.Wq(i) < 0)
+                throw std::invalid_argument("Entries of joint weight vector have to be >= 0, but element " + to_string(i) + " is " + to_string(hierarchical_qp.Wq(i)));
+            joint_weights(i) = sqrt(hierarchical_qp.Wq(i));
+        }
+    }
+    else
+        joint_weights.setOnes();
+
+    const base::Time start = base::Time::now();
+    time_budget_exceeded = false;
+
+    solver_output.setZero(nq);
+    proj_mat.setIdentity();
+    lower_x.setConstant(-numeric_limits<double>::infinity());
+    upper_x.setConstant(numeric_limits<double>::infinity());
+    std::fill(saturated.begin(), saturated.end(), false);
+    n_saturated = 0;
+    task_scales.assign(hierarchical_qp.size(), 0.0);
+
+    for(uint prio = 0; prio < hierarchical_qp.size(); prio++){
+
+        const QuadraticProgram& qp = hierarchical_qp[prio];
+        const uint nc = qp.A.rows();
+        if(qp.A.cols() != nq || qp.lower_y.size() != nc){
+            throw std::invalid_argument("Expected input size on priority level " + to_string(prio) + ": " +  "A: " + to_string(nc) + " x " + to_string(nq) +
+                      ", b: " + to_string(nc) + " x 1, actual input: " + "A: " + to_string(qp.A.rows()) + " x " + to_string(qp.A.cols()) +
+                      ", b: " + to_string(qp.lower_y.size()) + " x 1");
+        }
+        if(qp.Wy.size() != 0 && qp.Wy.size() != nc)
+            throw std::invalid_argument("Cannot set constraint weights. Size of constraint weight vector is " + to_string(qp.Wy.size())
+                                        + " but should be " + to_string(nc));
+
+        // Joint bounds of this priority apply to all lower priorities as well. Empty bound vectors or NaN entries mean that there is no bound
+        if(qp.lower_x.size() != 0 && qp.lower_x.size() != nq)
+            throw std::invalid_argument("Number of joints is " + to_string(nq) + ", but lower bound on priority " + to_string(prio) + " has size " + to_string(qp.lower_x.size()));
+        if(qp.upper_x.size() != 0 && qp.upper_x.size() != nq)
+            throw std::invalid_argument("Number of joints is " + to_string(nq) + ", but upper bound on priority " + to_string(prio) + " has size " + to_string(qp.upper_x.size()));
+        for(int i = 0; i < qp.lower_x.size(); i++){
+            if(!std::isnan(qp.lower_x(i)))
+                lower_x(i) = max(lower_x(i), qp.lower_x(i));
+        }
+        for(int i = 0; i < qp.upper_x.size(); i++){
+            if(!std::isnan(qp.upper_x(i)))
+                upper_x(i) = min(upper_x(i), qp.upper_x(i));
+        }
+
+        // Nothing to do if all constraints of this priority are inactive
+        if(nc == 0){
+            task_scales[prio] = 1;
+            continue;
+        }
+
+        // Time budget: Return the solution of the priorities solved so far. The highest priority is always solved
+        if(prio > 0 && max_solve_time > 0 && (base::Time::now() - start).toSeconds() > max_solve_time){
+            time_budget_exceeded = true;
+            break;
+        }
+
+        WBC_PROFILE_SCOPE("SNSSolver::solvePriority");
+
+        row_weights.resize(nc);
+        row_tmp.resize(nc);
+        for(uint i = 0; i < nc; i++){
+            const double w = qp.Wy.size() == 0 ? 1.0 : qp.Wy(i);
+            if(w < 0)
+                throw std::invalid_argument("Entries of constraint weight vector have to be >= 0, but element " + to_string(i) + " is " + to_string(w));
+            row_weights(i) = sqrt(w);
+        }
+
+        // Compensate y for the part of the solution already met in higher priorities
+        y_comp = qp.lower_y;
+        y_comp.noalias() -= qp.A*solver_output;
+
+        double scale_best = -1;
+        bool task_feasible = false;
+        uint rank_0 = 0;
+        for(uint iter = 0; iter <= nq; iter++){
+
+            // Nullspace of the higher priorities and the saturated joints: P_sat = P - (S*P)^# * S*P, where S selects the rows of the saturated joints.
+            // Motion that moves the saturated joints to their bounds within the nullspace of the higher priorities: delta_sat = (S*P)^# * (q_sat - S*q).
+            // Instead of selecting rows, the rows of the non-saturated joints are set to zero, which yields the same pseudo inverse at constant matrix sizes
+            delta_sat.setZero();
+            proj_mat_sat = proj_mat;
+            if(n_saturated > 0){
+                for(uint i = 0; i < nq; i++){
+                    if(saturated[i]){
+                        sat_diff(i) = sat_value(i) - solver_output(i);
+                        sat_proj.row(i) = proj_mat.row(i);
+                    }
+                    else{
+                        sat_diff(i) = 0;
+                        sat_proj.row(i).setZero();
+                    }
+                }
+                pseudoInverse(sat_proj, sat_proj_inv, sat_proj_inv_damped);
+                proj_mat_sat.noalias() -= sat_proj_inv * sat_proj;
+                delta_sat.noalias() = sat_proj_inv * sat_diff;
+            }
+
+            // Weighted, projected task matrix: Wy * A * P_sat * Wq
+            A_proj_w.noalias() = qp.A * proj_mat_sat;
+            A_proj_w = row_weights.asDiagonal() * A_proj_w * joint_weights.asDiagonal();
+            const uint rank = pseudoInverse(A_proj_w, A_proj_inv, A_proj_inv_damped);
+            if(iter == 0)
+                rank_0 = rank;
+            else if(rank < rank_0) // The task cannot be fulfilled with the remaining joints anymore
+                break;
+
+            // Solution of this priority: delta = delta_sat + s * delta_task, where s is the task scaling factor, delta_task = P_sat * Wq * (Wy * A * P_sat * Wq)^# * Wy * y_comp,
+            // and the remaining joints compensate the effect of the saturated joints on the task: delta_sat -= P_sat * Wq * (Wy * A * P_sat * Wq)^# * Wy * A * delta_sat
+            row_tmp = row_weights.cwiseProduct(y_comp);
+            joint_tmp.noalias() = A_proj_inv_damped * row_tmp;
+            joint_tmp = joint_weights.cwiseProduct(joint_tmp);
+            delta_task.noalias() = proj_mat_sat * joint_tmp;
+            if(n_saturated > 0){
+                row_tmp.noalias() = qp.A * delta_sat;
+                row_tmp = row_weights.cwiseProduct(row_tmp);
+                joint_tmp.noalias() = A_proj_inv_damped * row_tmp;
+                joint_tmp = joint_weights.cwiseProduct(joint_tmp);
+                delta_sat.noalias() -= proj_mat_sat * joint_tmp;
+            }
+
+            // Largest scaling factor of the task reference, so that all non-saturated joints stay within their bounds
+            double scale = 1;
+            int critical_joint = -1;
+            for(uint i = 0; i < nq; i++){
+                if(saturated[i])
+                    continue;
+                const double q = solver_output(i) + delta_sat(i);
+                double s = 1, bound = 0;
+                if(q > upper_x(i) + 1e-9 || q < lower_x(i) - 1e-9){
+                    // The compensation of the saturated joints alone violates a bound
+                    s = 0;
+                    bound = q > upper_x(i) ? upper_x(i) : lower_x(i);
+                }
+                else if(fabs(delta_task(i)) >= 1e-12){
+                    bound = delta_task(i) > 0 ? upper_x(i) : lower_x(i);
+                    s = max(0.0, (bound - q) / delta_task(i));
+                }
+                if(s < scale){
+                    scale = s;
+                    critical_joint = i;
+                    sat_value(i) = bound;
+                }
+            }
+
+            if(critical_joint < 0){
+                delta = delta_sat + delta_task;
+                task_feasible = true;
+                break;
+            }
+
+            // Remember the solution with the largest scaling factor, then saturate the critical joint at its bound and try again
+            if(scale > scale_best){
+                scale_best = scale;
+                delta_best = delta_sat + scale * delta_task;
+                proj_mat_best = proj_mat_sat;
+                saturated_best = saturated;
+            }
+            saturated[critical_joint] = true;
+            n_saturated++;
+        }
+
+        if(task_feasible)
+            task_scales[prio] = 1;
+        else{
+            // Apply the scaled solution with the largest scaling factor. Joints that have been saturated after this solution are free again
+            delta = delta_best;
+            proj_mat_sat = proj_mat_best;
+            saturated = saturated_best;
+            n_saturated = std::count(saturated.begin(), saturated.end(), true);
+            task_scales[prio] = scale_best;
+        }
+        solver_output += delta;
+
+        // Nullspace projector for the next priority. Use the undamped, unweighted inverse to have a correct projection. Rows with zero weight do not constrain the nullspace
+        A_proj_w.noalias() = qp.A * proj_mat_sat;
+        A_proj_w = row_weights.asDiagonal() * A_proj_w;
+        pseudoInverse(A_proj_w, A_proj_inv, A_proj_inv_damped);
+        proj_mat = proj_mat_sat;
+        proj_mat.noalias() -= A_proj_inv * A_proj_w;
+    }
+}
+
+void SNSSolver::setMinEigenvalue(double _min_eigenvalue){
+    if(_min_eigenvalue <= 0){
+        throw std::invalid_argument("Min. Eigenvalue has to be > 0!");
+    }
+    min_eigenvalue = _min_eigenvalue;
+}
+
+void SNSSolver::setMaxSolverOutputNorm(double norm_max){
+    if(norm_max <= 0){
+        throw std::invalid_argument("Norm Max has to be > 0!");
+    }
+    max_solver_output_norm = norm_max;
+}
+
+}
@@ -0,0 +1,96 @@
+#ifndef WBC_SOLVERS_SNS_SOLVER_HPP
+#define WBC_SOLVERS_SNS_SOLVER_HPP
+
+#include <base/Eigen.hpp>
+#include <vector>
+#include "../../core/QPSolver.hpp"
+
+namespace wbc{
+
+class HierarchicalQP;
+
+/**
+ * @brief Implementation of a hierarchical weighted damped least squares solver with joint limits, based on the Saturation in the Null Space (SNS) approach of
+ * Flacco, F., De Luca, A., Khatib, O. “Prioritized multi-task motion control of redundant robots under hard joint constraints.” IEEE/RSJ International Conference on Intelligent Robots and Systems (2012): 3000 - 3007.
+ *
+ * Like HierarchicalLSSolver, it solves the tasks of each priority level in the nullspace of the higher priorities, using the constraint matrices A, the lower bound of the
+ * constraint variables as task reference, and the constraint and joint weights. Additionally, it enforces the joint bounds lower_x/upper_x of each priority level, which
+ * apply to this level and all lower levels. On each priority, the solver iterates as follows:
+ *  1. Move the saturated joints to their bounds within the nullspace of the higher priorities and compute the (damped, weighted) least squares solution of the
+ *     current task with the remaining joints, i.e., in the nullspace of the higher priorities and the saturated joints
+ *  2. If no joint bound is violated, accept the solution. Otherwise, compute the largest scaling factor of the task reference, so that all joints stay within their bounds
+ *  3. Remember the solution with the largest scaling factor and saturate the joint that limits the scaling factor, i.e., clamp it to the violated bound and remove it from
+ *     the problem of this and all lower priorities
+ *  4. If the task cannot be fulfilled anymore with the remaining joints, apply the scaled solution with the largest scaling factor
+ *
+ * Since the motion of the saturated joints is computed in the nullspace of the higher priorities, the higher priorities are not affected by the lower ones. In contrast to
+ * an active set QP solver, the number of iterations is bounded by the number of joints per priority. The scaling factor of each priority is available via getTaskScales().
+ */
+class SNSSolver : public QPSolver{
+public:
+    SNSSolver();
+    virtual ~SNSSolver();
+
+    /**
+     * @brief solve Compute optimal control solution
+     * @param constraints Description of the hierarchical quadratic program to solve. Each vector entry correspond to a stage in the hierarchy where
+     *                    the first entry has the highest priority. The solver will only use the constraint matrices A, the lower bound of the
+     *                    constraint variables, the constraint and joint weight vectors and the joint bounds.
+     * @param x solution
+     */
+    virtual void solve(const wbc::HierarchicalQP &hierarchical_qp, base::VectorXd &solver_output);
+
+    /**
+     * @brief setMinEigenvalue Sets the minimum Eigenvalue that is allowed to occur in normal (undamped) matrix inversion. This matrix inversion is used for
+     *        nullspace projection. It is also the threshold for the rank of the task matrix, which decides if a task can still be fulfilled after saturating a joint.
+     * @param min_eigenvalue Has to be > 0
+     */
+    void setMinEigenvalue(double min_eigenvalue);
+
+    /** Return the min eigenvalue term.*/
+    double getMinEigenvalue(){return min_eigenvalue;}
+
+    /**
+     * @brief setMaxSolverOutputNorm Sets the maximum norm term. This value will be used to compute a suitable damping factor for matrix inversion.
+     * @param norm_max Maximum output norm. Has to be > 0!
+     */
+    void setMaxSolverOutputNorm(double norm_max);
+
+    /** Return the maximum norm term.*/
+    double getMaxSolverOutputNorm(){return max_solver_output_norm;}
+
+    /** Return the task scaling factor (0..1) of each priority in the last call to solve(). 1 means that the task reference has been fully applied*/
+    const std::vector<double>& getTaskScales(){return task_scales;}
+
+    /** Return the number of saturated joints in the last call to solve()*/
+    uint noOfSaturatedJoints(){return n_saturated;}
+
+protected:
+    uint no_of_joints;
+    double min_eigenvalue;
+    double max_solver_output_norm;
+    std::vector<double> task_scales;
+    uint n_saturated;
+
+    base::MatrixXd proj_mat, proj_mat_sat, proj_mat_best;       /** Nullspace projector of the higher priorities, additionally of the saturated joints, and of the best scaled solution*/
+    base::MatrixXd A_proj_w, A_proj_inv, A_proj_inv_damped, sat_proj, sat_proj_inv, sat_proj_inv_damped;
+    base::MatrixXd U, V;
+    base::VectorXd s_vals, tmp;
+    base::VectorXd lower_x, upper_x, row_weights, joint_weights;
+    base::VectorXd y_comp, delta, delta_best, delta_task, delta_sat;
+    base::VectorXd sat_value, sat_diff;                         /** Bound of each saturated joint and remaining distance of the saturated joints to their bound*/
+    base::VectorXd row_tmp, joint_tmp;
+    std::vector<bool> saturated, saturated_best;
+
+    /** Resize all member variables. The workspaces of the saturation loop have a fixed size of n_joints, so that solve() does not allocate while saturating joints*/
+    void configure(const uint n_joints);
+
+    /**
+     * @brief Compute undamped and damped pseudo inverse of the given matrix using SVD. The damping is computed from the smallest singular value and the max. solver output norm.
+     * @return Numerical rank of the matrix, i.e. number of singular values >= min_eigenvalue
+     */
+    uint pseudoInverse(const base::MatrixXd& mat, base::MatrixXd& mat_inv, base::MatrixXd& mat_inv_damped);
+};
+}
+#endif
+
@@ -19,6 +19,7 @@ int svd_eigen_decomposition(const base::MatrixXd& A,
         int i(-1),its(-1),j(-1),jj(-1),k(-1),nm=0;
         int ppi(0);
         bool flag,maxarg1,maxarg2;
+        bool max_iter_reached = false;
         double anorm(0),c(0),f(0),h(0),s(0),scale(0),x(0),y(0),z(0),g(0);
 
         /* Householder reduction to bidiagonal form. */
@@ -218,6 +219,7 @@ int svd_eigen_decomposition(const base::MatrixXd& A,
                 tmp(k)=f;
                 S(k)=x;
             }
+            if (its > maxiter) max_iter_reached = true;
         }
 
         //Sort eigen values:
@@ -244,7 +246,7 @@ int svd_eigen_decomposition(const base::MatrixXd& A,
             }
         }
 
-        if (its == maxiter)
+        if (max_iter_reached)
             return (-2);
         else
             return (0);
@@ -50,6 +50,10 @@ inline double SIGN(double a,double b) {
     return ((b) >= 0.0 ? fabs(a) : -fabs(a));
 }
 
+/**
+ * @brief Singular value decomposition A = U*S*V^T. maxiter is the maximum number of QR iterations per singular value.
+ * @return 0 on success, -2 if maxiter has been reached for at least one singular value (the decomposition is then approximate), other negative values on numerical failure
+ */
 int svd_eigen_decomposition(const base::MatrixXd& A,
                             base::MatrixXd& U,
                             base::VectorXd& S,
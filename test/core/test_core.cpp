@@ -2,6 +2,14 @@
 #include <core/ConstraintConfig.hpp>
 #include <core/PluginLoader.hpp>
 #include <core/RobotModelFactory.hpp>
+#include <core/HessianAssembler.hpp>
+#include <core/BoxQPSolver.hpp>
+#include <core/HierarchicalQPCompactor.hpp>
+#include <core/TripleBuffer.hpp>
+#include <core/ThreadPool.hpp>
+#include <core/Profiler.hpp>
+#include <sstream>
+#include <thread>
 
 using namespace std;
 using namespace wbc;
@@ -93,3 +101,241 @@ BOOST_AUTO_TEST_CASE(robot_model_factory){
     BOOST_CHECK(model != 0);
 }
 
+
+BOOST_AUTO_TEST_CASE(hessian_assembler){
+
+    // Compare structured Hessian assembly with dense computation
+    const int nj = 10;
+    HessianAssembler assembler;
+    assembler.reset(nj);
+
+    base::VectorXd col_weights = base::VectorXd::Random(nj).cwiseAbs();
+
+    // Dense constraint with some zero columns (joints that are not part of the kinematic chain)
+    base::MatrixXd A = base::MatrixXd::Random(6,nj), Aw;
+    A.col(2).setZero();
+    A.col(7).setZero();
+    base::VectorXd w = base::VectorXd::Random(6).cwiseAbs(), y = base::VectorXd::Random(6);
+    assembler.addConstraint(A, w, col_weights, y, Aw);
+
+    // Joint space selector
+    std::vector<int> joint_idx = {3,5,8};
+    base::MatrixXd A_sel = base::MatrixXd::Zero(3,nj), Aw_sel;
+    for(int k = 0; k < 3; k++)
+        A_sel(k,joint_idx[k]) = 1;
+    base::VectorXd w_sel = base::VectorXd::Random(3).cwiseAbs(), y_sel = base::VectorXd::Random(3);
+    assembler.addSelector(joint_idx, w_sel, col_weights, y_sel, Aw_sel);
+    assembler.addDiagonal(1e-8);
+
+    base::MatrixXd Aw_dense = w.asDiagonal()*A*col_weights.asDiagonal();
+    base::MatrixXd Aw_sel_dense = w_sel.asDiagonal()*A_sel*col_weights.asDiagonal();
+    base::MatrixXd H_dense = Aw_dense.transpose()*Aw_dense + Aw_sel_dense.transpose()*Aw_sel_dense;
+    H_dense.diagonal().array() += 1e-8;
+    base::VectorXd g_dense = -Aw_dense.transpose()*y - Aw_sel_dense.transpose()*y_sel;
+
+    base::MatrixXd H(nj,nj);
+    base::VectorXd g(nj);
+    assembler.get(H, g);
+    BOOST_CHECK((H - H_dense).norm() < 1e-12);
+    BOOST_CHECK((g - g_dense).norm() < 1e-12);
+    BOOST_CHECK((Aw - Aw_dense).norm() < 1e-12);
+    BOOST_CHECK((Aw_sel - Aw_sel_dense).norm() < 1e-12);
+
+    // Invalid constraint size
+    BOOST_CHECK_THROW(assembler.addConstraint(base::MatrixXd(6,nj+1), w, col_weights, y, Aw), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(box_qp_solver){
+
+    // Random positive definite QP with box constraints. Check the KKT conditions of the solution
+    const int n = 10;
+    BoxQPSolver solver;
+    BOOST_CHECK_THROW(solver.setMaxIterations(0), std::invalid_argument);
+    BOOST_CHECK_THROW(solver.setTolerance(0), std::invalid_argument);
+
+    base::MatrixXd M = base::MatrixXd::Random(n,n);
+    base::MatrixXd H = M.transpose()*M;
+    H.diagonal().array() += 1e-3;
+    base::VectorXd g = base::VectorXd::Random(n)*10;
+    base::VectorXd lower_x = base::VectorXd::Constant(n,-0.5), upper_x = base::VectorXd::Constant(n,0.5);
+
+    base::VectorXd x;
+    for(int k = 0; k < 2; k++){ // Second call is warm started
+        BOOST_CHECK(solver.solve(H, g, lower_x, upper_x, x));
+        base::VectorXd grad = H*x + g;
+        for(int i = 0; i < n; i++){
+            BOOST_CHECK(x(i) >= lower_x(i) && x(i) <= upper_x(i));
+            if(x(i) > lower_x(i) && x(i) < upper_x(i))
+                BOOST_CHECK(fabs(grad(i)) < 1e-6);
+            else if(x(i) == lower_x(i))
+                BOOST_CHECK(grad(i) > -1e-6);
+            else
+                BOOST_CHECK(grad(i) < 1e-6);
+        }
+    }
+    BOOST_CHECK_EQUAL(solver.noOfIterations(), 0);
+
+    // Without bounds, the solution is the unconstrained minimum
+    BOOST_CHECK(solver.solve(H, g, base::VectorXd(), base::VectorXd(), x));
+    BOOST_CHECK((H*x + g).norm() < 1e-6);
+
+    // Badly scaled problem: The rounding error of the gradient exceeds the default tolerance, the solver has to converge anyway
+    base::MatrixXd H_scaled = 1e8*H;
+    base::VectorXd g_scaled = 1e8*g;
+    BOOST_CHECK(solver.solve(H_scaled, g_scaled, lower_x, upper_x, x));
+    BOOST_CHECK(solver.noOfIterations() < solver.getMaxIterations());
+
+    // Invalid input
+    BOOST_CHECK_THROW(solver.solve(H, g, base::VectorXd::Zero(n+1), upper_x, x), std::invalid_argument);
+    BOOST_CHECK_THROW(solver.solve(H, g, upper_x, lower_x, x), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(hierarchical_qp_compactor){
+
+    // Rows with zero weight have to be removed from the QP, all other quantities have to be kept
+    const int nj = 5;
+    HierarchicalQP hqp;
+    hqp.resize(2);
+    for(uint prio = 0; prio < hqp.size(); prio++){
+        hqp[prio].resize(4,nj);
+        hqp[prio].A.setRandom();
+        hqp[prio].lower_y.setRandom();
+        hqp[prio].upper_y = hqp[prio].lower_y;
+        hqp[prio].H.setIdentity();
+        hqp[prio].g.setZero();
+        hqp[prio].lower_x.resize(0);
+        hqp[prio].upper_x.resize(0);
+    }
+    hqp[0].Wy << 1,0,0.5,0;
+    hqp[1].Wy.setZero();
+    hqp.Wq.setOnes(nj);
+
+    HierarchicalQPCompactor compactor;
+    const HierarchicalQP& compact_hqp = compactor.compact(hqp);
+    BOOST_CHECK_EQUAL(compact_hqp.size(), 2);
+    BOOST_CHECK_EQUAL(compact_hqp[0].nc, 2);
+    BOOST_CHECK_EQUAL(compact_hqp[1].nc, 0);
+    BOOST_CHECK(compact_hqp[0].A.row(0) == hqp[0].A.row(0));
+    BOOST_CHECK(compact_hqp[0].A.row(1) == hqp[0].A.row(2));
+    BOOST_CHECK(compact_hqp[0].lower_y(1) == hqp[0].lower_y(2));
+    BOOST_CHECK(compact_hqp[0].Wy(1) == 0.5);
+    BOOST_CHECK(compact_hqp[0].H == hqp[0].H);
+    BOOST_CHECK(compactor.rowMap(0) == std::vector<int>({0,2}));
+    BOOST_CHECK(compactor.isActiveRow(0,2));
+    BOOST_CHECK(!compactor.isActiveRow(0,3));
+
+    base::VectorXd lambda(2), lambda_full;
+    lambda << 3,4;
+    compactor.expand(0, lambda, lambda_full);
+    BOOST_CHECK(lambda_full == Eigen::Vector4d(3,0,4,0));
+
+    // Reactivate all rows
+    hqp[1].Wy.setOnes();
+    BOOST_CHECK_EQUAL(compactor.compact(hqp)[1].nc, 4);
+    BOOST_CHECK(compactor.compactQP()[1].A == hqp[1].A);
+
+    BOOST_CHECK_THROW(compactor.rowMap(2), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(triple_buffer){
+
+    // Producer publishes vectors with all entries equal. The consumer must only ever see consistent vectors with non-decreasing values
+    const int n = 100, n_publish = 100000;
+    TripleBuffer<base::VectorXd> buffer;
+    buffer.init(base::VectorXd::Zero(n));
+    BOOST_CHECK(!buffer.fetch());
+
+    std::thread producer([&](){
+        for(int i = 1; i <= n_publish; i++){
+            buffer.writeBuffer().setConstant(i);
+            buffer.publish();
+        }
+    });
+
+    double last = 0;
+    bool consistent = true;
+    while(last < n_publish){
+        if(!buffer.fetch())
+            continue;
+        const base::VectorXd& v = buffer.readBuffer();
+        consistent &= (v.array() == v(0)).all() && v(0) >= last;
+        last = v(0);
+    }
+    producer.join();
+    BOOST_CHECK(consistent);
+    BOOST_CHECK(!buffer.fetch());
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool){
+
+    ThreadPool pool(4);
+    BOOST_CHECK_EQUAL(pool.noOfThreads(), 4);
+
+    // Each task has to be executed exactly once, also with unbalanced task durations and repeated calls
+    const uint n = 1000;
+    std::vector<int> count(n, 0);
+    for(int k = 0; k < 10; k++){
+        pool.parallelFor(n, [&](uint i){
+            if(i < n/4)
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
+            count[i]++;
+        });
+    }
+    for(uint i = 0; i < n; i++)
+        BOOST_CHECK_EQUAL(count[i], 10);
+
+    // The first exception is rethrown in the calling thread, the pool stays usable
+    BOOST_CHECK_THROW(pool.parallelFor(n, [](uint i){if(i == 10) throw std::runtime_error("Task failed");}), std::runtime_error);
+    pool.parallelFor(n, [&](uint i){count[i] = 0;});
+    for(uint i = 0; i < n; i++)
+        BOOST_CHECK_EQUAL(count[i], 0);
+
+    // Many short calls back to back with more threads than tasks: Workers that wake up late must not run a task with an outdated job
+    ThreadPool large_pool(16);
+    std::atomic<uint> n_calls(0);
+    for(int k = 0; k < 10000; k++)
+        large_pool.parallelFor(2, [&](uint){n_calls++;});
+    BOOST_CHECK_EQUAL(n_calls.load(), 20000);
+}
+
+BOOST_AUTO_TEST_CASE(profiler){
+
+    Profiler profiler(100);
+    for(int i = 0; i < 150; i++)
+        profiler.record(i%2 ? "odd" : "even", i == 149 ? "last \"event\"" : 0, i*1000, (i+1)*1000);
+
+    // Only the latest events are kept in the ring buffer
+    BOOST_CHECK_EQUAL(profiler.noOfRecordedEvents(), 150);
+    std::vector<ProfilerEvent> events = profiler.getEvents();
+    BOOST_CHECK_EQUAL(events.size(), 100);
+    BOOST_CHECK_EQUAL(events.front().start_ns, 50000);
+    BOOST_CHECK_EQUAL(events.back().start_ns, 149000);
+    BOOST_CHECK_EQUAL(std::string(events.back().detail), "last \"event\"");
+
+    std::map<std::string, ProfilerHistogram> histograms = profiler.histograms();
+    BOOST_CHECK_EQUAL(histograms["even"].count, 50);
+    BOOST_CHECK_EQUAL(histograms["odd"].count, 50);
+    BOOST_CHECK_EQUAL(histograms["odd"].min_ns, 52000);
+    BOOST_CHECK_EQUAL(histograms["odd"].max_ns, 150000);
+    BOOST_CHECK_EQUAL(histograms["odd"].meanNs(), 101000);
+    BOOST_CHECK(histograms["odd"].quantileNs(0.5) >= 65536 && histograms["odd"].quantileNs(0.5) <= 131072);
+
+    std::stringstream trace;
+    profiler.writeChromeTrace(trace);
+    BOOST_CHECK(trace.str().find("{\"traceEvents\":[") == 0);
+    BOOST_CHECK(trace.str().find("\"args\":{\"detail\":\"last \\\"event\\\"\"}") != std::string::npos);
+
+    profiler.clear();
+    BOOST_CHECK(profiler.getEvents().empty());
+
+    // Concurrent recording from several threads
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; t++)
+        threads.push_back(std::thread([&](){
+            for(int i = 0; i < 20; i++)
+                profiler.record("thread", 0, profiler.now(), 1);
+        }));
+    for(auto& t : threads)
+        t.join();
+    BOOST_CHECK_EQUAL(profiler.getEvents().size(), 80);
+}
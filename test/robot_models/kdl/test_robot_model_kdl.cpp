@@ -1,7 +1,11 @@
 #include <boost/test/unit_test.hpp>
 #include "robot_models/kdl/RobotModelKDL.hpp"
 #include "robot_models/kdl/KinematicChainKDL.hpp"
+#include "robot_models/kdl/RobotModelKDLFixed.hpp"
+#include "robot_models/kdl/ChainDerivatives.hpp"
+#include <kdl/chainidsolver_recursive_newton_euler.hpp>
 #include "core/RobotModelConfig.hpp"
+#include "core/BatchRobotModel.hpp"
 #include <kdl/chainfksolverpos_recursive.hpp>
 #include <kdl/chainfksolvervel_recursive.hpp>
 #include <kdl/chainjnttojacsolver.hpp>
@@ -457,3 +461,275 @@ BOOST_AUTO_TEST_CASE(floating_base_test)
 }
 
 
+
+BOOST_AUTO_TEST_CASE(reconfigure_test)
+{
+    /**
+     * Check that changing contact points and actuated joints via reconfigure() does not invalidate the model, and that
+     * structural changes fall back to a full configuration
+     */
+
+    srand(time(NULL));
+
+    RobotModelKDL robot_model;
+    RobotModelConfig config("../../../../models/kuka/urdf/kuka_iiwa.urdf");
+    BOOST_CHECK(robot_model.configure(config) == true);
+
+    base::samples::Joints joint_state;
+    joint_state.resize(robot_model.noOfActuatedJoints());
+    joint_state.names = robot_model.actuatedJointNames();
+    for(int i = 0; i < robot_model.noOfActuatedJoints(); i++)
+        joint_state[i].position = double(rand())/RAND_MAX;
+    joint_state.time = base::Time::now();
+    robot_model.update(joint_state);
+    base::MatrixXd jac = robot_model.spaceJacobian("kuka_lbr_l_link_0", "kuka_lbr_l_tcp");
+
+    // Change contact points
+    config.contact_points.names = {"kuka_lbr_l_tcp"};
+    config.contact_points.elements = {1};
+    BOOST_CHECK(robot_model.reconfigure(config) == true);
+    BOOST_CHECK(robot_model.getActiveContacts().names == config.contact_points.names);
+    BOOST_CHECK(robot_model.getActiveContacts().elements == config.contact_points.elements);
+    BOOST_CHECK((robot_model.spaceJacobian("kuka_lbr_l_link_0", "kuka_lbr_l_tcp") - jac).norm() < 1e-9);
+
+    // Change actuated joints
+    config.actuated_joint_names = robot_model.jointNames();
+    config.actuated_joint_names.pop_back();
+    BOOST_CHECK(robot_model.reconfigure(config) == true);
+    BOOST_CHECK(robot_model.noOfActuatedJoints() == 6);
+    BOOST_CHECK(robot_model.noOfJoints() == 7);
+    BOOST_CHECK(robot_model.selectionMatrix().rows() == 6);
+    BOOST_CHECK(robot_model.selectionMatrix().cols() == 7);
+    BOOST_CHECK((robot_model.spaceJacobian("kuka_lbr_l_link_0", "kuka_lbr_l_tcp") - jac).norm() < 1e-9);
+
+    // Invalid contact point: Reconfiguration fails, previous configuration is kept
+    RobotModelConfig invalid_config = config;
+    invalid_config.contact_points.names = {"kuka_lbr_l_link_X"};
+    BOOST_CHECK(robot_model.reconfigure(invalid_config) == false);
+    BOOST_CHECK(robot_model.getActiveContacts().names == config.contact_points.names);
+    BOOST_CHECK(robot_model.noOfActuatedJoints() == 6);
+
+    // Structural change: Blacklist a joint, which requires reparsing the model
+    config.actuated_joint_names.clear();
+    config.joint_blacklist = {"kuka_lbr_l_joint_7"};
+    BOOST_CHECK(robot_model.reconfigure(config) == true);
+    BOOST_CHECK(robot_model.noOfJoints() == 6);
+    BOOST_CHECK(robot_model.hasJoint("kuka_lbr_l_joint_7") == false);
+}
+
+BOOST_AUTO_TEST_CASE(com_jacobian_test)
+{
+    /**
+     * Verify the CoM Jacobian against the numerical derivative of the CoM position and check that the linear part of the
+     * centroidal momentum matrix equals total mass times CoM Jacobian
+     */
+
+    srand(time(NULL));
+
+    RobotModelKDL robot_model;
+    BOOST_CHECK(robot_model.configure(RobotModelConfig("../../../../models/kuka/urdf/kuka_iiwa.urdf")) == true);
+    const uint nj = robot_model.noOfJoints();
+
+    base::samples::Joints joint_state;
+    joint_state.resize(nj);
+    joint_state.names = robot_model.jointNames();
+    for(uint i = 0; i < nj; i++){
+        joint_state[i].position = double(rand())/RAND_MAX;
+        joint_state[i].speed = double(rand())/RAND_MAX;
+        joint_state[i].acceleration = 0;
+    }
+    joint_state.time = base::Time::now();
+    robot_model.update(joint_state);
+
+    base::MatrixXd com_jac = robot_model.comJacobian();
+    base::MatrixXd cmm = robot_model.centroidalMomentumMatrix();
+    base::samples::RigidBodyStateSE3 com = robot_model.centerOfMass();
+    BOOST_CHECK(com_jac.rows() == 3);
+    BOOST_CHECK(com_jac.cols() == nj);
+    BOOST_CHECK(cmm.rows() == 6);
+    BOOST_CHECK(cmm.cols() == nj);
+
+    // Numerical differentiation of the CoM position
+    const double dq = 1e-6;
+    for(uint i = 0; i < nj; i++){
+        base::samples::Joints js = joint_state;
+        js[i].position += dq;
+        robot_model.update(js);
+        base::Vector3d diff = (robot_model.centerOfMass().pose.position - com.pose.position)/dq;
+        for(int j = 0; j < 3; j++)
+            BOOST_CHECK(fabs(diff(j) - com_jac(j,i)) < 1e-4);
+    }
+
+    // CoM velocity is consistent with the CoM Jacobian
+    base::VectorXd qd(nj);
+    for(uint i = 0; i < nj; i++)
+        qd(i) = joint_state[i].speed;
+    BOOST_CHECK((com_jac*qd - com.twist.linear).norm() < 1e-9);
+
+    // Linear momentum rows are m * Jcom
+    double total_mass = 0;
+    KDL::Tree tree;
+    BOOST_CHECK(kdl_parser::treeFromFile("../../../../models/kuka/urdf/kuka_iiwa.urdf", tree));
+    for(auto it : tree.getSegments())
+        total_mass += GetTreeElementSegment(it.second).getInertia().getMass();
+    BOOST_CHECK((cmm.topRows<3>() - total_mass*com_jac).norm() < 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(batch_robot_model_test)
+{
+    /**
+     * Compare the results of the batch evaluation with the results of a single robot model for a set of random configurations
+     */
+
+    srand(time(NULL));
+
+    RobotModelConfig config("../../../../models/kuka/urdf/kuka_iiwa.urdf");
+    RobotModelKDL robot_model;
+    BOOST_CHECK(robot_model.configure(config) == true);
+
+    BatchRobotModel batch_model(4);
+    BOOST_CHECK(batch_model.configure(config) == true);
+    BOOST_CHECK(batch_model.jointNames() == robot_model.jointNames());
+
+    const uint n = 100, nj = batch_model.noOfJoints();
+    base::MatrixXd q(n, nj), qd(n, nj);
+    for(uint i = 0; i < n; i++){
+        for(uint j = 0; j < nj; j++){
+            q(i,j) = double(rand())/RAND_MAX;
+            qd(i,j) = double(rand())/RAND_MAX;
+        }
+    }
+
+    base::MatrixXd poses, jacobians, inertia_matrices, bias_forces;
+    batch_model.forwardKinematics(q, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", poses);
+    batch_model.spaceJacobians(q, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", jacobians);
+    batch_model.jointSpaceInertiaMatrices(q, inertia_matrices);
+    batch_model.biasForces(q, qd, bias_forces);
+
+    BOOST_CHECK(poses.rows() == n && poses.cols() == 7);
+    BOOST_CHECK(jacobians.rows() == 6*n && jacobians.cols() == nj);
+    BOOST_CHECK(inertia_matrices.rows() == nj*n && inertia_matrices.cols() == nj);
+    BOOST_CHECK(bias_forces.rows() == n && bias_forces.cols() == nj);
+
+    base::samples::Joints joint_state;
+    joint_state.resize(nj);
+    joint_state.names = robot_model.jointNames();
+    for(uint i = 0; i < n; i++){
+        for(uint j = 0; j < nj; j++){
+            joint_state[j].position = q(i,j);
+            joint_state[j].speed = qd(i,j);
+            joint_state[j].acceleration = 0;
+        }
+        joint_state.time = base::Time::now();
+        robot_model.update(joint_state);
+
+        const base::Pose& pose = robot_model.rigidBodyState("kuka_lbr_l_link_0", "kuka_lbr_l_tcp").pose;
+        BOOST_CHECK((poses.block<1,3>(i,0).transpose() - pose.position).norm() < 1e-9);
+        BOOST_CHECK((poses.block<1,4>(i,3).transpose() - pose.orientation.coeffs()).norm() < 1e-9);
+        BOOST_CHECK((jacobians.block(6*i,0,6,nj) - robot_model.spaceJacobian("kuka_lbr_l_link_0", "kuka_lbr_l_tcp")).norm() < 1e-9);
+        BOOST_CHECK((inertia_matrices.block(nj*i,0,nj,nj) - robot_model.jointSpaceInertiaMatrix()).norm() < 1e-9);
+        BOOST_CHECK((bias_forces.row(i).transpose() - robot_model.biasForces()).norm() < 1e-9);
+    }
+
+    // Invalid number of columns
+    base::MatrixXd q_invalid(n, nj+1);
+    BOOST_CHECK_THROW(batch_model.spaceJacobians(q_invalid, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", jacobians), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(fixed_size_model_test)
+{
+    /**
+     * Compare the kinematics of the fixed size model with the results of the dynamic size KDL model
+     */
+
+    srand(time(NULL));
+
+    RobotModelConfig config("../../../../models/kuka/urdf/kuka_iiwa.urdf");
+    RobotModelKDL robot_model;
+    RobotModelKDLFixed<7> robot_model_fixed;
+    BOOST_CHECK(robot_model.configure(config) == true);
+    BOOST_CHECK(robot_model_fixed.configure(config) == true);
+
+    const std::string root = "kuka_lbr_l_link_0", tip = "kuka_lbr_l_tcp";
+    base::samples::Joints joint_state;
+    joint_state.resize(robot_model.noOfJoints());
+    joint_state.names = robot_model.jointNames();
+    for(int n = 0; n < 10; n++){
+        for(size_t i = 0; i < joint_state.size(); i++){
+            joint_state[i].position = double(rand())/RAND_MAX;
+            joint_state[i].speed = double(rand())/RAND_MAX;
+            joint_state[i].acceleration = double(rand())/RAND_MAX;
+        }
+        joint_state.time = base::Time::now();
+        robot_model.update(joint_state);
+        robot_model_fixed.update(joint_state);
+
+        base::samples::RigidBodyStateSE3 rbs = robot_model.rigidBodyState(root, tip);
+        base::samples::RigidBodyStateSE3 rbs_fixed = robot_model_fixed.rigidBodyState(root, tip);
+        BOOST_CHECK((rbs.pose.position - rbs_fixed.pose.position).norm() < 1e-9);
+        BOOST_CHECK(rbs.pose.orientation.angularDistance(rbs_fixed.pose.orientation) < 1e-9);
+        BOOST_CHECK((rbs.twist.linear - rbs_fixed.twist.linear).norm() < 1e-9);
+        BOOST_CHECK((rbs.twist.angular - rbs_fixed.twist.angular).norm() < 1e-9);
+        BOOST_CHECK((rbs.acceleration.linear - rbs_fixed.acceleration.linear).norm() < 1e-9);
+        BOOST_CHECK((rbs.acceleration.angular - rbs_fixed.acceleration.angular).norm() < 1e-9);
+        BOOST_CHECK((robot_model.spaceJacobian(root, tip) - robot_model_fixed.spaceJacobian(root, tip)).norm() < 1e-9);
+        BOOST_CHECK((robot_model.jacobianDot(root, tip) - robot_model_fixed.jacobianDot(root, tip)).norm() < 1e-9);
+    }
+
+    // Chains with a different number of joints are forwarded to the dynamic size implementation
+    BOOST_CHECK((robot_model.spaceJacobian(root, "kuka_lbr_l_link_3") - robot_model_fixed.spaceJacobian(root, "kuka_lbr_l_link_3")).norm() < 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(chain_derivatives_test)
+{
+    /**
+     * Compare the inverse dynamics of the fixed size chain with KDL and the analytic derivatives (Jacobian and inverse dynamics) with finite differences
+     */
+
+    srand(time(NULL));
+
+    KDL::Tree tree;
+    KDL::Chain chain;
+    BOOST_CHECK(kdl_parser::treeFromFile("../../../../models/kuka/urdf/kuka_iiwa.urdf", tree));
+    BOOST_CHECK(tree.getChain("kuka_lbr_l_link_0", "kuka_lbr_l_tcp", chain));
+
+    typedef FixedSizeChain<7>::JointVector JointVector;
+    FixedSizeChain<7> fixed_chain(chain);
+    ChainDerivatives<7> derivatives(fixed_chain);
+
+    JointVector q = JointVector::Random(), qd = JointVector::Random(), qdd = JointVector::Random();
+    fixed_chain.update(q, qd, qdd);
+    JointVector tau = fixed_chain.inverseDynamics();
+
+    KDL::JntArray q_kdl(7), qd_kdl(7), qdd_kdl(7), tau_kdl(7);
+    q_kdl.data = q;
+    qd_kdl.data = qd;
+    qdd_kdl.data = qdd;
+    KDL::ChainIdSolver_RNE id_solver(chain, KDL::Vector(0,0,-9.81));
+    BOOST_CHECK(id_solver.CartToJnt(q_kdl, qd_kdl, qdd_kdl, KDL::Wrenches(chain.getNrOfSegments(), KDL::Wrench::Zero()), tau_kdl) >= 0);
+    BOOST_CHECK((tau - tau_kdl.data).norm() < 1e-6);
+
+    derivatives.update(q, qd, qdd);
+    BOOST_CHECK((derivatives.inverseDynamics() - tau).norm() < 1e-9);
+
+    fixed_chain.calculateJacobianDerivatives();
+    FixedSizeChain<7>::Jacobian jac = fixed_chain.jacobian();
+    std::vector<FixedSizeChain<7>::Jacobian, Eigen::aligned_allocator<FixedSizeChain<7>::Jacobian> > jac_derivatives;
+    for(int i = 0; i < 7; i++)
+        jac_derivatives.push_back(fixed_chain.jacobianDerivative(i));
+
+    const double h = 1e-7;
+    for(int i = 0; i < 7; i++){
+        JointVector dq = JointVector::Zero();
+        dq(i) = h;
+
+        fixed_chain.update(q + dq, qd, qdd);
+        BOOST_CHECK(((fixed_chain.jacobian() - jac)/h - jac_derivatives[i]).norm() < 1e-5);
+        JointVector dtau_dq = (fixed_chain.inverseDynamics() - tau)/h;
+        BOOST_CHECK((dtau_dq - derivatives.inverseDynamicsDerivativeQ().col(i)).norm() < 1e-4);
+
+        fixed_chain.update(q, qd + dq, qdd);
+        JointVector dtau_dqd = (fixed_chain.inverseDynamics() - tau)/h;
+        BOOST_CHECK((dtau_dqd - derivatives.inverseDynamicsDerivativeQd().col(i)).norm() < 1e-4);
+    }
+}
@@ -91,3 +91,57 @@ BOOST_AUTO_TEST_CASE(simple_test){
         BOOST_CHECK(fabs(ydd[i+3] - ref.acceleration.angular[i]) < 1e5);
     }
 }
+
+BOOST_AUTO_TEST_CASE(joint_space_test){
+
+    /**
+     * Check if a joint space constraint yields a valid QP on the first update after configure() and if the solver output matches the reference joint accelerations
+     */
+
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config;
+    config.file = "../../../models/kuka/urdf/kuka_iiwa.urdf";
+    BOOST_CHECK_EQUAL(robot_model->configure(config), true);
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->jointNames();
+    for(auto n : robot_model->jointNames()){
+        base::JointState js;
+        js.position = 0.1;
+        js.speed = 0;
+        joint_state.elements.push_back(js);
+    }
+    joint_state.time = base::Time::now();
+    BOOST_CHECK_NO_THROW(robot_model->update(joint_state));
+
+    QPSolverPtr solver = std::make_shared<QPOASESSolver>();
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setMaxNoWSR(1000);
+    qpOASES::Options options = dynamic_pointer_cast<QPOASESSolver>(solver)->getOptions();
+    options.printLevel = qpOASES::PL_NONE;
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setOptions(options);
+
+    // Joint space constraint on a subset of the joints, so that the remaining entries of the constraint rows have to be zero
+    vector<string> jnt_names = {robot_model->jointNames()[1], robot_model->jointNames()[3], robot_model->jointNames()[5]};
+    ConstraintConfig jnt_constraint("jnt_acc_ctrl", 0, jnt_names, vector<double>(jnt_names.size(), 1), 1);
+    AccelerationScene wbc_scene(robot_model, solver);
+    BOOST_CHECK_EQUAL(wbc_scene.configure({jnt_constraint}), true);
+
+    base::samples::Joints ref;
+    ref.names = jnt_names;
+    ref.elements.resize(jnt_names.size());
+    for(uint i = 0; i < ref.size(); i++)
+        ref[i].acceleration = 0.1*(i+1);
+    ref.time = base::Time::now();
+    BOOST_CHECK_NO_THROW(wbc_scene.setReference(jnt_constraint.name, ref));
+
+    for(int k = 0; k < 2; k++){
+        const HierarchicalQP& hqp = wbc_scene.update();
+        BOOST_CHECK(hqp[0].H.allFinite());
+        BOOST_CHECK(hqp[0].g.allFinite());
+        base::commands::Joints solver_output;
+        BOOST_CHECK_NO_THROW(solver_output = wbc_scene.solve(hqp));
+        BOOST_CHECK(wbc_scene.getSolverStatus() == solver_success);
+        for(uint i = 0; i < ref.size(); i++)
+            BOOST_CHECK(fabs(solver_output[ref.names[i]].acceleration - ref[i].acceleration) < 1e-6);
+    }
+}
@@ -0,0 +1,112 @@
+#include <boost/test/unit_test.hpp>
+#include "robot_models/kdl/RobotModelKDL.hpp"
+#include "core/RobotModelConfig.hpp"
+#include "scenes/AccelerationSceneTSID.hpp"
+#include "solvers/qpoases/QPOasesSolver.hpp"
+
+using namespace std;
+using namespace wbc;
+
+BOOST_AUTO_TEST_CASE(contact_constraints_test){
+
+    /**
+     * Check if the contact wrenches computed by the WBC scene respect the friction pyramid, unilateral contact and center of pressure constraints of all contacts
+     */
+
+    // Configure floating base robot model with two foot contacts
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config("../../../models/rh5/urdf/rh5_legs.urdf");
+    config.floating_base = true;
+    config.floating_base_state.pose.position = base::Vector3d(0,0,0.87);
+    config.floating_base_state.pose.orientation.setIdentity();
+    config.contact_points.names = {"LLAnkle_FT", "LRAnkle_FT"};
+    config.contact_points.elements = {1,1};
+    BOOST_CHECK_EQUAL(robot_model->configure(config), true);
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->actuatedJointNames();
+    joint_state.elements.resize(robot_model->noOfActuatedJoints());
+    for(auto &js : joint_state.elements){
+        js.position = js.speed = js.acceleration = 0;
+    }
+    joint_state.time = base::Time::now();
+    base::samples::RigidBodyStateSE3 floating_base_state;
+    floating_base_state.pose = config.floating_base_state.pose;
+    floating_base_state.twist.setZero();
+    floating_base_state.acceleration.setZero();
+    floating_base_state.time = base::Time::now();
+    BOOST_CHECK_NO_THROW(robot_model->update(joint_state, floating_base_state));
+
+    // Configure WBC Scene: CoM acceleration task
+    QPSolverPtr solver = std::make_shared<QPOASESSolver>();
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setMaxNoWSR(1000);
+    qpOASES::Options options = dynamic_pointer_cast<QPOASESSolver>(solver)->getOptions();
+    options.printLevel = qpOASES::PL_NONE;
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setOptions(options);
+    ConstraintConfig com_constraint("com_position", 0, "world", "world", "world", 1, {1,1,1});
+    com_constraint.type = com;
+    AccelerationSceneTSID wbc_scene(robot_model, solver);
+    BOOST_CHECK(wbc_scene.configure({com_constraint}));
+
+    // Invalid contact parameters
+    ContactParams params;
+    params.mu = 0;
+    BOOST_CHECK_THROW(wbc_scene.setContactParams(params), std::invalid_argument);
+    params.mu = 0.5;
+    params.n_facets = 2;
+    BOOST_CHECK_THROW(wbc_scene.setContactParams(params), std::invalid_argument);
+    params.n_facets = 8;
+    params.cop_min = base::Vector2d(0.1,-0.05);
+    BOOST_CHECK_THROW(wbc_scene.setContactParams(params), std::invalid_argument);
+    params.cop_min = base::Vector2d(-0.1,-0.05);
+    params.cop_max = base::Vector2d(0.1,0.05);
+    params.min_normal_force = -1;
+    BOOST_CHECK_THROW(wbc_scene.setContactParams(params), std::invalid_argument);
+    params.min_normal_force = 10;
+    BOOST_CHECK_NO_THROW(wbc_scene.setContactParams(params));
+    ContactParams params_right = params;
+    params_right.n_facets = 4;
+    BOOST_CHECK_NO_THROW(wbc_scene.setContactParams("LRAnkle_FT", params_right));
+    BOOST_CHECK_EQUAL(wbc_scene.getContactParams("LLAnkle_FT").n_facets, 8);
+    BOOST_CHECK_EQUAL(wbc_scene.getContactParams("LRAnkle_FT").n_facets, 4);
+
+    base::samples::RigidBodyStateSE3 ref;
+    ref.acceleration.linear = base::Vector3d(0.5, 0.2, 0);
+    ref.acceleration.angular.setZero();
+    wbc_scene.setReference(com_constraint.name, ref);
+
+    const uint nj = robot_model->noOfJoints();
+    const uint na = robot_model->noOfActuatedJoints();
+    const uint ncp = 2;
+    for(int k = 0; k < 2; k++){
+        const bool use_contact_constraints = k == 1;
+        wbc_scene.setUseContactConstraints(use_contact_constraints);
+        const HierarchicalQP& hqp = wbc_scene.update();
+        const uint n_contact_rows = use_contact_constraints ? params.noOfRows() + params_right.noOfRows() : 0;
+        BOOST_CHECK_EQUAL(hqp[0].nc, nj + ncp*6 + n_contact_rows);
+        BOOST_CHECK_EQUAL(hqp[0].nq, nj + na + ncp*6);
+        BOOST_CHECK_NO_THROW(wbc_scene.solve(hqp));
+    }
+
+    // Check the contact wrenches. Forces and torques are expressed in the contact frames
+    const base::samples::Wrenches& wrenches = wbc_scene.getContactWrenches();
+    BOOST_CHECK_EQUAL(wrenches.size(), ncp);
+    for(uint i = 0; i < wrenches.size(); i++){
+        const ContactParams& p = wbc_scene.getContactParams(wrenches.names[i]);
+        const base::Vector3d& f = wrenches[i].force;
+        const base::Vector3d& tau = wrenches[i].torque;
+        BOOST_CHECK(f[2] >= p.min_normal_force - 1e-6);
+        BOOST_CHECK(sqrt(f[0]*f[0] + f[1]*f[1]) <= p.mu*f[2] + 1e-6);
+        BOOST_CHECK(-tau[1] >= p.cop_min[0]*f[2] - 1e-6 && -tau[1] <= p.cop_max[0]*f[2] + 1e-6);
+        BOOST_CHECK(tau[0] >= p.cop_min[1]*f[2] - 1e-6 && tau[0] <= p.cop_max[1]*f[2] + 1e-6);
+    }
+
+    // Inactive contacts have no contact wrench constraints, in particular no lower bound on the normal force
+    ActiveContacts contacts = config.contact_points;
+    contacts[1] = 0;
+    robot_model->setActiveContacts(contacts);
+    BOOST_CHECK_NO_THROW(robot_model->update(joint_state, floating_base_state));
+    const HierarchicalQP& hqp = wbc_scene.update();
+    BOOST_CHECK_EQUAL(hqp[0].nc, nj + ncp*6 + params.noOfRows());
+    BOOST_CHECK_NO_THROW(wbc_scene.solve(hqp));
+}
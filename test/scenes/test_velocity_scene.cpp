@@ -2,7 +2,12 @@
 #include "robot_models/kdl/RobotModelKDL.hpp"
 #include "core/RobotModelConfig.hpp"
 #include "scenes/VelocityScene.hpp"
+#include "core/JointVelocityConstraint.hpp"
+#include "core/PipelinedExecutor.hpp"
+#include "core/BatchSceneEngine.hpp"
+#include "core/RobotModelCache.hpp"
 #include "solvers/hls/HierarchicalLSSolver.hpp"
+#include "solvers/sns/SNSSolver.hpp"
 #include <tools/URDFTools.hpp>
 
 using namespace std;
@@ -111,3 +116,406 @@ BOOST_AUTO_TEST_CASE(simple_test){
 
 
 
+
+BOOST_AUTO_TEST_CASE(incremental_update_test){
+
+    /**
+     * Check if the incremental update of the velocity scene yields the same QP as a full rebuild, i.e., if changes of the reference and of the robot state are
+     * correctly propagated to the QP
+     */
+
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config;
+    config.file = "../../../models/kuka/urdf/kuka_iiwa.urdf";
+    config.joint_names = config.actuated_joint_names = URDFTools::jointNamesFromURDF(config.file);
+    BOOST_CHECK(robot_model->configure(config));
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->jointNames();
+    for(auto n : robot_model->jointNames()){
+        base::JointState js;
+        js.position = 0.5;
+        joint_state.elements.push_back(js);
+    }
+    joint_state.time = base::Time::now();
+    robot_model->update(joint_state);
+
+    QPSolverPtr solver = std::make_shared<HierarchicalLSSolver>();
+    ConstraintConfig cart_constraint("cart_pos_ctrl_left", 0, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", "kuka_lbr_l_link_0", 1);
+    ConstraintConfig jnt_constraint("jnt_pos_ctrl", 0, robot_model->jointNames(), std::vector<double>(robot_model->noOfJoints(),1), 1);
+    VelocityScene wbc_scene(robot_model, solver);
+    BOOST_CHECK_EQUAL(wbc_scene.configure({cart_constraint, jnt_constraint}), true);
+
+    base::samples::RigidBodyStateSE3 ref;
+    ref.twist.linear = base::Vector3d(0.1,0.2,0.3);
+    ref.twist.angular = base::Vector3d(0.0,0.0,0.1);
+    wbc_scene.setReference(cart_constraint.name, ref);
+    BOOST_CHECK(wbc_scene.getConstraint(cart_constraint.name)->hasChanged(reference_changed));
+    base::samples::Joints jnt_ref = joint_state;
+    for(auto &js : jnt_ref.elements)
+        js.speed = 0;
+    wbc_scene.setReference(jnt_constraint.name, jnt_ref);
+
+    HierarchicalQP qp = wbc_scene.update();
+    BOOST_CHECK(!wbc_scene.getConstraint(cart_constraint.name)->hasChanged());
+    BOOST_CHECK(!wbc_scene.getConstraint(jnt_constraint.name)->hasChanged());
+
+    // No change: QP has to be the same
+    HierarchicalQP qp_unchanged = wbc_scene.update();
+    BOOST_CHECK(qp_unchanged[0].A.isApprox(qp[0].A));
+    BOOST_CHECK(qp_unchanged[0].lower_y.isApprox(qp[0].lower_y));
+
+    // Changed reference
+    ref.twist.linear = base::Vector3d(-0.1,0.0,0.2);
+    wbc_scene.setReference(cart_constraint.name, ref);
+    const HierarchicalQP& qp_ref = wbc_scene.update();
+    for(int i = 0; i < 3; i++)
+        BOOST_CHECK(fabs(qp_ref[0].lower_y(i) - ref.twist.linear(i)) < 1e-9);
+
+    // Changed robot state: Constraint matrix has to be updated
+    for(auto &js : joint_state.elements)
+        js.position = 0.7;
+    joint_state.time = base::Time::now();
+    robot_model->update(joint_state);
+    const HierarchicalQP& qp_state = wbc_scene.update();
+    base::MatrixXd jac = robot_model->spaceJacobian(cart_constraint.root, cart_constraint.tip);
+    BOOST_CHECK(qp_state[0].A.block(0,0,6,robot_model->noOfJoints()).isApprox(jac));
+
+    // Changed activation: Weights have to be updated
+    wbc_scene.setTaskActivation(jnt_constraint.name, 0);
+    const HierarchicalQP& qp_act = wbc_scene.update();
+    BOOST_CHECK(qp_act[0].Wy.segment(6,robot_model->noOfJoints()).isZero());
+    BOOST_CHECK(qp_act[0].A.block(6,0,robot_model->noOfJoints(),robot_model->noOfJoints()).isZero());
+    BOOST_CHECK_EQUAL(wbc_scene.getNSkippedConstraints(), 1);
+
+    // Reactivate
+    wbc_scene.setTaskActivation(jnt_constraint.name, 1);
+    const HierarchicalQP& qp_react = wbc_scene.update();
+    BOOST_CHECK(qp_react[0].A.block(6,0,robot_model->noOfJoints(),robot_model->noOfJoints()).isIdentity());
+    BOOST_CHECK_EQUAL(wbc_scene.getNSkippedConstraints(), 0);
+
+    // Asynchronous input: Published values are applied with the next update
+    wbc_scene.publishTaskActivation(jnt_constraint.name, 0);
+    BOOST_CHECK_EQUAL(wbc_scene.getConstraint(jnt_constraint.name)->activation, 1);
+    ref.twist.linear = base::Vector3d(0.3,0.2,0.1);
+    wbc_scene.publishReference(cart_constraint.name, ref);
+    const HierarchicalQP& qp_async = wbc_scene.update();
+    BOOST_CHECK_EQUAL(wbc_scene.getConstraint(jnt_constraint.name)->activation, 0);
+    BOOST_CHECK_EQUAL(wbc_scene.getNSkippedConstraints(), 1);
+    for(int i = 0; i < 3; i++)
+        BOOST_CHECK(fabs(qp_async[0].lower_y(i) - ref.twist.linear(i)) < 1e-9);
+    BOOST_CHECK_THROW(wbc_scene.publishTaskActivation(jnt_constraint.name, 2), std::invalid_argument);
+
+    // Skipped constraints: The constraint status has to be computed from the current robot state
+    wbc_scene.setTaskActivation(jnt_constraint.name, 1);
+    wbc_scene.setTaskActivation(cart_constraint.name, 0);
+    for(auto &js : joint_state.elements){
+        js.position = 0.2;
+        js.speed = 0.1;
+    }
+    joint_state.time = base::Time::now();
+    robot_model->update(joint_state);
+    base::commands::Joints solver_output = wbc_scene.solve(wbc_scene.update());
+    BOOST_CHECK_EQUAL(wbc_scene.getNSkippedConstraints(), 1);
+    const ConstraintsStatus& status = wbc_scene.updateConstraintsStatus();
+    jac = robot_model->spaceJacobian(cart_constraint.root, cart_constraint.tip);
+    base::VectorXd qd(robot_model->noOfJoints()), qd_solution(robot_model->noOfJoints());
+    for(uint i = 0; i < robot_model->noOfJoints(); i++){
+        qd(i) = joint_state[i].speed;
+        qd_solution(i) = solver_output[robot_model->jointNames()[i]].speed;
+    }
+    BOOST_CHECK(status[cart_constraint.name].y.isApprox(jac*qd));
+    BOOST_CHECK(status[cart_constraint.name].y_solution.isApprox(jac*qd_solution));
+}
+
+BOOST_AUTO_TEST_CASE(joint_limits_test){
+
+    /**
+     * Check if the joint velocity limits are passed to the solver, so that the SNS solver respects them and scales down an infeasible task without changing its direction
+     */
+
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config;
+    config.file = "../../../models/kuka/urdf/kuka_iiwa.urdf";
+    config.joint_names = config.actuated_joint_names = URDFTools::jointNamesFromURDF(config.file);
+    BOOST_CHECK(robot_model->configure(config));
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->jointNames();
+    for(auto n : robot_model->jointNames()){
+        base::JointState js;
+        js.position = 0.5;
+        js.speed = 0;
+        joint_state.elements.push_back(js);
+    }
+    joint_state.time = base::Time::now();
+    robot_model->update(joint_state);
+
+    ConstraintConfig cart_constraint("cart_pos_ctrl_left", 0, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", "kuka_lbr_l_link_0", 1);
+    VelocityScene wbc_scene(robot_model, std::make_shared<SNSSolver>());
+    BOOST_CHECK(wbc_scene.configure({cart_constraint}));
+    BOOST_CHECK(!wbc_scene.getUseJointLimits());
+
+    // Infeasible reference, which exceeds the joint velocity limits
+    base::samples::RigidBodyStateSE3 ref;
+    ref.twist.linear = base::Vector3d(5.0,0.0,0.0);
+    ref.twist.angular = base::Vector3d(0.0,0.0,0.0);
+    wbc_scene.setReference(cart_constraint.name, ref);
+    base::VectorXd y_ref(6);
+    y_ref << ref.twist.linear, ref.twist.angular;
+
+    const uint nj = robot_model->noOfJoints();
+    base::MatrixXd jac = robot_model->spaceJacobian(cart_constraint.root, cart_constraint.tip);
+    for(int k = 0; k < 2; k++){
+        const bool use_joint_limits = k == 1;
+        wbc_scene.setUseJointLimits(use_joint_limits);
+        const HierarchicalQP& hqp = wbc_scene.update();
+        BOOST_CHECK_EQUAL(hqp[0].lower_x.size(), use_joint_limits ? nj : 0);
+        BOOST_CHECK_EQUAL(hqp[0].upper_x.size(), use_joint_limits ? nj : 0);
+        base::commands::Joints solver_output = wbc_scene.solve(hqp);
+
+        bool limits_violated = false;
+        base::VectorXd qd(nj);
+        for(uint i = 0; i < nj; i++){
+            const string& name = robot_model->jointNames()[i];
+            const base::JointLimitRange& range = robot_model->jointLimits()[name];
+            qd(robot_model->jointIndex(name)) = solver_output[name].speed;
+            if(solver_output[name].speed < range.min.speed - 1e-9 || solver_output[name].speed > range.max.speed + 1e-9)
+                limits_violated = true;
+        }
+        BOOST_CHECK_EQUAL(limits_violated, !use_joint_limits);
+
+        // The task is scaled, but its direction is preserved
+        base::VectorXd y = jac*qd;
+        const double scale = y.dot(y_ref)/y_ref.squaredNorm();
+        BOOST_CHECK(scale > 0 && scale <= 1 + 1e-6);
+        BOOST_CHECK((y - scale*y_ref).norm() < 1e-4);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pipelined_executor_test){
+
+    /**
+     * Check if the pipelined executor returns the same solutions as the serial execution, delayed by one cycle
+     */
+
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config;
+    config.file = "../../../models/kuka/urdf/kuka_iiwa.urdf";
+    config.joint_names = config.actuated_joint_names = URDFTools::jointNamesFromURDF(config.file);
+    BOOST_CHECK(robot_model->configure(config));
+
+    QPSolverPtr solver = std::make_shared<HierarchicalLSSolver>();
+    ConstraintConfig cart_constraint("cart_pos_ctrl_left", 0, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", "kuka_lbr_l_link_0", 1);
+    shared_ptr<VelocityScene> wbc_scene = make_shared<VelocityScene>(robot_model, solver);
+    BOOST_CHECK_EQUAL(wbc_scene->configure({cart_constraint}), true);
+
+    base::samples::RigidBodyStateSE3 ref;
+    ref.twist.linear = base::Vector3d(0.1,0.2,0.3);
+    ref.twist.angular = base::Vector3d(0.0,0.0,0.1);
+    wbc_scene->setReference(cart_constraint.name, ref);
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->jointNames();
+    joint_state.elements.resize(robot_model->noOfJoints());
+
+    const int n_cycles = 5;
+    std::vector<base::commands::Joints> serial_output(n_cycles), pipelined_output(n_cycles);
+
+    PipelinedExecutor executor(wbc_scene, 0);
+    for(int k = 0; k < n_cycles; k++){
+        for(auto &js : joint_state.elements)
+            js.position = 0.1*(k+1);
+        joint_state.time = base::Time::now();
+        serial_output[k] = executor.step(joint_state);
+        BOOST_CHECK(executor.hasOutput());
+    }
+
+    executor.setLatency(1);
+    BOOST_CHECK_EQUAL(executor.getLatency(), 1);
+    for(int k = 0; k <= n_cycles; k++){
+        for(auto &js : joint_state.elements)
+            js.position = 0.1*(k+1);
+        joint_state.time = base::Time::now();
+        const base::commands::Joints& output = executor.step(joint_state);
+        BOOST_CHECK_EQUAL(executor.hasOutput(), k > 0);
+        if(k > 0)
+            pipelined_output[k-1] = output;
+    }
+
+    for(int k = 0; k < n_cycles; k++){
+        for(uint i = 0; i < serial_output[k].size(); i++)
+            BOOST_CHECK(fabs(serial_output[k][i].speed - pipelined_output[k][i].speed) < 1e-9);
+    }
+
+    BOOST_CHECK_THROW(executor.setLatency(2), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(batch_scene_engine_test){
+
+    /**
+     * Check if the batch engine returns the same solutions as the individual scenes
+     */
+
+    RobotModelConfig config;
+    config.file = "../../../models/kuka/urdf/kuka_iiwa.urdf";
+    config.joint_names = config.actuated_joint_names = URDFTools::jointNamesFromURDF(config.file);
+    ConstraintConfig cart_constraint("cart_pos_ctrl_left", 0, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", "kuka_lbr_l_link_0", 1);
+
+    base::samples::RigidBodyStateSE3 ref;
+    ref.twist.linear = base::Vector3d(0.1,0.2,0.3);
+    ref.twist.angular = base::Vector3d(0.0,0.0,0.1);
+
+    const uint n_instances = 8;
+    BatchSceneEngine engine(2);
+    std::vector<shared_ptr<VelocityScene> > reference_scenes;
+    for(uint i = 0; i < n_instances; i++){
+        for(int k = 0; k < 2; k++){
+            shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+            BOOST_CHECK(robot_model->configure(config));
+            shared_ptr<VelocityScene> wbc_scene = make_shared<VelocityScene>(robot_model, std::make_shared<HierarchicalLSSolver>());
+            BOOST_CHECK(wbc_scene->configure({cart_constraint}));
+            wbc_scene->setReference(cart_constraint.name, ref);
+            if(k == 0)
+                engine.addInstance(wbc_scene);
+            else
+                reference_scenes.push_back(wbc_scene);
+        }
+    }
+    BOOST_CHECK_EQUAL(engine.size(), n_instances);
+
+    uint nj = reference_scenes[0]->getRobotModel()->noOfJoints();
+    base::MatrixXd q(n_instances, nj), qd;
+    for(uint i = 0; i < n_instances; i++)
+        q.row(i).setConstant(0.1*(i+1));
+    engine.step(q, qd);
+    BOOST_CHECK_EQUAL(engine.getNoOfSolves(), n_instances);
+    BOOST_CHECK(engine.getThroughput() > 0);
+
+    base::samples::Joints joint_state;
+    joint_state.names = reference_scenes[0]->getRobotModel()->jointNames();
+    joint_state.elements.resize(nj);
+    for(uint i = 0; i < n_instances; i++){
+        for(auto &js : joint_state.elements)
+            js.position = 0.1*(i+1);
+        joint_state.time = base::Time::now();
+        reference_scenes[i]->getRobotModel()->update(joint_state);
+        base::commands::Joints expected = reference_scenes[i]->solve(reference_scenes[i]->update());
+        for(uint j = 0; j < nj; j++)
+            BOOST_CHECK(fabs(expected[j].speed - engine.getOutput(i)[j].speed) < 1e-9);
+    }
+
+    // Wrong state size and unconfigured scenes have to be rejected
+    BOOST_CHECK_THROW(engine.step(base::MatrixXd(n_instances+1, nj), qd), std::invalid_argument);
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    BOOST_CHECK(robot_model->configure(config));
+    BOOST_CHECK_THROW(engine.addInstance(make_shared<VelocityScene>(robot_model, std::make_shared<HierarchicalLSSolver>())), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(robot_model_cache_test){
+
+    /**
+     * Check if the robot model cache computes each quantity only once per robot state and returns the same values as the robot model
+     */
+
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config;
+    config.file = "../../../models/kuka/urdf/kuka_iiwa.urdf";
+    config.joint_names = config.actuated_joint_names = URDFTools::jointNamesFromURDF(config.file);
+    BOOST_CHECK(robot_model->configure(config));
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->jointNames();
+    joint_state.elements.resize(robot_model->noOfJoints());
+    for(auto &js : joint_state.elements)
+        js.position = 0.5;
+    joint_state.time = base::Time::now();
+    robot_model->update(joint_state);
+
+    RobotModelCache cache(robot_model);
+    uint handle = cache.chainHandle("kuka_lbr_l_link_0", "kuka_lbr_l_tcp");
+    BOOST_CHECK_EQUAL(cache.chainHandle("kuka_lbr_l_link_0", "kuka_lbr_l_tcp"), handle);
+
+    base::MatrixXd jac = cache.spaceJacobian(handle);
+    BOOST_CHECK(jac.isApprox(robot_model->spaceJacobian("kuka_lbr_l_link_0", "kuka_lbr_l_tcp")));
+    BOOST_CHECK(cache.spaceJacobian("kuka_lbr_l_link_0", "kuka_lbr_l_tcp").isApprox(jac));
+    BOOST_CHECK_EQUAL(cache.noOfMisses(), 1);
+    BOOST_CHECK_EQUAL(cache.noOfHits(), 1);
+    BOOST_CHECK_EQUAL(cache.hitRate(), 0.5);
+
+    // A new robot state invalidates all cached values
+    for(auto &js : joint_state.elements)
+        js.position = 1.0;
+    robot_model->update(joint_state);
+    BOOST_CHECK(cache.spaceJacobian(handle).isApprox(robot_model->spaceJacobian("kuka_lbr_l_link_0", "kuka_lbr_l_tcp")));
+    BOOST_CHECK(!cache.spaceJacobian(handle).isApprox(jac));
+    BOOST_CHECK_EQUAL(cache.noOfMisses(), 2);
+    BOOST_CHECK_THROW(cache.spaceJacobian(handle+1), std::invalid_argument);
+
+    // Repeated scene updates with the same robot state do not recompute any kinematics
+    QPSolverPtr solver = std::make_shared<HierarchicalLSSolver>();
+    ConstraintConfig cart_constraint("cart_pos_ctrl_left", 0, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", "kuka_lbr_l_link_0", 1);
+    VelocityScene wbc_scene(robot_model, solver);
+    BOOST_CHECK(wbc_scene.configure({cart_constraint}));
+    base::samples::RigidBodyStateSE3 ref;
+    ref.twist.linear.setZero();
+    ref.twist.angular.setZero();
+    wbc_scene.setReference(cart_constraint.name, ref);
+    wbc_scene.update();
+    unsigned long n_misses = wbc_scene.getRobotModelCache().noOfMisses();
+    BOOST_CHECK(n_misses > 0);
+    wbc_scene.setReference(cart_constraint.name, ref);
+    wbc_scene.update();
+    BOOST_CHECK_EQUAL(wbc_scene.getRobotModelCache().noOfMisses(), n_misses);
+    BOOST_CHECK(wbc_scene.getRobotModelCache().noOfHits() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(joint_constraint_indices_test){
+
+    /**
+     * Check if the joint indices of joint space constraints are resolved in configure() and the constraint rows are assembled as selection matrix
+     */
+
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config;
+    config.file = "../../../models/kuka/urdf/kuka_iiwa.urdf";
+    config.joint_names = config.actuated_joint_names = URDFTools::jointNamesFromURDF(config.file);
+    BOOST_CHECK(robot_model->configure(config));
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->jointNames();
+    joint_state.elements.resize(robot_model->noOfJoints());
+    joint_state.time = base::Time::now();
+    robot_model->update(joint_state);
+
+    // Joint order of the constraint is reversed wrt. the robot model
+    vector<string> joint_names(robot_model->jointNames().rbegin(), robot_model->jointNames().rend());
+    ConstraintConfig jnt_constraint("jnt_pos_ctrl", 0, joint_names, vector<double>(joint_names.size(),1), 1);
+    VelocityScene wbc_scene(robot_model, std::make_shared<HierarchicalLSSolver>());
+    BOOST_CHECK(wbc_scene.configure({jnt_constraint}));
+
+    uint nj = robot_model->noOfJoints();
+    JointVelocityConstraintPtr constraint = std::static_pointer_cast<JointVelocityConstraint>(wbc_scene.getConstraint(jnt_constraint.name));
+    BOOST_CHECK_EQUAL(constraint->joint_idx.size(), nj);
+    for(uint k = 0; k < nj; k++)
+        BOOST_CHECK_EQUAL(constraint->joint_idx[k], nj-1-k);
+
+    base::samples::Joints ref;
+    ref.names = joint_names;
+    ref.elements.resize(nj);
+    for(uint k = 0; k < nj; k++)
+        ref[k].speed = k;
+    ref.time = base::Time::now();
+    wbc_scene.setReference(jnt_constraint.name, ref);
+    const HierarchicalQP& hqp = wbc_scene.update();
+    base::MatrixXd expected_A = base::MatrixXd::Identity(nj,nj).rowwise().reverse();
+    BOOST_CHECK(hqp[0].A == expected_A);
+    for(uint k = 0; k < nj; k++)
+        BOOST_CHECK_EQUAL(hqp[0].lower_y[k], k);
+
+    // Unknown joints are rejected in configure()
+    joint_names[0] = "unknown_joint";
+    ConstraintConfig invalid_constraint("jnt_pos_ctrl", 0, joint_names, vector<double>(joint_names.size(),1), 1);
+    VelocityScene invalid_scene(robot_model, std::make_shared<HierarchicalLSSolver>());
+    BOOST_CHECK(!invalid_scene.configure({invalid_constraint}));
+}
@@ -71,3 +71,284 @@ BOOST_AUTO_TEST_CASE(simple_test){
         BOOST_CHECK(fabs(yd[i+3] - ref.twist.angular[i]) < 1e5);
     }
 }
+
+BOOST_AUTO_TEST_CASE(soft_hierarchy_test){
+
+    /**
+     * Check if constraints on several priorities are mapped to a single QP level, where the higher priority dominates a conflicting lower priority
+     */
+
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config;
+    config.file = "../../../models/kuka/urdf/kuka_iiwa.urdf";
+    BOOST_CHECK_EQUAL(robot_model->configure(config), true);
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->jointNames();
+    joint_state.elements.resize(robot_model->noOfJoints());
+    for(auto &js : joint_state.elements)
+        js.position = 0.5;
+    joint_state.time = base::Time::now();
+    robot_model->update(joint_state);
+
+    QPSolverPtr solver = std::make_shared<QPOASESSolver>();
+    qpOASES::Options options = dynamic_pointer_cast<QPOASESSolver>(solver)->getOptions();
+    options.printLevel = qpOASES::PL_NONE;
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setOptions(options);
+
+    // Priority 0: Cartesian velocity, priority 1: Conflicting joint velocities
+    ConstraintConfig cart_constraint("cart_pos_ctrl_left", 0, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", "kuka_lbr_l_link_0", 1);
+    ConstraintConfig jnt_constraint("jnt_vel_ctrl", 1, robot_model->jointNames(), vector<double>(robot_model->noOfJoints(), 1), 1);
+    VelocitySceneQuadraticCost wbc_scene(robot_model, solver);
+    BOOST_CHECK(wbc_scene.configure({cart_constraint, jnt_constraint}));
+    BOOST_CHECK_THROW(wbc_scene.setPriorityWeightRatio(0), std::invalid_argument);
+
+    base::samples::RigidBodyStateSE3 ref;
+    ref.twist.linear = base::Vector3d(0.1, 0.0, 0.0);
+    ref.twist.angular = base::Vector3d(0.0, 0.0, 0.0);
+    base::samples::Joints jnt_ref;
+    jnt_ref.names = robot_model->jointNames();
+    jnt_ref.elements.resize(robot_model->noOfJoints());
+    for(auto &js : jnt_ref.elements)
+        js.speed = 1.0;
+    jnt_ref.time = base::Time::now();
+
+    base::MatrixXd jac = robot_model->spaceJacobian(cart_constraint.ref_frame, cart_constraint.tip);
+    double task_error[2];
+    double ratios[2] = {1, 1e6};
+    for(int k = 0; k < 2; k++){
+        wbc_scene.setPriorityWeightRatio(ratios[k]);
+        wbc_scene.setReference(cart_constraint.name, ref);
+        wbc_scene.setReference(jnt_constraint.name, jnt_ref);
+        const HierarchicalQP& hqp = wbc_scene.update();
+        BOOST_CHECK_EQUAL(hqp.size(), 1);
+        HierarchicalQP qp = hqp;
+        qp[0].lower_x.resize(0);
+        qp[0].upper_x.resize(0);
+        base::commands::Joints solver_output = wbc_scene.solve(qp);
+
+        base::VectorXd qd(solver_output.size());
+        for(uint i = 0; i < solver_output.size(); i++)
+            qd[i] = solver_output[i].speed;
+        base::VectorXd y_ref(6);
+        y_ref << ref.twist.linear, ref.twist.angular;
+        task_error[k] = (jac*qd - y_ref).norm();
+    }
+    BOOST_CHECK(task_error[1] < 1e-2);
+    BOOST_CHECK(task_error[1] < task_error[0]);
+}
+
+BOOST_AUTO_TEST_CASE(soft_hierarchy_three_levels_test){
+
+    /**
+     * With three conflicting priorities and the default priority weight ratio, the QP has to remain well conditioned, i.e., the box QP and the QP solver
+     * converge to the same solution and the highest priority is fulfilled
+     */
+
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config;
+    config.file = "../../../models/kuka/urdf/kuka_iiwa.urdf";
+    BOOST_CHECK_EQUAL(robot_model->configure(config), true);
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->jointNames();
+    joint_state.elements.resize(robot_model->noOfJoints());
+    for(auto &js : joint_state.elements)
+        js.position = 0.5;
+    joint_state.time = base::Time::now();
+    robot_model->update(joint_state);
+
+    QPSolverPtr solver = std::make_shared<QPOASESSolver>();
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setMaxNoWSR(1000);
+    qpOASES::Options options = dynamic_pointer_cast<QPOASESSolver>(solver)->getOptions();
+    options.printLevel = qpOASES::PL_NONE;
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setOptions(options);
+
+    // Priority 0: Cartesian velocity, priority 1: Velocity of the first two joints, priority 2: Velocity of all joints
+    const vector<string>& joint_names = robot_model->jointNames();
+    ConstraintConfig cart_constraint("cart_pos_ctrl_left", 0, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", "kuka_lbr_l_link_0", 1);
+    ConstraintConfig jnt_constraint_1("jnt_vel_ctrl_1", 1, {joint_names[0], joint_names[1]}, {1,1}, 1);
+    ConstraintConfig jnt_constraint_2("jnt_vel_ctrl_2", 2, joint_names, vector<double>(joint_names.size(), 1), 1);
+    VelocitySceneQuadraticCost wbc_scene(robot_model, solver);
+    BOOST_CHECK(wbc_scene.configure({cart_constraint, jnt_constraint_1, jnt_constraint_2}));
+    BOOST_CHECK_EQUAL(wbc_scene.getPriorityWeightRatio(), 100);
+
+    base::samples::RigidBodyStateSE3 ref;
+    ref.twist.linear = base::Vector3d(0.1, 0.0, 0.0);
+    ref.twist.angular = base::Vector3d(0.0, 0.0, 0.0);
+    wbc_scene.setReference(cart_constraint.name, ref);
+    base::samples::Joints jnt_ref;
+    jnt_ref.names = {joint_names[0], joint_names[1]};
+    jnt_ref.elements.resize(2);
+    for(auto &js : jnt_ref.elements)
+        js.speed = -0.3;
+    jnt_ref.time = base::Time::now();
+    wbc_scene.setReference(jnt_constraint_1.name, jnt_ref);
+    jnt_ref.names = joint_names;
+    jnt_ref.elements.resize(joint_names.size());
+    for(auto &js : jnt_ref.elements)
+        js.speed = 0.5;
+    wbc_scene.setReference(jnt_constraint_2.name, jnt_ref);
+
+    const HierarchicalQP& hqp = wbc_scene.update();
+    BOOST_CHECK_EQUAL(hqp.size(), 1);
+
+    wbc_scene.setUseBoxQPSolver(true);
+    base::commands::Joints box_output;
+    BOOST_CHECK_NO_THROW(box_output = wbc_scene.solve(hqp));
+    BOOST_CHECK(wbc_scene.boxQPSolverUsed());
+
+    wbc_scene.setUseBoxQPSolver(false);
+    base::commands::Joints qp_output;
+    BOOST_CHECK_NO_THROW(qp_output = wbc_scene.solve(hqp));
+    BOOST_CHECK(wbc_scene.getSolverStatus() == solver_success);
+
+    base::VectorXd qd(qp_output.size());
+    for(uint i = 0; i < qp_output.size(); i++){
+        BOOST_CHECK(fabs(box_output[i].speed - qp_output[i].speed) < 1e-4);
+        qd[i] = qp_output[i].speed;
+    }
+    base::MatrixXd jac = robot_model->spaceJacobian(cart_constraint.ref_frame, cart_constraint.tip);
+    base::VectorXd y_ref(6);
+    y_ref << ref.twist.linear, ref.twist.angular;
+    BOOST_CHECK((jac*qd - y_ref).norm() < 0.05);
+}
+
+BOOST_AUTO_TEST_CASE(box_qp_solver_test){
+
+    /**
+     * Without contacts, the scene solves the box constrained QP with the projected Newton method. The result has to match the QP solver, also if joint limits are active
+     */
+
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config;
+    config.file = "../../../models/kuka/urdf/kuka_iiwa.urdf";
+    BOOST_CHECK_EQUAL(robot_model->configure(config), true);
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->jointNames();
+    joint_state.elements.resize(robot_model->noOfJoints());
+    for(auto &js : joint_state.elements)
+        js.position = 0.5;
+    joint_state.time = base::Time::now();
+    robot_model->update(joint_state);
+
+    QPSolverPtr solver = std::make_shared<QPOASESSolver>();
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setMaxNoWSR(1000);
+    qpOASES::Options options = dynamic_pointer_cast<QPOASESSolver>(solver)->getOptions();
+    options.printLevel = qpOASES::PL_NONE;
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setOptions(options);
+
+    ConstraintConfig cart_constraint("cart_pos_ctrl_left", 0, "kuka_lbr_l_link_0", "kuka_lbr_l_tcp", "kuka_lbr_l_link_0", 1);
+    VelocitySceneQuadraticCost wbc_scene(robot_model, solver);
+    BOOST_CHECK(wbc_scene.configure({cart_constraint}));
+    BOOST_CHECK(wbc_scene.getUseBoxQPSolver());
+
+    // Small reference: No active joint limits, large reference: Some joint limits are active
+    double scales[2] = {0.1, 100};
+    for(int k = 0; k < 2; k++){
+        base::samples::RigidBodyStateSE3 ref;
+        ref.twist.linear = base::Vector3d(1, -1, 0.5)*scales[k];
+        ref.twist.angular = base::Vector3d(0.2, 0.1, -0.3)*scales[k];
+        wbc_scene.setReference(cart_constraint.name, ref);
+        const HierarchicalQP& hqp = wbc_scene.update();
+        BOOST_CHECK_EQUAL(hqp[0].nc, 0);
+
+        wbc_scene.setUseBoxQPSolver(true);
+        base::commands::Joints box_output = wbc_scene.solve(hqp);
+        BOOST_CHECK(wbc_scene.boxQPSolverUsed());
+
+        wbc_scene.setUseBoxQPSolver(false);
+        base::commands::Joints qp_output = wbc_scene.solve(hqp);
+        BOOST_CHECK(!wbc_scene.boxQPSolverUsed());
+
+        for(uint i = 0; i < box_output.size(); i++){
+            BOOST_CHECK(fabs(box_output[i].speed - qp_output[i].speed) < 1e-4);
+            BOOST_CHECK(box_output[i].speed <= hqp[0].upper_x[i] + 1e-9);
+            BOOST_CHECK(box_output[i].speed >= hqp[0].lower_x[i] - 1e-9);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(contact_model_test){
+
+    /**
+     * Check if only active contacts are part of the QP and if the contact constraints contain the rows of the contact Jacobian selected by the contact model
+     */
+
+    shared_ptr<RobotModelKDL> robot_model = make_shared<RobotModelKDL>();
+    RobotModelConfig config("../../../models/rh5/urdf/rh5_legs.urdf");
+    config.floating_base = true;
+    config.floating_base_state.pose.position = base::Vector3d(0,0,0.87);
+    config.floating_base_state.pose.orientation.setIdentity();
+    config.contact_points.names = {"LLAnkle_FT", "LRAnkle_FT"};
+    config.contact_points.elements = {1,1};
+    BOOST_CHECK_EQUAL(robot_model->configure(config), true);
+
+    base::samples::Joints joint_state;
+    joint_state.names = robot_model->actuatedJointNames();
+    joint_state.elements.resize(robot_model->noOfActuatedJoints());
+    for(auto &js : joint_state.elements){
+        js.position = 0.1;
+        js.speed = 0;
+    }
+    joint_state.time = base::Time::now();
+    base::samples::RigidBodyStateSE3 floating_base_state;
+    floating_base_state.pose = config.floating_base_state.pose;
+    floating_base_state.twist.setZero();
+    floating_base_state.acceleration.setZero();
+    floating_base_state.time = base::Time::now();
+    robot_model->update(joint_state, floating_base_state);
+
+    QPSolverPtr solver = std::make_shared<QPOASESSolver>();
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setMaxNoWSR(1000);
+    qpOASES::Options options = dynamic_pointer_cast<QPOASESSolver>(solver)->getOptions();
+    options.printLevel = qpOASES::PL_NONE;
+    dynamic_pointer_cast<QPOASESSolver>(solver)->setOptions(options);
+
+    ConstraintConfig com_constraint("com_position", 0, "world", "world", "world", 1, {1,1,1});
+    com_constraint.type = com;
+    VelocitySceneQuadraticCost wbc_scene(robot_model, solver);
+    BOOST_CHECK(wbc_scene.configure({com_constraint}));
+    base::samples::RigidBodyStateSE3 ref;
+    ref.twist.linear = base::Vector3d(0.1, 0, -0.05);
+    ref.twist.angular.setZero();
+    wbc_scene.setReference(com_constraint.name, ref);
+
+    BOOST_CHECK_THROW(wbc_scene.setContactModel(static_cast<ContactModel>(5)), std::invalid_argument);
+    BOOST_CHECK_EQUAL(wbc_scene.getContactModel("LLAnkle_FT"), surface_contact);
+
+    // Default: Surface contacts, 6 rows each
+    HierarchicalQP hqp = wbc_scene.update();
+    BOOST_CHECK_EQUAL(hqp[0].nc, 12);
+
+    // Point contact left, line contact right
+    wbc_scene.setContactModel(point_contact);
+    wbc_scene.setContactModel("LRAnkle_FT", line_contact);
+    BOOST_CHECK_EQUAL(wbc_scene.getContactModel("LLAnkle_FT"), point_contact);
+    BOOST_CHECK_EQUAL(wbc_scene.getContactModel("LRAnkle_FT"), line_contact);
+    hqp = wbc_scene.update();
+    BOOST_CHECK_EQUAL(hqp[0].nc, 8);
+    base::MatrixXd jac_l = robot_model->bodyJacobian(robot_model->baseFrame(), "LLAnkle_FT");
+    base::MatrixXd jac_r = robot_model->bodyJacobian(robot_model->baseFrame(), "LRAnkle_FT");
+    BOOST_CHECK((hqp[0].A.topRows(3) - jac_l.topRows(3)).norm() < 1e-9);
+    BOOST_CHECK((hqp[0].A.middleRows(3,3) - jac_r.topRows(3)).norm() < 1e-9);
+    BOOST_CHECK((hqp[0].A.bottomRows(2) - jac_r.bottomRows(2)).norm() < 1e-9);
+    BOOST_CHECK_NO_THROW(wbc_scene.solve(hqp));
+    BOOST_CHECK(!wbc_scene.boxQPSolverUsed());
+
+    // Inactive contacts are removed from the QP
+    ActiveContacts contacts = config.contact_points;
+    contacts.elements = {0,1};
+    robot_model->setActiveContacts(contacts);
+    hqp = wbc_scene.update();
+    BOOST_CHECK_EQUAL(hqp[0].nc, 5);
+    BOOST_CHECK((hqp[0].A.topRows(3) - jac_r.topRows(3)).norm() < 1e-9);
+
+    // Without active contacts, there are only joint velocity bounds
+    contacts.elements = {0,0};
+    robot_model->setActiveContacts(contacts);
+    hqp = wbc_scene.update();
+    BOOST_CHECK_EQUAL(hqp[0].nc, 0);
+    BOOST_CHECK_NO_THROW(wbc_scene.solve(hqp));
+}
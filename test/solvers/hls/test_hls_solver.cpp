@@ -71,3 +71,75 @@ BOOST_AUTO_TEST_CASE(solver_hls)
 
     //cout<<"\n............................."<<endl;
 }
+
+BOOST_AUTO_TEST_CASE(solver_hls_varying_size)
+{
+    // The number of constraint rows may change between calls, e.g. if inactive constraints are removed from the QP
+    const uint NO_JOINTS = 6;
+
+    HierarchicalLSSolver solver;
+    solver.setMaxSolverOutputNorm(100);
+
+    wbc::HierarchicalQP hqp;
+    hqp.Wq.setOnes(NO_JOINTS);
+    hqp.resize(2);
+    for(uint n_rows = 0; n_rows <= NO_JOINTS; n_rows += 3){
+        hqp[0].resize(n_rows, NO_JOINTS);
+        hqp[0].A.setRandom();
+        hqp[0].lower_y.setRandom();
+        hqp[0].upper_y = hqp[0].lower_y;
+        hqp[1].resize(1, NO_JOINTS);
+        hqp[1].A.setRandom();
+        hqp[1].lower_y.setRandom();
+        hqp[1].upper_y = hqp[1].lower_y;
+
+        base::VectorXd solver_output;
+        BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+        BOOST_CHECK_EQUAL(solver_output.size(), NO_JOINTS);
+        if(n_rows < NO_JOINTS){
+            base::VectorXd test = hqp[0].A*solver_output;
+            for(uint j = 0; j < n_rows; j++)
+                BOOST_CHECK(fabs(test(j) - hqp[0].lower_y(j)) < 1e-6);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(solver_hls_time_budget)
+{
+    srand (time(NULL));
+
+    const uint NO_JOINTS = 100;
+    const uint NO_PRIOS = 3;
+
+    wbc::HierarchicalQP hqp;
+    hqp.resize(NO_PRIOS);
+    for(uint prio = 0; prio < NO_PRIOS; prio++){
+        hqp[prio].resize(10, NO_JOINTS);
+        hqp[prio].A.setRandom();
+        hqp[prio].lower_y.setRandom();
+        hqp[prio].upper_y = hqp[prio].lower_y;
+        hqp[prio].Wy.setOnes(10);
+    }
+    hqp.Wq.setOnes(NO_JOINTS);
+
+    HierarchicalLSSolver solver;
+    base::VectorXd solver_output;
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK(!solver.timeBudgetExceeded());
+    BOOST_CHECK(!solver.svdIterationLimitReached());
+    base::VectorXd full_solution = solver_output;
+
+    // The budget expires after the first priority, the solver returns the solution of the priorities solved so far
+    solver.setMaxSolveTime(1e-9);
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK(solver.timeBudgetExceeded());
+    BOOST_CHECK(solver.trySolve(hqp, solver_output) == solver_timeout);
+    BOOST_CHECK((solver_output - full_solution).norm() > 1e-6);
+    BOOST_CHECK((hqp[0].A*solver_output - hqp[0].lower_y).norm() < 1e-6);
+
+    solver.setMaxSolveTime(0);
+    BOOST_CHECK_THROW(solver.setMaxSVDIterations(0), std::invalid_argument);
+    solver.setMaxSVDIterations(1);
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK(solver.svdIterationLimitReached());
+}
@@ -3,6 +3,7 @@
 #include <sys/time.h>
 #include "core/QuadraticProgram.hpp"
 #include "solvers/qpoases/QPOasesSolver.hpp"
+#include "solvers/qpoases/QPOasesCascadeSolver.hpp"
 
 using namespace wbc;
 using namespace std;
@@ -151,3 +152,286 @@ BOOST_AUTO_TEST_CASE(solver_qp_oases_with_constraints)
 
     //cout<<"\n............................."<<endl;
 }
+
+BOOST_AUTO_TEST_CASE(solver_qp_oases_vector_hotstart)
+{
+    // If only the gradient changes between two calls, the hotstart should only update the vectors of the QP
+    const int NO_JOINTS = 6;
+
+    wbc::QuadraticProgram qp;
+    qp.resize(NO_JOINTS, NO_JOINTS);
+    qp.lower_x.resize(0);
+    qp.upper_x.resize(0);
+    qp.lower_y.resize(0);
+    qp.upper_y.resize(0);
+    qp.A.setIdentity();
+    qp.H.setIdentity();
+    qp.g.setRandom();
+    wbc::HierarchicalQP hqp;
+    hqp << qp;
+
+    QPOASESSolver solver;
+    Options options = solver.getOptions();
+    options.printLevel = PL_NONE;
+    solver.setOptions(options);
+
+    base::VectorXd solver_output;
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK(solver.matricesChanged());
+
+    hqp[0].g.setRandom();
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK(!solver.matricesChanged());
+    for(uint j = 0; j < NO_JOINTS; j++)
+        BOOST_CHECK(fabs(solver_output(j) + hqp[0].g(j)) < 1e-9);
+
+    hqp[0].H *= 2;
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK(solver.matricesChanged());
+    for(uint j = 0; j < NO_JOINTS; j++)
+        BOOST_CHECK(fabs(2*solver_output(j) + hqp[0].g(j)) < 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(solver_qp_oases_recovery)
+{
+    // min 1/2 x^T x - x^T y, s.t. 0 <= x_0 <= 0 and lb(x_0) <= x_0 <= ub(x_0). The QP is infeasible if lb(x_0) > 0
+    const int NO_JOINTS = 3;
+
+    wbc::QuadraticProgram qp;
+    qp.resize(1, NO_JOINTS);
+    qp.H.setIdentity();
+    qp.g = -base::Vector3d(1,2,3);
+    qp.A.setZero();
+    qp.A(0,0) = 1;
+    qp.lower_x.setConstant(-10);
+    qp.upper_x.setConstant(10);
+    qp.lower_x[0] = qp.upper_x[0] = 0;
+    qp.lower_y.setConstant(-1);
+    qp.upper_y.setConstant(1);
+    wbc::HierarchicalQP hqp;
+    hqp << qp;
+
+    QPOASESSolver solver;
+    Options options = solver.getOptions();
+    options.printLevel = PL_NONE;
+    solver.setOptions(options);
+    BOOST_CHECK_THROW(solver.setRecoveryRelaxation(0), std::invalid_argument);
+    BOOST_CHECK_THROW(solver.setRecoveryDamping(-1), std::invalid_argument);
+
+    base::VectorXd solver_output, last_solution;
+    BOOST_CHECK(solver.trySolve(hqp, solver_output) == solver_success);
+    last_solution = solver_output;
+
+    // No recovery
+    hqp[0].lower_y.setConstant(5e-4);
+    hqp[0].upper_y.setConstant(5e-4);
+    BOOST_CHECK(solver.trySolve(hqp, solver_output) == solver_failed);
+    BOOST_CHECK(solver.getNoOfFailures() == 1);
+    BOOST_CHECK(solver.getFailureReason() == "qpOASES returned error " + std::to_string(solver.getReturnValue()));
+
+    // Last solution
+    solver.setRecoveryPolicy(recover_last_solution);
+    BOOST_CHECK(solver.trySolve(hqp, solver_output) == solver_recovered);
+    BOOST_CHECK((solver_output - last_solution).norm() < 1e-9);
+    BOOST_CHECK(solver.getNoOfRecoveries(recover_last_solution) == 1);
+
+    // Relaxed bounds: x_0 is at the relaxed upper joint bound
+    solver.setRecoveryPolicy(recover_relaxed_reinit);
+    BOOST_CHECK(solver.trySolve(hqp, solver_output) == solver_recovered);
+    BOOST_CHECK(fabs(solver_output[0] - solver.getRecoveryRelaxation()) < 1e-6);
+    BOOST_CHECK(solver.getNoOfRecoveries(recover_relaxed_reinit) == 1);
+
+    // Damped least squares: Solution is clipped to the joint bounds
+    solver.setRecoveryPolicy(recover_damped_least_squares);
+    BOOST_CHECK(solver.trySolve(hqp, solver_output) == solver_recovered);
+    BOOST_CHECK(fabs(solver_output[0]) < 1e-9);
+    BOOST_CHECK(fabs(solver_output[1] - 2/(1+solver.getRecoveryDamping())) < 1e-6);
+    BOOST_CHECK(solver.getNoOfRecoveries(recover_damped_least_squares) == 1);
+
+    // Solver recovers from the failure as soon as the QP becomes feasible again
+    hqp[0].lower_y.setConstant(-1);
+    hqp[0].upper_y.setConstant(1);
+    BOOST_CHECK(solver.trySolve(hqp, solver_output) == solver_success);
+    BOOST_CHECK((solver_output - last_solution).norm() < 1e-6);
+    BOOST_CHECK(solver.getNoOfSolves() == 2);
+
+    // A sufficient time budget does not affect the solution
+    solver.setMaxSolveTime(1.0);
+    BOOST_CHECK(solver.trySolve(hqp, solver_output) == solver_success);
+    BOOST_CHECK(!solver.timeBudgetExceeded());
+    BOOST_CHECK((solver_output - last_solution).norm() < 1e-6);
+
+    BOOST_CHECK(solver.getFailureReason().empty());
+
+    solver.resetCounters();
+    BOOST_CHECK(solver.getNoOfSolves() == 0 && solver.getNoOfFailures() == 0 && solver.getNoOfRecoveries(recover_damped_least_squares) == 0);
+
+    // Invalid input is not handled by the recovery policy
+    hqp[0].lower_y.resize(2);
+    BOOST_CHECK_THROW(solver.trySolve(hqp, solver_output), std::invalid_argument);
+    BOOST_CHECK(solver.getNoOfFailures() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(solver_qp_oases_active_set)
+{
+    // min 1/2 x^T x - x^T y, s.t. -1 <= x <= 1 and x_0 + x_1 <= 1. With y = (2,-2,0.5,3), the bounds of x_1 (lower) and x_3 (upper) are active
+    const int NO_JOINTS = 4;
+
+    wbc::QuadraticProgram qp;
+    qp.resize(1, NO_JOINTS);
+    qp.H.setIdentity();
+    qp.g << -2, 2, -0.5, -3;
+    qp.A << 1, 1, 0, 0;
+    qp.lower_x.setConstant(-1);
+    qp.upper_x.setConstant(1);
+    qp.lower_y.setConstant(-100);
+    qp.upper_y.setConstant(1);
+    wbc::HierarchicalQP hqp;
+    hqp << qp;
+
+    QPOASESSolver solver;
+    Options options = solver.getOptions();
+    options.printLevel = PL_NONE;
+    solver.setOptions(options);
+
+    QPActiveSet active_set;
+    BOOST_CHECK(!solver.getActiveSet(active_set));
+
+    base::VectorXd solver_output, solution;
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solution));
+    BOOST_CHECK(solver.getActiveSet(active_set));
+    BOOST_CHECK(active_set.bounds.size() == NO_JOINTS);
+    BOOST_CHECK(active_set.constraints.size() == 1);
+    BOOST_CHECK(active_set.bounds[1] == -1 && active_set.bounds[2] == 0 && active_set.bounds[3] == 1);
+    const int n_wsr_cold = solver.getNoWSR();
+
+    // Restore the active set after reset(): Same solution with fewer working set recalculations
+    solver.reset();
+    solver.setActiveSet(active_set);
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK((solver_output - solution).norm() < 1e-9);
+    BOOST_CHECK(solver.getNoWSR() < n_wsr_cold);
+
+    // A wrong guess must not affect the solution
+    QPActiveSet wrong_active_set;
+    wrong_active_set.bounds.assign(NO_JOINTS, 1);
+    wrong_active_set.constraints.assign(1, -1);
+    solver.reset();
+    solver.setActiveSet(wrong_active_set);
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK((solver_output - solution).norm() < 1e-9);
+
+    // Active set prediction: The working set is exported after each solve and survives reset()
+    solver.setActiveSet(QPActiveSet());
+    solver.setActiveSetPrediction(true);
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK(solver.getActiveSetGuess().bounds == active_set.bounds);
+    solver.reset();
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK((solver_output - solution).norm() < 1e-9);
+    BOOST_CHECK(solver.getNoWSR() < n_wsr_cold);
+
+    // The guess is also used in the reinitialization of the recovery strategies, which can run repeatedly without reconfiguring the solver.
+    // x_0 = x_1 = 0 and x_0 + x_1 = r/2 is infeasible, but feasible with the bounds relaxed by r
+    solver.setRecoveryPolicy(recover_relaxed_reinit);
+    const double r = solver.getRecoveryRelaxation();
+    hqp[0].lower_x.setZero();
+    hqp[0].upper_x.setZero();
+    hqp[0].lower_y.setConstant(0.5*r);
+    hqp[0].upper_y.setConstant(0.5*r);
+    for(int i = 0; i < 3; i++){
+        BOOST_CHECK(solver.trySolve(hqp, solver_output) == solver_recovered);
+        BOOST_CHECK(fabs(solver_output[0] - r) < 1e-6 && fabs(solver_output[1] + r) < 1e-6);
+    }
+    BOOST_CHECK(solver.getNoOfRecoveries(recover_relaxed_reinit) == 3);
+
+    // After the failures, the solver returns to the original solution
+    hqp[0] = qp;
+    BOOST_CHECK(solver.trySolve(hqp, solver_output) == solver_success);
+    BOOST_CHECK((solver_output - solution).norm() < 1e-9);
+
+    // Invalid active set
+    wrong_active_set.bounds[0] = 2;
+    BOOST_CHECK_THROW(solver.setActiveSet(wrong_active_set), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(solver_qp_oases_cascade)
+{
+    srand (time(NULL));
+
+    const int NO_JOINTS = 6;
+
+    // Priority 0: 3 random equality tasks and an inequality task on the first joint (x_0 <= 0.1)
+    // Priority 1: Conflicting joint space task x = 1, which can only be fulfilled in the nullspace of priority 0
+    wbc::HierarchicalQP hqp;
+    hqp.resize(2);
+    hqp[0].resize(4, NO_JOINTS);
+    hqp[0].A.setZero();
+    hqp[0].A.topRows(3).setRandom();
+    hqp[0].A(3,0) = 1;
+    hqp[0].lower_y.setRandom();
+    hqp[0].upper_y = hqp[0].lower_y;
+    hqp[0].lower_y[3] = -1e10;
+    hqp[0].upper_y[3] = 0.1;
+    hqp[0].Wy.setOnes(4);
+    hqp[0].lower_x.resize(0);
+    hqp[0].upper_x.resize(0);
+
+    hqp[1].resize(NO_JOINTS, NO_JOINTS);
+    hqp[1].A.setIdentity();
+    hqp[1].lower_y.setOnes();
+    hqp[1].upper_y.setOnes();
+    hqp[1].Wy.setOnes(NO_JOINTS);
+    hqp[1].lower_x.resize(0);
+    hqp[1].upper_x.resize(0);
+    hqp.Wq.setOnes(NO_JOINTS);
+
+    QPOASESCascadeSolver solver;
+    Options options = solver.getOptions();
+    options.printLevel = PL_NONE;
+    solver.setOptions(options);
+    solver.setMaxNoWSR(100);
+    BOOST_CHECK_THROW(solver.setHessianRegularizer(0), std::invalid_argument);
+
+    base::VectorXd solver_output;
+    for(int k = 0; k < 2; k++){ // Second run is hot-started
+        BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+        BOOST_CHECK(solver.noOfLevels() == 2);
+        BOOST_CHECK(solver.getReturnValue(0) == SUCCESSFUL_RETURN);
+        BOOST_CHECK(solver.getReturnValue(1) == SUCCESSFUL_RETURN);
+
+        // Priority 0 is fulfilled exactly
+        base::VectorXd y = hqp[0].A*solver_output;
+        for(uint j = 0; j < 3; j++)
+            BOOST_CHECK(fabs(y(j) - hqp[0].lower_y(j)) < 1e-6);
+        BOOST_CHECK(y(3) <= 0.1 + 1e-6);
+
+        // Priority 1 is fulfilled as well as possible: The error has to be orthogonal to the nullspace of the active rows of priority 0
+        base::MatrixXd A_active = hqp[0].A.topRows(3);
+        if(fabs(y(3) - 0.1) < 1e-6){
+            A_active.conservativeResize(4, NO_JOINTS);
+            A_active.row(3) = hqp[0].A.row(3);
+        }
+        Eigen::JacobiSVD<base::MatrixXd> svd(A_active, Eigen::ComputeFullV);
+        base::MatrixXd N = svd.matrixV().rightCols(NO_JOINTS - A_active.rows());
+        base::VectorXd err = solver_output - hqp[1].lower_y;
+        BOOST_CHECK((N.transpose()*err).norm() < 1e-5);
+    }
+    BOOST_CHECK_THROW(solver.getReturnValue(2), std::invalid_argument);
+
+    // Time budget expires: The solver returns the solution of the last completed level or of the last call, but never an invalid zero solution
+    solver.setMaxSolveTime(1e-9);
+    SolverStatus status = solver.trySolve(hqp, solver_output);
+    BOOST_CHECK(status == solver_success || status == solver_timeout);
+    BOOST_CHECK(!solver_output.isZero());
+
+    // Without previous solution, the solver fails if the budget expires before priority 0 has been solved
+    QPOASESCascadeSolver solver_budget;
+    solver_budget.setOptions(options);
+    solver_budget.setMaxNoWSR(100);
+    solver_budget.setMaxSolveTime(1e-9);
+    status = solver_budget.trySolve(hqp, solver_output);
+    BOOST_CHECK(status != solver_timeout || !solver_output.isZero());
+    if(status == solver_failed)
+        BOOST_CHECK(solver_budget.timeBudgetExceeded());
+}
@@ -0,0 +1,155 @@
+#include <boost/test/unit_test.hpp>
+#include "solvers/sns/SNSSolver.hpp"
+#include "solvers/hls/HierarchicalLSSolver.hpp"
+#include "core/QuadraticProgram.hpp"
+
+using namespace wbc;
+using namespace std;
+
+BOOST_AUTO_TEST_CASE(solver_sns_without_bounds)
+{
+    /**
+     * Without joint bounds, the SNS solver should give the same result as the HierarchicalLSSolver
+     */
+
+    srand(time(NULL));
+
+    const uint NO_JOINTS = 7;
+    const uint NO_CONSTRAINTS = 6;
+
+    SNSSolver solver;
+    BOOST_CHECK_THROW(solver.setMinEigenvalue(0), std::invalid_argument);
+    BOOST_CHECK_THROW(solver.setMaxSolverOutputNorm(0), std::invalid_argument);
+    solver.setMaxSolverOutputNorm(100);
+
+    HierarchicalLSSolver hls_solver;
+    hls_solver.setMaxSolverOutputNorm(100);
+
+    HierarchicalQP hqp;
+    hqp.resize(2);
+    hqp[0].resize(NO_CONSTRAINTS, NO_JOINTS);
+    hqp[0].A.setRandom();
+    hqp[0].lower_y.setRandom();
+    hqp[0].upper_y = hqp[0].lower_y;
+    hqp[1].resize(1, NO_JOINTS);
+    hqp[1].A.setRandom();
+    hqp[1].lower_y.setRandom();
+    hqp[1].upper_y = hqp[1].lower_y;
+    hqp.Wq.setOnes(NO_JOINTS);
+
+    base::VectorXd solver_output, hls_solver_output;
+    BOOST_CHECK_NO_THROW(solver.solve(hqp, solver_output));
+    BOOST_CHECK_NO_THROW(hls_solver.solve(hqp, hls_solver_output));
+
+    for(uint i = 0; i < NO_JOINTS; i++)
+        BOOST_CHECK(fabs(solver_output(i) - hls_solver_output(i)) < 1e-6);
+    BOOST_CHECK_EQUAL(solver.noOfSaturatedJoints(), 0);
+    BOOST_CHECK_EQUAL(solver.getTaskScales().size(), 2);
+    BOOST_CHECK_EQUAL(solver.getTaskScales()[0], 1);
+    BOOST_CHECK_EQUAL(solver.getTaskScales()[1], 1);
+
+    // Invalid input
+    hqp[1].lower_y.resize(2);
+    BOOST_CHECK_THROW(solver.solve(hqp, solver_output), std::invalid_argument);
+    BOOST_CHECK_THROW(solver.trySolve(hqp, solver_output), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(solver_sns_joint_bounds)
+{
+    /**
+     * A feasible task should be fulfilled exactly within the joint bounds, using the remaining joints to compensate the saturated ones.
+     * An infeasible task should be scaled down, so that the joint bounds are respected and the task direction is preserved.
+     */
+
+    const uint NO_JOINTS = 4;
+    const double LIMIT = 1.0;
+
+    SNSSolver solver;
+    HierarchicalQP hqp;
+    hqp.resize(1);
+    hqp[0].resize(1, NO_JOINTS);
+    hqp[0].A << 1, 1, 1, 1;
+    hqp[0].lower_y << 3;
+    hqp[0].upper_y = hqp[0].lower_y;
+    hqp[0].lower_x.setConstant(-LIMIT);
+    hqp[0].upper_x.setConstant(LIMIT);
+    hqp[0].upper_x(0) = 0.2;
+    hqp.Wq.setOnes(NO_JOINTS);
+
+    // Feasible: The unconstrained solution is 0.75 for all joints, which violates the bound of joint 0
+    base::VectorXd solver_output;
+    solver.solve(hqp, solver_output);
+    BOOST_CHECK(fabs(hqp[0].A.row(0).dot(solver_output) - 3) < 1e-6);
+    for(uint i = 0; i < NO_JOINTS; i++){
+        BOOST_CHECK(solver_output(i) <= hqp[0].upper_x(i) + 1e-9);
+        BOOST_CHECK(solver_output(i) >= hqp[0].lower_x(i) - 1e-9);
+    }
+    BOOST_CHECK_EQUAL(solver.getTaskScales()[0], 1);
+
+    // The saturated joint is clamped to its bound
+    BOOST_CHECK(fabs(solver_output(0) - 0.2) < 1e-9);
+
+    // Infeasible: The maximum reachable task value is 3.2
+    hqp[0].lower_y << 5;
+    hqp[0].upper_y = hqp[0].lower_y;
+    solver.solve(hqp, solver_output);
+    for(uint i = 0; i < NO_JOINTS; i++){
+        BOOST_CHECK(solver_output(i) <= hqp[0].upper_x(i) + 1e-9);
+        BOOST_CHECK(solver_output(i) >= hqp[0].lower_x(i) - 1e-9);
+    }
+    const double scale = solver.getTaskScales()[0];
+    BOOST_CHECK(fabs(scale*5 - 3.2) < 1e-6);
+    BOOST_CHECK(fabs(hqp[0].A.row(0).dot(solver_output) - 3.2) < 1e-6);
+
+    // Bounds that are not set (NaN) are ignored
+    hqp[0].lower_x.setConstant(std::numeric_limits<double>::quiet_NaN());
+    hqp[0].upper_x.setConstant(std::numeric_limits<double>::quiet_NaN());
+    solver.solve(hqp, solver_output);
+    BOOST_CHECK(fabs(hqp[0].A.row(0).dot(solver_output) - 5) < 1e-6);
+    BOOST_CHECK_EQUAL(solver.noOfSaturatedJoints(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(solver_sns_hierarchy)
+{
+    /**
+     * Saturating joints on a lower priority must not affect the higher priority tasks
+     */
+
+    srand(42);
+
+    const uint NO_JOINTS = 7;
+    const double LIMIT = 0.5;
+
+    SNSSolver solver;
+    solver.setMaxSolverOutputNorm(1000);
+
+    HierarchicalQP hqp;
+    hqp.resize(2);
+    hqp[0].resize(3, NO_JOINTS);
+    hqp[0].A.setRandom();
+    hqp[0].lower_y.setRandom();
+    hqp[0].lower_y *= 0.1;
+    hqp[0].upper_y = hqp[0].lower_y;
+    hqp[0].lower_x.setConstant(-LIMIT);
+    hqp[0].upper_x.setConstant(LIMIT);
+    hqp[1].resize(NO_JOINTS, NO_JOINTS);
+    hqp[1].A.setIdentity();
+    hqp[1].lower_y.setConstant(10);
+    hqp[1].upper_y = hqp[1].lower_y;
+    hqp[1].lower_x.resize(0);
+    hqp[1].upper_x.resize(0);
+    hqp.Wq.setOnes(NO_JOINTS);
+
+    base::VectorXd solver_output;
+    solver.solve(hqp, solver_output);
+
+    base::VectorXd y = hqp[0].A*solver_output;
+    for(uint i = 0; i < 3; i++)
+        BOOST_CHECK(fabs(y(i) - hqp[0].lower_y(i)) < 1e-6);
+    for(uint i = 0; i < NO_JOINTS; i++){
+        BOOST_CHECK(solver_output(i) <= LIMIT + 1e-9);
+        BOOST_CHECK(solver_output(i) >= -LIMIT - 1e-9);
+    }
+    BOOST_CHECK_EQUAL(solver.getTaskScales()[0], 1);
+    BOOST_CHECK(solver.getTaskScales()[1] > 0 && solver.getTaskScales()[1] < 1);
+}